@@ -0,0 +1,59 @@
+#!/usr/bin/env python3
+# generate an expression-heavy program for benchmarking the parser
+# usage: gen_expr.py [SIZE_KIB] [SEED] > expr.fstep
+
+import random
+import sys
+
+# binary operators of the language
+OPS = ['+', '-', '*', '/', '%', '<', '<=', '==', '!=', '&&', '||']
+
+
+def gen_expr(rng, names, depth):
+  # flat chains of operators, with a few parenthesized sub-expressions
+  terms = []
+  for _ in range(rng.randint(2, 8)):
+    r = rng.random()
+    if depth < 3 and r < 0.15:
+      terms.append('(' + gen_expr(rng, names, depth + 1) + ')')
+    elif r < 0.25:
+      terms.append('-' + rng.choice(names))
+    elif r < 0.6:
+      terms.append(rng.choice(names))
+    else:
+      terms.append(str(rng.randint(0, 1000)))
+  expr = terms[0]
+  for term in terms[1:]:
+    expr += ' ' + rng.choice(OPS) + ' ' + term
+  return expr
+
+
+def gen_func(rng, index):
+  args = ['a', 'b', 'c']
+  lines = ['f%d(a, b, c) {' % index]
+  names = list(args)
+  for i in range(rng.randint(4, 12)):
+    name = 'v%d' % i
+    lines.append('  %s := %s' % (name, gen_expr(rng, names, 0)))
+    names.append(name)
+  lines.append('  return ' + gen_expr(rng, names, 0))
+  lines.append('}')
+  return '\n'.join(lines) + '\n\n'
+
+
+def main():
+  size = int(sys.argv[1]) * 1024 if len(sys.argv) > 1 else 1700 * 1024
+  seed = int(sys.argv[2]) if len(sys.argv) > 2 else 1
+  rng = random.Random(seed)
+  out, total, index = [], 0, 0
+  while total < size:
+    func = gen_func(rng, index)
+    out.append(func)
+    total += len(func)
+    index += 1
+  out.append('main() {\n  return f0(1, 2, 3)\n}\n')
+  sys.stdout.write(''.join(out))
+
+
+if __name__ == '__main__':
+  main()
@@ -0,0 +1,22 @@
+#!/usr/bin/env python3
+# generate input records for benchmarking batch mode and lanes
+# usage: gen_records.py [COUNT] [MIN] [MAX] [SEED] > records.txt
+# every record is an integer in [MIN, MAX], records are uniform if
+# MIN equals MAX, otherwise they take different paths through programs
+
+import random
+import sys
+
+
+def main():
+  count = int(sys.argv[1]) if len(sys.argv) > 1 else 2000
+  lo = int(sys.argv[2]) if len(sys.argv) > 2 else 18
+  hi = int(sys.argv[3]) if len(sys.argv) > 3 else lo
+  seed = int(sys.argv[4]) if len(sys.argv) > 4 else 1
+  rng = random.Random(seed)
+  sys.stdout.write(''.join('%d\n' % rng.randint(lo, hi)
+                           for _ in range(count)))
+
+
+if __name__ == '__main__':
+  main()
@@ -0,0 +1,71 @@
+// example of embedding 'first-step' into another program
+// a program is parsed once, and evaluated concurrently on several
+// threads, every thread has its own evaluator, inputs and outputs
+
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "fstep/fstep.h"
+
+namespace {
+
+constexpr char kSource[] = R"(
+fib(n) {
+  if n <= 2 {
+    return 1
+  }
+  return fib(n - 1) + fib(n - 2)
+}
+
+main() {
+  n := input()
+  print(fib(n))
+  return n
+}
+)";
+
+// print the specific diagnostics
+void PrintDiags(const DiagList &diags) {
+  for (const auto &diag : diags) {
+    std::cerr << "error(" << diag.stage << ")";
+    if (diag.line) std::cerr << " at " << diag.line << ":" << diag.column;
+    std::cerr << ": " << diag.message << std::endl;
+  }
+}
+
+}  // namespace
+
+int main() {
+  // errors are reported with their positions
+  DiagList diags;
+  Program::Parse("main() {\n  return 1 +\n}\n", diags);
+  PrintDiags(diags);
+  // parse the program once
+  diags.clear();
+  auto prog = Program::Parse(kSource, diags);
+  if (!prog) {
+    PrintDiags(diags);
+    return 1;
+  }
+  // evaluate it on 4 threads
+  EvalOptions opts;
+  opts.engine = EvalEngine::VM;
+  std::vector<EvalResult> results(4);
+  std::vector<std::thread> threads;
+  for (std::size_t i = 0; i < results.size(); ++i) {
+    threads.emplace_back([&prog, &opts, &results, i] {
+      Evaluator eval(*prog, opts);
+      results[i] = eval.Eval(std::to_string(20 + i));
+    });
+  }
+  for (auto &thread : threads) thread.join();
+  for (const auto &result : results) {
+    if (result.ret) {
+      std::cout << "fib(" << *result.ret << ") = " << result.output;
+    }
+    PrintDiags(result.diags);
+  }
+  return 0;
+}
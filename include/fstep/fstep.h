@@ -0,0 +1,174 @@
+#ifndef FIRSTSTEP_FSTEP_FSTEP_H_
+#define FIRSTSTEP_FSTEP_FSTEP_H_
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstddef>
+
+// diagnostic message reported by a stage of the compiler
+struct Diagnostic {
+  // name of the stage, e.g. "lexer", "parser", or "interpreter" for
+  // errors of evaluations, which is the same for all engines
+  std::string stage;
+  std::string message;
+  // position in source (starting from 1) of the token that caused
+  // the error, zero if the error is not related to any token,
+  // e.g. errors reported during evaluation
+  std::size_t line, column;
+};
+
+using DiagList = std::vector<Diagnostic>;
+
+// engine for evaluating programs
+// lanes evaluate records of a batch in lockstep, single evaluations
+// with lanes are run by the interpreter
+enum class EvalEngine { AST, VM, JIT, Lanes };
+
+// options of a single evaluation
+struct EvalOptions {
+  // default max depth of calls
+  static constexpr std::size_t kDefaultMaxDepth = 1 << 20;
+
+  // programs that are not supported by the VM are run by the interpreter
+  EvalEngine engine = EvalEngine::AST;
+  // max depth of calls
+  std::size_t max_depth = kDefaultMaxDepth;
+  // max size of memoization table in bytes, disabled if zero
+  std::size_t memo_bytes = 0;
+  // count of threads evaluating operands of pure calls in parallel,
+  // only used by the interpreter, disabled if less than 2
+  std::size_t fork_workers = 0;
+};
+
+// result of a single evaluation
+struct EvalResult {
+  // return value of 'main' function, 'nullopt' if failed
+  std::optional<int> ret;
+  // outputs of 'print'
+  std::string output;
+  // errors reported during evaluation
+  DiagList diags;
+};
+
+// parsed program, which is immutable after parsing
+// a program can be evaluated or compiled any number of times,
+// concurrently from different threads, every evaluation has its own
+// inputs, outputs and diagnostics, and never touches stdin or stdout
+class Program {
+ public:
+  // default max nesting depth of blocks and expressions
+  static constexpr std::size_t kDefaultMaxNesting = 1000;
+
+  ~Program();
+
+  Program(const Program &) = delete;
+  Program &operator=(const Program &) = delete;
+
+  // parse the specific source, errors are appended to 'diags'
+  // returns null if there is any error
+  static std::shared_ptr<const Program> Parse(
+      std::string_view src, DiagList &diags,
+      std::size_t max_depth = kDefaultMaxNesting);
+
+  // evaluate the program, 'input' is read by 'input' function
+  EvalResult Eval(std::string_view input,
+                  const EvalOptions &opts = {}) const;
+  // compile the program to RISC-V assembly, errors are appended
+  // to 'diags', returns false if failed
+  bool Compile(std::string &output, DiagList &diags) const;
+
+  // check if the program can be run in sessions, which requires the VM
+  bool resumable() const;
+
+  // parsed functions and their bytecode, defined in 'lib/program.h'
+  struct Impl;
+
+ private:
+  friend class Evaluator;
+  friend class Session;
+  friend class BatchEvaluator;
+
+  Program();
+
+  std::unique_ptr<Impl> impl_;
+};
+
+// evaluator of a program with the specific options
+// the interpreter or the VM is kept between evaluations, so that
+// compiled code and allocated stacks are reused
+// an evaluator must not be used by multiple threads at the same time,
+// use one evaluator per thread instead
+class Evaluator {
+ public:
+  // the program must outlive the evaluator
+  Evaluator(const Program &prog, const EvalOptions &opts = {});
+  ~Evaluator();
+
+  Evaluator(const Evaluator &) = delete;
+  Evaluator &operator=(const Evaluator &) = delete;
+
+  // evaluate the program, 'input' is read by 'input' function
+  EvalResult Eval(std::string_view input);
+
+ private:
+  // engine of the evaluator
+  struct Impl;
+  std::unique_ptr<Impl> impl_;
+};
+
+// status of a session
+enum class SessionStatus {
+  // 'main' function has returned
+  Finished,
+  // an error has been reported
+  Failed,
+  // 'input' is waiting for more pushed inputs
+  WaitInput,
+  // 'print' is waiting for outputs to be consumed
+  WaitOutput,
+};
+
+// resumable evaluation of a program on the VM, so that one thread can
+// serve many interactive evaluations, inputs are pushed by the caller
+// evaluation suspends at 'input' if there are not enough inputs,
+// or at 'print' if too many outputs have not been consumed
+class Session {
+ public:
+  // the program must outlive the session, and must be resumable
+  Session(const Program &prog, const EvalOptions &opts = {});
+  ~Session();
+
+  Session(const Session &) = delete;
+  Session &operator=(const Session &) = delete;
+
+  // append inputs
+  void PushInput(std::string_view data);
+  // mark the end of inputs
+  void CloseInput();
+  // continue the evaluation until it finishes or suspends
+  SessionStatus Resume();
+
+  // outputs that have not been consumed, the caller should erase
+  // consumed outputs
+  std::string &output() { return output_; }
+  // current status
+  SessionStatus status() const { return status_; }
+  // return value of 'main' function, 'nullopt' if not finished
+  std::optional<int> ret() const;
+  // errors reported during evaluation
+  const DiagList &diags() const { return diags_; }
+
+ private:
+  // the VM and its I/O
+  struct Impl;
+
+  std::string output_;
+  std::unique_ptr<Impl> impl_;
+  SessionStatus status_;
+  DiagList diags_;
+};
+
+#endif  // FIRSTSTEP_FSTEP_FSTEP_H_
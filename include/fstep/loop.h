@@ -0,0 +1,90 @@
+#ifndef FIRSTSTEP_FSTEP_LOOP_H_
+#define FIRSTSTEP_FSTEP_LOOP_H_
+
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+#include "fstep/fstep.h"
+
+// event loop that serves sessions on the current thread
+// every session reads inputs from a file descriptor, and writes outputs
+// to another one, both are switched to non-blocking mode and closed
+// when the session ends
+// only supported on Linux, since sessions are polled by epoll
+class SessionLoop {
+ public:
+  // check if the event loop can be run on the current platform
+  static bool IsSupported();
+
+  // the program must outlive the loop, and must be resumable
+  SessionLoop(const Program &prog, const EvalOptions &opts);
+  ~SessionLoop();
+
+  SessionLoop(const SessionLoop &) = delete;
+  SessionLoop &operator=(const SessionLoop &) = delete;
+
+  // add a new session, returns false if failed
+  bool AddSession(int in_fd, int out_fd);
+  // run until all sessions have ended
+  // 'SIGPIPE' is blocked on the current thread while running,
+  // outputs to closed pipes are dropped
+  void Run();
+
+  // count of resumptions of all sessions
+  std::size_t resume_num() const { return resume_num_; }
+  // count of sessions that have failed
+  std::size_t failed_num() const { return failed_num_; }
+
+ private:
+  // connection of a session
+  struct Conn {
+    std::unique_ptr<Session> session;
+    int in_fd, out_fd;
+    // set if waiting for 'out_fd' to be writable
+    bool wait_writable;
+  };
+
+  // resume the session until it needs more inputs or finishes
+  void Pump(std::size_t id);
+  // read all available inputs
+  void HandleInput(std::size_t id);
+  // write pending outputs, returns false if 'out_fd' is broken
+  bool WriteOutput(Conn &conn);
+  // update events of 'out_fd', or end the session if it is done
+  void UpdateOutput(std::size_t id);
+  // close the input file descriptor
+  void CloseInput(Conn &conn);
+  // close all file descriptors, and free the session
+  void End(std::size_t id);
+
+  const Program &prog_;
+  EvalOptions opts_;
+  int epoll_fd_;
+  std::vector<Conn> conns_;
+  std::size_t alive_num_, resume_num_, failed_num_;
+};
+
+// statistics of a load test
+struct LoadStats {
+  std::size_t session_num, failed_num, mismatch_num, resume_num;
+  // total time in seconds
+  double secs;
+  // latency of every session in nanoseconds, from the first input
+  // to the end of outputs
+  std::vector<std::uint64_t> nanos;
+};
+
+// run a load test, 'session_num' sessions are served by a session loop
+// on another thread, and driven through pipes by the current thread
+// every session is fed with 'input' in chunks of 'chunk_size' bytes,
+// one chunk per session in turn, or all at once if 'chunk_size' is zero
+// outputs are checked against outputs of an evaluation,
+// returns false if failed to set up sessions
+bool RunLoadTest(const Program &prog, const EvalOptions &opts,
+                 std::string_view input, std::size_t session_num,
+                 std::size_t chunk_size, LoadStats &stats);
+
+#endif  // FIRSTSTEP_FSTEP_LOOP_H_
@@ -1,9 +1,10 @@
 #include "back/compiler/irgen.h"
 
 #include <iostream>
+#include <vector>
 
 ValPtr IRGenerator::LogError(std::string_view message) {
-  std::cerr << "error(irgen): " << message << std::endl;
+  reporter_.Report("irgen", message);
   ++error_num_;
   return nullptr;
 }
@@ -14,7 +15,7 @@ xstl::Guard IRGenerator::NewEnvironment() {
 }
 
 void IRGenerator::Dump(std::ostream &os) const {
-  for (const auto &it : funcs_) it.second->Dump(os);
+  for (const auto &func : func_defs_) func->Dump(os);
 }
 
 ValPtr IRGenerator::GenerateOn(const FunDefAST &ast) {
@@ -23,11 +24,13 @@ ValPtr IRGenerator::GenerateOn(const FunDefAST &ast) {
     return LogError("argument count must be less than or equal to 8");
   }
   // create function definition IR
-  func_ = std::make_shared<FunctionDef>(ast.name(), ast.args().size());
+  func_ = std::make_shared<FunctionDef>(
+      std::string(symbols_.GetName(ast.name())), ast.args().size());
   // add to function map
-  if (!funcs_.insert({func_->name(), func_}).second) {
+  if (!funcs_.insert({ast.name(), func_}).second) {
     return LogError("function has already been defined");
   }
+  func_defs_.push_back(func_);
   // enter argument environment
   auto env = NewEnvironment();
   // add definitions of arguments
@@ -77,22 +80,30 @@ ValPtr IRGenerator::GenerateOn(const AssignAST &ast) {
 }
 
 ValPtr IRGenerator::GenerateOn(const IfAST &ast) {
-  // generate condition
-  auto cond = ast.cond()->GenerateIR(*this);
-  if (!cond) return nullptr;
-  // create labels
-  auto false_branch = std::make_shared<LabelVal>();
-  auto end_if = ast.else_then() ? std::make_shared<LabelVal>() : nullptr;
-  // generate contional branch
-  func_->PushInst<BranchInst>(false, std::move(cond), false_branch);
-  // generate the true branch
-  ast.then()->GenerateIR(*this);
-  if (ast.else_then()) func_->PushInst<JumpInst>(end_if);
-  // generate the false branch
-  func_->PushInst<LabelInst>(std::move(false_branch));
-  if (ast.else_then()) {
-    ast.else_then()->GenerateIR(*this);
-    func_->PushInst<LabelInst>(std::move(end_if));
+  // walk through the 'else if' chain
+  std::vector<ValPtr> end_ifs;
+  for (auto if_else = &ast; if_else; if_else = if_else->else_if()) {
+    // generate condition
+    auto cond = if_else->cond()->GenerateIR(*this);
+    if (!cond) return nullptr;
+    // create labels
+    bool has_else = if_else->else_then() || if_else->else_if();
+    auto false_branch = NewLabel();
+    auto end_if = has_else ? NewLabel() : nullptr;
+    // generate contional branch
+    func_->PushInst<BranchInst>(false, std::move(cond), false_branch);
+    // generate the true branch
+    if_else->then()->GenerateIR(*this);
+    if (has_else) func_->PushInst<JumpInst>(end_if);
+    // generate the false branch
+    func_->PushInst<LabelInst>(std::move(false_branch));
+    if (if_else->else_then()) if_else->else_then()->GenerateIR(*this);
+    if (has_else) end_ifs.push_back(std::move(end_if));
+  }
+  // generate end labels, from the innermost 'if' to the outermost one
+  while (!end_ifs.empty()) {
+    func_->PushInst<LabelInst>(std::move(end_ifs.back()));
+    end_ifs.pop_back();
   }
   return nullptr;
 }
@@ -110,7 +121,7 @@ ValPtr IRGenerator::GenerateOn(const BinaryAST &ast) {
   // check if is logical operator
   if (ast.op() == Operator::LAnd || ast.op() == Operator::LOr) {
     // logical AND operation, generate labels
-    auto end_logic = std::make_shared<LabelVal>();
+    auto end_logic = NewLabel();
     // generate lhs first
     auto lhs = ast.lhs()->GenerateIR(*this);
     if (!lhs) return nullptr;
@@ -1,24 +1,30 @@
 #ifndef FIRSTSTEP_BACK_COMPILER_IRGEN_H_
 #define FIRSTSTEP_BACK_COMPILER_IRGEN_H_
 
-#include <ostream>
+#include <iostream>
 #include <string_view>
 #include <unordered_map>
+#include <vector>
 #include <utility>
 #include <cstddef>
 
 #include "define/ir.h"
 #include "define/ast.h"
+#include "define/symbol.h"
+#include "define/error.h"
 
 #include "xstl/guard.h"
 #include "xstl/nested.h"
 
 class IRGenerator {
  public:
-  IRGenerator() : error_num_(0) {
+  IRGenerator(const SymbolTable &symbols)
+      : symbols_(symbols), error_num_(0), label_num_(0) {
     // register all of the library functions
-    lib_funcs_.insert({"input", std::make_shared<FunctionDef>("input", 0)});
-    lib_funcs_.insert({"print", std::make_shared<FunctionDef>("print", 1)});
+    lib_funcs_.insert(
+        {kSymInput, std::make_shared<FunctionDef>("input", 0)});
+    lib_funcs_.insert(
+        {kSymPrint, std::make_shared<FunctionDef>("print", 1)});
   }
 
   // dump RISC-V assembly of all generated IRs
@@ -37,24 +43,41 @@ class IRGenerator {
   ValPtr GenerateOn(const IntAST &ast);
   ValPtr GenerateOn(const IdAST &ast);
 
+  // set the stream for printing error messages
+  void set_err_stream(std::ostream &err) { reporter_.set_err_stream(err); }
+  // set the list for collecting errors, instead of printing them
+  void set_error_list(ErrorList &errors) {
+    reporter_.set_error_list(errors);
+  }
+
   // count of error
   std::size_t error_num() const { return error_num_; }
 
  private:
-  // print error message to stderr
+  // report error message
   ValPtr LogError(std::string_view message);
+  // create a new label, ids of labels are unique in the generator
+  ValPtr NewLabel() { return std::make_shared<LabelVal>(label_num_++); }
   // enter a new environment
   xstl::Guard NewEnvironment();
 
+  // symbol table of all identifiers
+  const SymbolTable &symbols_;
   std::size_t error_num_;
+  // count of created labels
+  std::size_t label_num_;
+  // reporter of error messages
+  ErrorReporter reporter_;
   // current function
   FunDefPtr func_;
   // all defined functions
-  std::unordered_map<std::string_view, FunDefPtr> funcs_;
+  std::unordered_map<SymbolId, FunDefPtr> funcs_;
+  // all defined functions, in order of definition
+  std::vector<FunDefPtr> func_defs_;
   // all predefined library functions
-  std::unordered_map<std::string_view, FunDefPtr> lib_funcs_;
+  std::unordered_map<SymbolId, FunDefPtr> lib_funcs_;
   // all defined variables (stack slots)
-  xstl::NestedMapPtr<std::string_view, ValPtr> vars_;
+  xstl::NestedMapPtr<SymbolId, ValPtr> vars_;
 };
 
 #endif  // FIRSTSTEP_BACK_COMPILER_IRGEN_H_
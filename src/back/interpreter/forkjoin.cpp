@@ -0,0 +1,156 @@
+#include "back/interpreter/forkjoin.h"
+
+#include <deque>
+
+#include "back/interpreter/interpreter.h"
+#include "back/runtime/io.h"
+
+// worker, aligned to cache line to avoid false sharing
+struct alignas(64) ForkJoinPool::Worker {
+  Worker() : intp(nullptr), io(std::string_view(), output) {}
+
+  Interpreter *intp;
+  // interpreter of worker threads
+  std::unique_ptr<Interpreter> owned;
+  // forked expressions are pure, outputs are never written
+  std::string output;
+  RuntimeIO io;
+  // tasks that have not been taken
+  std::mutex mutex;
+  std::deque<ForkTaskPtr> tasks;
+};
+
+ForkJoinPool::ForkJoinPool(Interpreter &intp, std::size_t worker_num)
+    : pending_num_(0), idle_num_(0), stop_(false) {
+  if (!worker_num) worker_num = 1;
+  for (std::size_t i = 0; i < worker_num; ++i) {
+    workers_.push_back(std::make_unique<Worker>());
+    auto &worker = *workers_.back();
+    if (!i) {
+      worker.intp = &intp;
+      continue;
+    }
+    // functions have been resolved by the forker
+    worker.owned = std::make_unique<Interpreter>();
+    worker.intp = worker.owned.get();
+    for (const auto &func : intp.funcs_) {
+      if (func) worker.intp->AddFunctionDef(func);
+    }
+    worker.intp->set_resolved(true);
+    worker.intp->set_max_depth(intp.max_depth_);
+    worker.intp->set_io(worker.io);
+    worker.intp->InitWorker(*this, i, intp.max_fork_level_);
+  }
+  // start worker threads after all workers have been created
+  for (std::size_t i = 1; i < worker_num; ++i) {
+    threads_.emplace_back([this, i] { Run(i); });
+  }
+}
+
+ForkJoinPool::~ForkJoinPool() {
+  stop_ = true;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+  }
+  cv_.notify_all();
+  for (auto &thread : threads_) thread.join();
+}
+
+void ForkJoinPool::Push(std::size_t id, ForkTaskPtr task) {
+  auto &worker = *workers_[id];
+  {
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    worker.tasks.push_back(std::move(task));
+    ++pending_num_;
+  }
+  // wake up an idle worker, locking the mutex makes sure that the worker
+  // is either waiting, or will see the pending task
+  if (idle_num_) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+    }
+    cv_.notify_one();
+  }
+}
+
+bool ForkJoinPool::Pop(std::size_t id, const ForkTask &task) {
+  auto &worker = *workers_[id];
+  std::lock_guard<std::mutex> lock(worker.mutex);
+  // tasks are joined in the reverse order of pushing, so the task
+  // is at the back unless it has been stolen
+  if (worker.tasks.empty() || worker.tasks.back().get() != &task) {
+    return false;
+  }
+  worker.tasks.pop_back();
+  --pending_num_;
+  return true;
+}
+
+bool ForkJoinPool::Join(std::size_t id, ForkTask &task,
+                        const std::atomic<bool> *cancelled) {
+  auto is_cancelled = [cancelled] {
+    return cancelled && cancelled->load(std::memory_order_relaxed);
+  };
+  // help other workers while waiting, until stealing keeps failing
+  for (std::size_t fails = 0; fails < kJoinSpins;) {
+    if (task.done.load(std::memory_order_acquire)) return true;
+    if (is_cancelled()) return false;
+    if (auto stolen = Steal(id)) {
+      RunTask(id, *stolen);
+      fails = 0;
+    }
+    else {
+      ++fails;
+    }
+  }
+  // sleep until the task is done, waking up from time to time to check
+  // if the task of the joiner itself has been cancelled
+  std::unique_lock<std::mutex> lock(task.mutex);
+  while (!task.done.load(std::memory_order_acquire)) {
+    if (is_cancelled()) return false;
+    task.cv.wait_for(lock, kJoinTimeout);
+  }
+  return true;
+}
+
+ForkTaskPtr ForkJoinPool::Steal(std::size_t id) {
+  if (!pending_num_) return nullptr;
+  for (std::size_t i = 1; i < workers_.size(); ++i) {
+    auto &victim = *workers_[(id + i) % workers_.size()];
+    std::lock_guard<std::mutex> lock(victim.mutex);
+    if (victim.tasks.empty()) continue;
+    auto task = std::move(victim.tasks.front());
+    victim.tasks.pop_front();
+    --pending_num_;
+    return task;
+  }
+  return nullptr;
+}
+
+void ForkJoinPool::RunTask(std::size_t id, ForkTask &task) {
+  // cancelled tasks are never started
+  if (!task.cancelled.load(std::memory_order_relaxed)) {
+    workers_[id]->intp->RunTask(task);
+  }
+  {
+    std::lock_guard<std::mutex> lock(task.mutex);
+    task.done.store(true, std::memory_order_release);
+  }
+  task.cv.notify_all();
+}
+
+void ForkJoinPool::Run(std::size_t id) {
+  // the native stack of this thread is used first
+  workers_[id]->intp->native_stack_.Reset();
+  while (!stop_) {
+    if (auto task = Steal(id)) {
+      RunTask(id, *task);
+      continue;
+    }
+    // sleep until tasks are pushed
+    std::unique_lock<std::mutex> lock(mutex_);
+    ++idle_num_;
+    cv_.wait(lock, [this] { return pending_num_ || stop_; });
+    --idle_num_;
+  }
+}
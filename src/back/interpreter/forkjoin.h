@@ -0,0 +1,99 @@
+#ifndef FIRSTSTEP_BACK_INTERPRETER_FORKJOIN_H_
+#define FIRSTSTEP_BACK_INTERPRETER_FORKJOIN_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstddef>
+
+#include "define/ast.h"
+#include "define/error.h"
+
+// task of evaluating a forked expression
+// the expression is evaluated in a copy of the frame of its forker,
+// errors are buffered and reported by the forker after joining
+// tasks are shared by the forker and the pool, so that a cancelled task
+// can be left to the worker that runs it
+struct ForkTask {
+  ForkTask(const BaseAST *expr, const int *frame, std::size_t size,
+           std::size_t depth, std::size_t level)
+      : expr(expr), frame(frame, frame + size), depth(depth),
+        level(level), error_num(0), peak_depth(0), done(false),
+        cancelled(false) {}
+
+  const BaseAST *expr;
+  std::vector<int> frame;
+  // depth of calls and level of forks of the forker
+  std::size_t depth, level;
+  // results, written by the worker that runs the task
+  std::optional<int> ret;
+  ErrorList errors;
+  std::size_t error_num, peak_depth;
+  std::atomic<bool> done;
+  // set if the result is no longer needed, the worker stops at the next
+  // call, or never starts the task
+  std::atomic<bool> cancelled;
+  // joiners sleep until the task is done
+  std::mutex mutex;
+  std::condition_variable cv;
+};
+
+using ForkTaskPtr = std::shared_ptr<ForkTask>;
+
+// work-stealing scheduler of forked expressions
+// every worker owns an interpreter and a deque of tasks, owners push and
+// pop tasks at the back, idle workers steal the oldest (and usually the
+// largest) tasks from the front of other deques
+// worker 0 is the interpreter that creates the pool, other workers run
+// on their own threads until the pool is destructed
+class ForkJoinPool {
+ public:
+  // count of failed steals before a joiner sleeps
+  static constexpr std::size_t kJoinSpins = 64;
+  // max time of sleeping joiners between checks of cancellation
+  static constexpr std::chrono::milliseconds kJoinTimeout{1};
+
+  ForkJoinPool(Interpreter &intp, std::size_t worker_num);
+  ~ForkJoinPool();
+
+  ForkJoinPool(const ForkJoinPool &) = delete;
+  ForkJoinPool &operator=(const ForkJoinPool &) = delete;
+
+  // push a task to the deque of the specific worker
+  void Push(std::size_t id, ForkTaskPtr task);
+  // take back the last pushed task, returns false if it has been stolen
+  bool Pop(std::size_t id, const ForkTask &task);
+  // run other tasks until the specific stolen task is done, then sleep
+  // until it is done, returns false if 'cancelled' has been set
+  bool Join(std::size_t id, ForkTask &task,
+            const std::atomic<bool> *cancelled);
+
+  // count of workers
+  std::size_t worker_num() const { return workers_.size(); }
+
+ private:
+  struct Worker;
+
+  // steal a task from other workers, returns null if there is no task
+  ForkTaskPtr Steal(std::size_t id);
+  // run the specific task on the interpreter of the specific worker
+  void RunTask(std::size_t id, ForkTask &task);
+  // main loop of worker threads
+  void Run(std::size_t id);
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::vector<std::thread> threads_;
+  // idle workers sleep until tasks are pushed
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::atomic<std::size_t> pending_num_, idle_num_;
+  std::atomic<bool> stop_;
+};
+
+#endif  // FIRSTSTEP_BACK_INTERPRETER_FORKJOIN_H_
@@ -1,10 +1,16 @@
 #include "back/interpreter/interpreter.h"
 
+#include "back/resolver/resolver.h"
+
 #include <iostream>
+#include <algorithm>
+#include <utility>
 #include <cassert>
 
 std::optional<int> Interpreter::LogError(std::string_view message) {
-  std::cerr << "error(interpreter): " << message << std::endl;
+  // keep the order of outputs and errors
+  io_->Flush();
+  reporter_.Report(kRuntimeStage, message);
   ++error_num_;
   return {};
 }
@@ -14,56 +20,316 @@ xstl::Guard Interpreter::NewEnvironment() {
   return xstl::Guard([this] { envs_ = envs_->outer(); });
 }
 
-std::optional<int> Interpreter::CallLibFunction(std::string_view name,
-                                                const ASTPtrList &args) {
-  if (name == "input") {
-    // check arguments
-    if (!args.empty()) return LogError("argument count mismatch");
+void Interpreter::GrowFrame(std::size_t size) {
+  frame_top_ += size;
+  if (frame_top_ > peak_frame_top_) {
+    peak_frame_top_ = frame_top_;
+    if (stack_.size() < frame_top_) {
+      stack_.resize(std::max(stack_.size() * 2, frame_top_));
+    }
+  }
+}
+
+std::optional<int> Interpreter::CallLibFunction(const FunCallAST &ast) {
+  if (ast.target() == CallTarget::Input) {
     // read an integer from stdin
-    int ret;
-    std::cin >> ret;
-    return ret;
+    return io_->ReadInt();
   }
-  else if (name == "print") {
-    // check arguments
-    if (args.size() != 1) return LogError("argument count mismatch");
+  else {
+    assert(ast.target() == CallTarget::Print && "not a library call");
     // evaluate argument
-    auto arg = args[0]->Eval(*this);
+    auto arg = ast.args()[0]->Eval(*this);
     if (!arg) return {};
     // print to stdout
-    std::cout << *arg << std::endl;
+    io_->WriteInt(*arg);
     return 0;
   }
-  else {
-    // not a library function call
-    return {};
-  }
 }
 
 bool Interpreter::AddFunctionDef(ASTPtr func) {
   // get function name
   read_func_name_ = true;
+  func_name_.reset();
   func->Eval(*this);
-  assert(!func_name_.empty() && "not a function");
+  assert(func_name_ && "not a function");
   read_func_name_ = false;
   // check redefinition
-  if (funcs_.count(func_name_)) {
+  if (*func_name_ >= funcs_.size()) funcs_.resize(*func_name_ + 1);
+  auto &slot = funcs_[*func_name_];
+  if (slot) {
     LogError("function has already been defined");
     return false;
   }
-  // add to function map
-  funcs_.insert({func_name_, std::move(func)});
+  // add to function map, calls must be linked again
+  slot = std::move(func);
+  is_resolved_ = false;
   return true;
 }
 
 std::optional<int> Interpreter::Eval() {
+  // errors of the last evaluation do not stop this one
+  error_num_ = 0;
+  returned_ = false;
   // find the 'main' function
-  auto it = funcs_.find("main");
-  if (it == funcs_.end()) return LogError("'main' function not found");
-  // initialize the root environment
-  envs_ = xstl::MakeNestedMap<std::string_view, std::optional<int>>();
+  if (kSymMain >= funcs_.size() || !funcs_[kSymMain]) {
+    return LogError("'main' function not found");
+  }
+  // the native stack of the current thread is used first
+  native_stack_.Reset();
+  depth_ = peak_depth_ = peak_frame_top_ = 0;
+  // link all function calls,
+  // and try to resolve all variables to slots of frames
+  if (!is_resolved_) {
+    Resolver resolver;
+    use_frames_ = resolver.Resolve(funcs_);
+    is_resolved_ = true;
+    // compiled code and workers refer to the last resolved functions
+    jit_.reset();
+    fork_.reset();
+  }
+  if (use_frames_) {
+    // initialize the frame of 'main' function
+    auto main = static_cast<const FunDefAST *>(funcs_[kSymMain]);
+    frame_base_ = 0;
+    frame_top_ = main->frame_size();
+    peak_frame_top_ = frame_top_;
+    stack_.resize(frame_top_);
+    // memoization requires frames, since results of functions
+    // may depend on the environment of callers
+    if (memo_bytes_) {
+      memo_.emplace(memo_bytes_);
+    }
+    else {
+      memo_.reset();
+    }
+    // forked operands are evaluated by interpreters of other threads,
+    // which share neither memoization table nor profiler
+    // the pool is kept for later evaluations, like compiled code
+    if (fork_workers_ > 1 && !memo_ && !profile_) {
+      // workers get the max level when the pool is created
+      max_fork_level_ = kExtraForkLevels;
+      for (auto n = fork_workers_; n > 1; n = (n + 1) / 2) {
+        ++max_fork_level_;
+      }
+      if (!fork_) fork_.emplace(*this, fork_workers_);
+      pool_ = &*fork_;
+      worker_id_ = fork_level_ = 0;
+    }
+    else {
+      fork_.reset();
+    }
+    // memoization and profiling need to observe every call,
+    // which compiled code does not do, neither does it fork
+    // compiled code is kept for later evaluations
+    if (!use_jit_ || memo_ || profile_ || fork_) {
+      jit_.reset();
+    }
+    else if (!jit_ && JIT::IsSupported()) {
+      jit_.emplace(*this, funcs_.size());
+    }
+  }
+  else {
+    // initialize the root environment
+    envs_ = xstl::MakeNestedMap<SymbolId, std::optional<int>>();
+  }
   // evaluate 'main' function
-  return it->second->Eval(*this);
+  if (profile_) profiler_.emplace();
+  auto ret = funcs_[kSymMain]->Eval(*this);
+  if (profiler_) profiler_->Stop();
+  // workers sleep until the next evaluation
+  pool_ = nullptr;
+  return ret;
+}
+
+std::optional<int> Interpreter::Call(const FunDefAST &def,
+                                     const int *args, std::size_t depth) {
+  assert(is_resolved_ && use_frames_ && "functions not resolved");
+  error_num_ = 0;
+  returned_ = false;
+  native_stack_.Reset();
+  depth_ = peak_depth_ = depth;
+  frame_base_ = frame_top_ = 0;
+  if (depth_ >= max_depth_) return LogError("call stack overflow");
+  ++depth_;
+  auto ret = CallWithArgs(def, args);
+  --depth_;
+  return ret;
+}
+
+std::optional<int> Interpreter::CallWithFrame(const FunCallAST &ast) {
+  const auto &def = *ast.callee();
+  // allocate frame of callee on the top of stack
+  auto base = frame_top_;
+  GrowFrame(def.frame_size());
+  // evaluate arguments in the frame of caller
+  for (std::size_t i = 0; i < ast.args().size(); ++i) {
+    auto arg = ast.args()[i]->Eval(*this);
+    if (!arg) {
+      frame_top_ = base;
+      return {};
+    }
+    stack_[base + i] = *arg;
+  }
+  // look up memoized result of pure function, arguments are copied
+  // since they may be modified by callee
+  bool memoizable = memo_ && memo_->IsMemoizable(def);
+  int args[MemoTable::kMaxArgs];
+  if (memoizable) {
+    std::copy_n(stack_.begin() + base, def.args().size(), args);
+    auto ret = memo_->LookUp(def, args);
+    if (ret) {
+      frame_top_ = base;
+      return ret;
+    }
+  }
+  // call the specific function
+  auto last_base = frame_base_;
+  frame_base_ = base;
+  auto ret = def.Eval(*this);
+  frame_base_ = last_base;
+  frame_top_ = base;
+  if (memoizable && ret && !error_num_) {
+    memo_->Insert(def, args, *ret);
+  }
+  return ret;
+}
+
+std::optional<int> Interpreter::CallWithArgs(const FunDefAST &def,
+                                             const int *args) {
+  // allocate frame of callee on the top of stack
+  auto base = frame_top_;
+  GrowFrame(def.frame_size());
+  std::copy_n(args, def.args().size(), stack_.begin() + base);
+  // call the specific function
+  auto last_base = frame_base_;
+  frame_base_ = base;
+  auto ret = def.Eval(*this);
+  frame_base_ = last_base;
+  frame_top_ = base;
+  return ret;
+}
+
+std::optional<int> Interpreter::TailCall(const FunCallAST &ast) {
+  const auto &def = *ast.callee();
+  // evaluate arguments on the top of stack
+  auto top = frame_top_;
+  GrowFrame(ast.args().size());
+  for (std::size_t i = 0; i < ast.args().size(); ++i) {
+    auto arg = ast.args()[i]->Eval(*this);
+    if (!arg) return {};
+    stack_[top + i] = *arg;
+  }
+  // replace the current frame with the frame of callee
+  std::copy_n(stack_.begin() + top, ast.args().size(),
+              stack_.begin() + frame_base_);
+  frame_top_ = frame_base_;
+  GrowFrame(def.frame_size());
+  // exit the current function, and let the caller evaluate callee
+  tail_callee_ = &def;
+  returned_ = true;
+  return {};
+}
+
+std::optional<int> Interpreter::EvalBinary(const BinaryAST &ast, int lhs,
+                                           int rhs) {
+  // operations are performed on unsigned integers, so that overflow
+  // wraps around without undefined behavior
+  auto l = static_cast<unsigned>(lhs), r = static_cast<unsigned>(rhs);
+  switch (ast.op()) {
+    case Operator::Add: return static_cast<int>(l + r);
+    case Operator::Sub: return static_cast<int>(l - r);
+    case Operator::Mul: return static_cast<int>(l * r);
+    case Operator::Div: case Operator::Mod: {
+      // 'INT_MIN / -1' wraps around like other operators
+      if (!rhs) return LogError("division by zero");
+      if (rhs == -1) {
+        return ast.op() == Operator::Div ? static_cast<int>(0u - lhs) : 0;
+      }
+      return ast.op() == Operator::Div ? lhs / rhs : lhs % rhs;
+    }
+    case Operator::Less: return lhs < rhs;
+    case Operator::LessEq: return lhs <= rhs;
+    case Operator::Eq: return lhs == rhs;
+    case Operator::NotEq: return lhs != rhs;
+    default: assert(false && "unknown binary operator");
+  }
+  return {};
+}
+
+bool Interpreter::ForkOperands(const BinaryAST &ast,
+                               std::optional<int> &lhs,
+                               std::optional<int> &rhs) {
+  // fork rhs with a copy of the current frame, and evaluate lhs
+  auto task = std::make_shared<ForkTask>(
+      ast.rhs(), stack_.data() + frame_base_, frame_top_ - frame_base_,
+      depth_, fork_level_ + 1);
+  pool_->Push(worker_id_, task);
+  ++fork_level_;
+  lhs = ast.lhs()->Eval(*this);
+  if (pool_->Pop(worker_id_, *task)) {
+    // evaluate rhs here if it has not been stolen
+    if (lhs) rhs = ast.rhs()->Eval(*this);
+  }
+  else if (!lhs || !pool_->Join(worker_id_, *task, cancelled_)) {
+    // rhs is not needed if lhs has failed, just like the sequential
+    // evaluation, or if the task of this interpreter has been cancelled
+    // the task is left to its worker, which may not terminate otherwise
+    task->cancelled.store(true, std::memory_order_relaxed);
+  }
+  else {
+    rhs = task->ret;
+    if (task->peak_depth > peak_depth_) peak_depth_ = task->peak_depth;
+    if (task->error_num) {
+      io_->Flush();
+      for (const auto &error : task->errors) reporter_.Report(error);
+      error_num_ += task->error_num;
+    }
+  }
+  --fork_level_;
+  return lhs && rhs;
+}
+
+void Interpreter::InitWorker(ForkJoinPool &pool, std::size_t id,
+                             std::size_t max_fork_level) {
+  use_frames_ = true;
+  frame_base_ = frame_top_ = 0;
+  depth_ = 0;
+  pool_ = &pool;
+  worker_id_ = id;
+  fork_level_ = 0;
+  max_fork_level_ = max_fork_level;
+}
+
+void Interpreter::RunTask(ForkTask &task) {
+  // the task may be run while this interpreter is joining another task,
+  // so the state of the current evaluation is saved
+  auto last_base = frame_base_, last_top = frame_top_;
+  auto last_depth = depth_, last_peak = peak_depth_;
+  auto last_level = fork_level_, last_error_num = error_num_;
+  auto last_reporter = reporter_;
+  auto last_cancelled = cancelled_;
+  // evaluate in a copy of the frame of forker
+  frame_base_ = frame_top_;
+  GrowFrame(task.frame.size());
+  std::copy(task.frame.begin(), task.frame.end(),
+            stack_.begin() + frame_base_);
+  depth_ = peak_depth_ = task.depth;
+  fork_level_ = task.level;
+  error_num_ = 0;
+  reporter_.set_error_list(task.errors);
+  cancelled_ = &task.cancelled;
+  task.ret = task.expr->Eval(*this);
+  task.error_num = error_num_;
+  task.peak_depth = peak_depth_;
+  // restore the state
+  frame_base_ = last_base;
+  frame_top_ = last_top;
+  depth_ = last_depth;
+  peak_depth_ = last_peak;
+  fork_level_ = last_level;
+  error_num_ = last_error_num;
+  reporter_ = last_reporter;
+  cancelled_ = last_cancelled;
 }
 
 std::optional<int> Interpreter::EvalOn(const FunDefAST &ast) {
@@ -72,28 +338,71 @@ std::optional<int> Interpreter::EvalOn(const FunDefAST &ast) {
     func_name_ = ast.name();
     return {};
   }
+  else if (use_frames_) {
+    // frame has been set up by caller
+    auto last_ret = ret_val_;
+    // evaluate function body, then bodies of tail calls in the same frame
+    // tail calls are profiled as calls made by the caller of 'ast'
+    for (auto func = &ast; func; func = std::exchange(tail_callee_, {})) {
+      // cancelled tasks stop at calls and tail calls, errors of
+      // cancelled tasks are never reported
+      if (IsCancelled()) {
+        tail_callee_ = nullptr;
+        ret_val_ = last_ret;
+        return LogError("evaluation cancelled");
+      }
+      if (profiler_) profiler_->EnterFunction(func->name());
+      ret_val_.reset();
+      if (auto code = jit_ ? jit_->GetCode(*func) : nullptr) {
+        // compiled code handles its tail calls
+        ret_val_ = jit_->Run(code, stack_.data() + frame_base_,
+                             func->args().size());
+        tail_callee_ = nullptr;
+      }
+      else {
+        func->body()->Eval(*this);
+        returned_ = false;
+      }
+      if (profiler_) profiler_->ExitFunction();
+    }
+    // get & check return value
+    auto ret_val = ret_val_;
+    ret_val_ = last_ret;
+    // do not report again if the body has failed
+    if (!ret_val && !error_num_) {
+      return LogError("function has no return value");
+    }
+    return ret_val;
+  }
   else {
     // set up return value
     auto succ = envs_->AddItem(kRetVal, {});
     assert(succ && "environment corrupted");
     static_cast<void>(succ);
     // evaluate function body
+    if (profiler_) profiler_->EnterFunction(ast.name());
     ast.body()->Eval(*this);
+    returned_ = false;
+    if (profiler_) profiler_->ExitFunction();
     // get & check return value
     auto ret_val = envs_->GetItem(kRetVal, false);
-    if (!ret_val) return LogError("function has no return value");
+    // do not report again if the body has failed
+    if (!ret_val && !error_num_) {
+      return LogError("function has no return value");
+    }
     return ret_val;
   }
 }
 
 std::optional<int> Interpreter::EvalOn(const BlockAST &ast) {
-  // enter a new environment
-  auto env = NewEnvironment();
+  // enter a new environment, blocks need nothing with frames
+  auto env = use_frames_ ? xstl::Guard([] {}) : NewEnvironment();
   // evaluate all statements in block
   for (const auto &stmt : ast.stmts()) {
+    if (profiler_) profiler_->CountStatement();
     stmt->Eval(*this);
-    // stop if there is an error
-    if (error_num_) return {};
+    // stop if there is an error, or the function has returned
+    if (error_num_ || returned_) return {};
   }
   return {};
 }
@@ -102,6 +411,10 @@ std::optional<int> Interpreter::EvalOn(const DefineAST &ast) {
   // evaluate the expression
   auto expr = ast.expr()->Eval(*this);
   if (!expr) return {};
+  if (use_frames_) {
+    stack_[frame_base_ + ast.slot()] = *expr;
+    return {};
+  }
   // update the current environment
   if (!envs_->AddItem(ast.name(), expr)) {
     return LogError("symbol has already been defined");
@@ -113,6 +426,10 @@ std::optional<int> Interpreter::EvalOn(const AssignAST &ast) {
   // evaluate the expression
   auto expr = ast.expr()->Eval(*this);
   if (!expr) return {};
+  if (use_frames_) {
+    stack_[frame_base_ + ast.slot()] = *expr;
+    return {};
+  }
   // update value of the symbol
   auto envs = envs_;
   bool succ = false;
@@ -132,24 +449,39 @@ std::optional<int> Interpreter::EvalOn(const AssignAST &ast) {
 }
 
 std::optional<int> Interpreter::EvalOn(const IfAST &ast) {
-  // evaluate the condition
-  auto cond = ast.cond()->Eval(*this);
-  if (!cond) return {};
-  if (*cond) {
-    // evaluate the true branch
-    ast.then()->Eval(*this);
-  }
-  else if (ast.else_then()) {
-    // evaluate the false branch
-    ast.else_then()->Eval(*this);
+  // walk through the 'else if' chain
+  for (auto if_else = &ast; if_else; if_else = if_else->else_if()) {
+    // evaluate the condition
+    auto cond = if_else->cond()->Eval(*this);
+    if (!cond) return {};
+    if (profiler_) profiler_->CountBranch(if_else->index(), *cond);
+    if (*cond) {
+      // evaluate the true branch
+      if_else->then()->Eval(*this);
+      break;
+    }
+    else if (if_else->else_then()) {
+      // evaluate the false branch
+      if_else->else_then()->Eval(*this);
+      break;
+    }
   }
   return {};
 }
 
 std::optional<int> Interpreter::EvalOn(const ReturnAST &ast) {
+  // handle tail call, which is never memoized, so that deep recursion
+  // runs in constant stack space
+  if (use_frames_ && ast.tail_call()) return TailCall(*ast.tail_call());
   // evaluate the return value
   auto expr = ast.expr()->Eval(*this);
   if (!expr) return {};
+  // exit the current function
+  returned_ = true;
+  if (use_frames_) {
+    ret_val_ = expr;
+    return {};
+  }
   // update the current return value
   auto succ = envs_->UpdateItem(kRetVal, expr);
   assert(succ && "environment corrupted");
@@ -169,24 +501,19 @@ std::optional<int> Interpreter::EvalOn(const BinaryAST &ast) {
     // then evaluate rhs
     return ast.rhs()->Eval(*this);
   }
+  else if (pool_ && ast.is_forkable() && fork_level_ < max_fork_level_) {
+    // evaluate operands in parallel
+    std::optional<int> lhs, rhs;
+    if (!ForkOperands(ast, lhs, rhs)) return {};
+    return EvalBinary(ast, *lhs, *rhs);
+  }
   else {
-    // evaluate the lhs & rhs
-    auto lhs = ast.lhs()->Eval(*this), rhs = ast.rhs()->Eval(*this);
-    if (!lhs || !rhs) return {};
-    // perform binary operation
-    switch (ast.op()) {
-      case Operator::Add: return *lhs + *rhs;
-      case Operator::Sub: return *lhs - *rhs;
-      case Operator::Mul: return *lhs * *rhs;
-      case Operator::Div: return *lhs / *rhs;
-      case Operator::Mod: return *lhs % *rhs;
-      case Operator::Less: return *lhs < *rhs;
-      case Operator::LessEq: return *lhs <= *rhs;
-      case Operator::Eq: return *lhs == *rhs;
-      case Operator::NotEq: return *lhs != *rhs;
-      default: assert(false && "unknown binary operator");
-    }
-    return {};
+    // evaluate the lhs & rhs, stop at the first error
+    auto lhs = ast.lhs()->Eval(*this);
+    if (!lhs) return {};
+    auto rhs = ast.rhs()->Eval(*this);
+    if (!rhs) return {};
+    return EvalBinary(ast, *lhs, *rhs);
   }
 }
 
@@ -196,7 +523,7 @@ std::optional<int> Interpreter::EvalOn(const UnaryAST &ast) {
   if (!opr) return {};
   // perform unary operation
   switch (ast.op()) {
-    case Operator::Sub: return -*opr;
+    case Operator::Sub: return static_cast<int>(0u - *opr);
     case Operator::LNot: return !*opr;
     default: assert(false && "unknown unary operator");
   }
@@ -204,19 +531,40 @@ std::optional<int> Interpreter::EvalOn(const UnaryAST &ast) {
 }
 
 std::optional<int> Interpreter::EvalOn(const FunCallAST &ast) {
-  // handle library function call
-  auto ret = CallLibFunction(ast.name(), ast.args());
-  if (error_num_ || ret) return ret;
-  // find the specific function
-  auto it = funcs_.find(ast.name());
-  if (it == funcs_.end()) return LogError("function not found");
+  // dispatch by the target linked by resolver
+  switch (ast.target()) {
+    case CallTarget::Function: break;
+    case CallTarget::Input: case CallTarget::Print:
+      return CallLibFunction(ast);
+    case CallTarget::ArgCountMismatch:
+      return LogError("argument count mismatch");
+    default: return LogError("function not found");
+  }
+  if (depth_ >= max_depth_) return LogError("call stack overflow");
+  // continue on a new stack segment if the native stack is exhausted
+  if (native_stack_.IsLow()) {
+    std::optional<int> ret;
+    auto call = [this, &ast, &ret] { ret = CallFunction(ast); };
+    if (!native_stack_.RunOnNewSegment(call)) {
+      return LogError("native stack overflow");
+    }
+    return ret;
+  }
+  return CallFunction(ast);
+}
+
+std::optional<int> Interpreter::CallFunction(const FunCallAST &ast) {
+  if (++depth_ > peak_depth_) peak_depth_ = depth_;
+  auto ret = use_frames_ ? CallWithFrame(ast) : CallWithEnvironment(ast);
+  --depth_;
+  return ret;
+}
+
+std::optional<int> Interpreter::CallWithEnvironment(const FunCallAST &ast) {
   // make a new environment for arguments
   auto env = NewEnvironment();
   // evaluate arguments
-  const auto &func_args = static_cast<FunDefAST *>(it->second.get())->args();
-  if (ast.args().size() != func_args.size()) {
-    return LogError("argument count mismatch");
-  }
+  const auto &func_args = ast.callee()->args();
   for (std::size_t i = 0; i < func_args.size(); ++i) {
     // evaluate the current argument
     auto arg = ast.args()[i]->Eval(*this);
@@ -227,7 +575,7 @@ std::optional<int> Interpreter::EvalOn(const FunCallAST &ast) {
     }
   }
   // call the specific function
-  return it->second->Eval(*this);
+  return ast.callee()->Eval(*this);
 }
 
 std::optional<int> Interpreter::EvalOn(const IntAST &ast) {
@@ -235,6 +583,7 @@ std::optional<int> Interpreter::EvalOn(const IntAST &ast) {
 }
 
 std::optional<int> Interpreter::EvalOn(const IdAST &ast) {
+  if (use_frames_) return stack_[frame_base_ + ast.slot()];
   // find in the current environment
   auto val = envs_->GetItem(ast.id());
   if (!val) return LogError("symbol has not been defined");
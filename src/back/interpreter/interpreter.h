@@ -1,26 +1,60 @@
 #ifndef FIRSTSTEP_BACK_INTERPRETER_INTERPRETER_H_
 #define FIRSTSTEP_BACK_INTERPRETER_INTERPRETER_H_
 
+#include <iostream>
+#include <atomic>
 #include <optional>
 #include <string_view>
-#include <unordered_map>
+#include <vector>
+#include <limits>
 #include <cstddef>
 
 #include "define/ast.h"
+#include "define/symbol.h"
+#include "define/error.h"
+#include "back/interpreter/memo.h"
+#include "back/interpreter/stack.h"
+#include "back/interpreter/profiler.h"
+#include "back/interpreter/forkjoin.h"
+#include "back/runtime/io.h"
+#include "back/jit/jit.h"
 
 #include "xstl/nested.h"
 #include "xstl/guard.h"
 
 class Interpreter {
  public:
-  Interpreter() : error_num_(0) {}
+  // default max depth of calls
+  static constexpr std::size_t kDefaultMaxDepth = 1 << 20;
+  // levels of nested forks beyond the binary logarithm of the count of
+  // workers, so that every worker gets about 16 tasks of a balanced
+  // recursion, deeper expressions are evaluated sequentially
+  static constexpr std::size_t kExtraForkLevels = 4;
+
+  Interpreter()
+      : error_num_(0), returned_(false), is_resolved_(false),
+        use_frames_(false),
+        tail_callee_(nullptr), max_depth_(kDefaultMaxDepth), depth_(0),
+        peak_depth_(0), peak_frame_top_(0), memo_bytes_(0),
+        profile_(false), use_jit_(false), fork_workers_(0),
+        pool_(nullptr), worker_id_(0), fork_level_(0),
+        max_fork_level_(0), cancelled_(nullptr), io_(&GetStdIO()) {}
 
   // add the specific function definition to interpreter
   // returns false if failed
   bool AddFunctionDef(ASTPtr func);
   // evaluate the current program
+  // variables are stored in frames if they can be resolved lexically,
+  // otherwise they are stored in nested environments
+  // can be called repeatedly, compiled code is kept between evaluations
   // returns return value of 'main' function, or 'nullopt' if failed
   std::optional<int> Eval();
+  // call the specific function with the specific arguments, as if the
+  // call was made at the specific depth, used by other evaluators
+  // functions must have been resolved to frames
+  // returns return value of the function, or 'nullopt' if failed
+  std::optional<int> Call(const FunDefAST &def, const int *args,
+                          std::size_t depth);
 
   // visitor methods
   std::optional<int> EvalOn(const FunDefAST &ast);
@@ -35,30 +69,152 @@ class Interpreter {
   std::optional<int> EvalOn(const IntAST &ast);
   std::optional<int> EvalOn(const IdAST &ast);
 
+  // mark all added functions as resolved by 'Resolver' outside, with
+  // the result of resolution, evaluation never modifies resolved
+  // functions, so they can be shared by interpreters in other threads
+  void set_resolved(bool use_frames) {
+    is_resolved_ = true;
+    use_frames_ = use_frames;
+    fork_.reset();
+  }
+  // set max depth of calls
+  void set_max_depth(std::size_t max_depth) {
+    max_depth_ = max_depth;
+    fork_.reset();
+  }
+  // enable memoization of pure functions, with the specific max size
+  // of the memoization table, disabled if zero
+  void set_memo_bytes(std::size_t memo_bytes) { memo_bytes_ = memo_bytes; }
+  // enable profiling of calls and branches
+  void set_profile(bool profile) { profile_ = profile; }
+  // enable compiling hot functions to machine code
+  void set_jit(bool use_jit) { use_jit_ = use_jit; }
+  // enable evaluating operands of forkable expressions in parallel
+  // on the specific count of workers, disabled if less than 2
+  void set_fork_workers(std::size_t fork_workers) {
+    fork_workers_ = fork_workers;
+    fork_.reset();
+  }
+  // set I/O of library functions, stdin and stdout by default
+  void set_io(RuntimeIO &io) { io_ = &io; }
+  // set the stream for printing error messages
+  void set_err_stream(std::ostream &err) { reporter_.set_err_stream(err); }
+  // set the list for collecting errors, instead of printing them
+  void set_error_list(ErrorList &errors) {
+    reporter_.set_error_list(errors);
+  }
+
   // count of error
   std::size_t error_num() const { return error_num_; }
+  // peak depth of calls
+  std::size_t peak_depth() const { return peak_depth_; }
+  // peak bytes of frames and heap-allocated native stack segments
+  std::size_t peak_stack_bytes() const {
+    return peak_frame_top_ * sizeof(int) + native_stack_.peak_bytes();
+  }
+  // memoization table, 'nullopt' if memoization is not enabled
+  const std::optional<MemoTable> &memo() const { return memo_; }
+  // profiler, 'nullopt' if profiling is not enabled
+  const std::optional<Profiler> &profiler() const { return profiler_; }
 
  private:
-  // name of return value
-  static constexpr const char *kRetVal = "$ret";
+  // compiled code calls back into interpreter
+  friend class JIT;
+  // workers of fork-join pool are interpreters
+  friend class ForkJoinPool;
+
+  // name of return value, never produced by symbol table
+  static constexpr SymbolId kRetVal =
+      std::numeric_limits<SymbolId>::max();
 
-  // print error message to stderr
+  // report error message
   std::optional<int> LogError(std::string_view message);
   // enter a new environment
   xstl::Guard NewEnvironment();
   // perform library function call
-  std::optional<int> CallLibFunction(std::string_view name,
-                                     const ASTPtrList &args);
+  std::optional<int> CallLibFunction(const FunCallAST &ast);
+  // grow the current frame by the specific count of slots
+  void GrowFrame(std::size_t size);
+  // call the linked function, and update depth of calls
+  std::optional<int> CallFunction(const FunCallAST &ast);
+  // call the linked function, with arguments stored in environment
+  std::optional<int> CallWithEnvironment(const FunCallAST &ast);
+  // call the linked function, with arguments stored in frame
+  std::optional<int> CallWithFrame(const FunCallAST &ast);
+  // call the specific function with evaluated arguments,
+  // used by compiled code
+  std::optional<int> CallWithArgs(const FunDefAST &def, const int *args);
+  // call the linked function in tail position, reuses the current frame
+  std::optional<int> TailCall(const FunCallAST &ast);
+  // perform the binary operation of the specific expression
+  std::optional<int> EvalBinary(const BinaryAST &ast, int lhs, int rhs);
+  // evaluate operands of the specific expression in parallel,
+  // returns false if any of them has failed
+  bool ForkOperands(const BinaryAST &ast, std::optional<int> &lhs,
+                    std::optional<int> &rhs);
+  // set up the interpreter as a worker of fork-join pool
+  void InitWorker(ForkJoinPool &pool, std::size_t id,
+                  std::size_t max_fork_level);
+  // evaluate the specific forked task on the top of stack,
+  // errors are collected in the task
+  void RunTask(ForkTask &task);
+  // check if the forked task being evaluated has been cancelled
+  bool IsCancelled() const {
+    return cancelled_ && cancelled_->load(std::memory_order_relaxed);
+  }
 
   std::size_t error_num_;
+  // set if a 'return' statement has been evaluated,
+  // remaining statements of the current function will be skipped
+  bool returned_;
   // read function name only, but not evaluate the function
   bool read_func_name_;
   // name of the current function
-  std::string_view func_name_;
-  // all function definitions
-  std::unordered_map<std::string_view, ASTPtr> funcs_;
+  std::optional<SymbolId> func_name_;
+  // all function definitions, indexed by symbol id
+  std::vector<ASTPtr> funcs_;
+  // set if all function definitions have been resolved
+  bool is_resolved_;
   // environments
-  xstl::NestedMapPtr<std::string_view, std::optional<int>> envs_;
+  xstl::NestedMapPtr<SymbolId, std::optional<int>> envs_;
+  // set if variables are stored in frames
+  bool use_frames_;
+  // frames of all functions, and the frame of the current function
+  std::vector<int> stack_;
+  std::size_t frame_base_, frame_top_;
+  // return value of the current function, used with frames
+  std::optional<int> ret_val_;
+  // function to be evaluated in the current frame after returning
+  const FunDefAST *tail_callee_;
+  // max depth, current depth and peak depth of calls
+  std::size_t max_depth_, depth_, peak_depth_;
+  // peak top of frames
+  std::size_t peak_frame_top_;
+  // native stack for recursive evaluation
+  SegmentedStack native_stack_;
+  // max size and memoization table of pure function calls
+  std::size_t memo_bytes_;
+  std::optional<MemoTable> memo_;
+  // profiler of calls and branches
+  bool profile_;
+  std::optional<Profiler> profiler_;
+  // compiler of hot functions
+  bool use_jit_;
+  std::optional<JIT> jit_;
+  // fork-join pool owned by this interpreter, and the pool this
+  // interpreter works in, which is null if forking is disabled
+  std::size_t fork_workers_;
+  std::optional<ForkJoinPool> fork_;
+  ForkJoinPool *pool_;
+  // id in the pool, current level and max level of nested forks
+  std::size_t worker_id_, fork_level_, max_fork_level_;
+  // cancellation flag of the forked task being evaluated, null if
+  // not evaluating a task
+  const std::atomic<bool> *cancelled_;
+  // I/O of library functions
+  RuntimeIO *io_;
+  // reporter of error messages
+  ErrorReporter reporter_;
 };
 
 #endif  // FIRSTSTEP_BACK_INTERPRETER_INTERPRETER_H_
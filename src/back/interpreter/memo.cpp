@@ -0,0 +1,104 @@
+#include "back/interpreter/memo.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+// hash of function and its arguments
+std::uint64_t HashCall(const void *func, const int *args) {
+  std::uint64_t hash = reinterpret_cast<std::uintptr_t>(func);
+  for (std::size_t i = 0; i < MemoTable::kMaxArgs; ++i) {
+    hash = (hash ^ static_cast<std::uint32_t>(args[i])) *
+           0x9e3779b97f4a7c15ull;
+  }
+  return hash ^ (hash >> 32);
+}
+
+}  // namespace
+
+MemoTable::MemoTable(std::size_t max_bytes)
+    : size_(0), hits_(0), misses_(0), evictions_(0) {
+  // get the max count of buckets, which must be a power of 2
+  max_buckets_ = 0;
+  if (max_bytes >= sizeof(Bucket)) {
+    max_buckets_ = 1;
+    while (max_buckets_ * 2 * sizeof(Bucket) <= max_bytes) {
+      max_buckets_ *= 2;
+    }
+  }
+  buckets_.resize(std::min(kInitBuckets, max_buckets_));
+}
+
+MemoTable::Bucket &MemoTable::GetBucket(const FunDefAST &func,
+                                        const int *args) {
+  auto hash = HashCall(&func, args);
+  return buckets_[hash & (buckets_.size() - 1)];
+}
+
+std::optional<int> MemoTable::LookUp(const FunDefAST &func,
+                                     const int *args) {
+  // make the key, unused arguments are zero
+  int key[kMaxArgs] = {};
+  std::memcpy(key, args, sizeof(int) * func.args().size());
+  // find in bucket
+  for (const auto &entry : GetBucket(func, key).entries) {
+    if (entry.func == &func &&
+        !std::memcmp(entry.args, key, sizeof(key))) {
+      ++hits_;
+      return entry.ret;
+    }
+  }
+  ++misses_;
+  return {};
+}
+
+void MemoTable::Insert(const FunDefAST &func, const int *args, int ret) {
+  Entry entry = {&func, {}, ret};
+  std::memcpy(entry.args, args, sizeof(int) * func.args().size());
+  // grow if the table is too full, or the bucket is full and
+  // the table is not too sparse
+  auto capacity = buckets_.size() * kBucketSize;
+  if (buckets_.size() < max_buckets_ &&
+      (size_ >= capacity * 3 / 4 ||
+       (size_ >= capacity / 2 &&
+        GetBucket(func, entry.args).entries[kBucketSize - 1].func))) {
+    Grow();
+  }
+  InsertEntry(entry);
+}
+
+void MemoTable::InsertEntry(const Entry &entry) {
+  auto &entries = GetBucket(*entry.func, entry.args).entries;
+  // update the existing entry
+  for (auto &e : entries) {
+    if (e.func == entry.func &&
+        !std::memcmp(e.args, entry.args, sizeof(e.args))) {
+      e.ret = entry.ret;
+      return;
+    }
+  }
+  // entries are ordered from newest to oldest,
+  // evict the oldest one if the bucket is full
+  if (entries[kBucketSize - 1].func) {
+    ++evictions_;
+  }
+  else {
+    ++size_;
+  }
+  for (auto i = kBucketSize - 1; i > 0; --i) entries[i] = entries[i - 1];
+  entries[0] = entry;
+}
+
+void MemoTable::Grow() {
+  std::vector<Bucket> buckets(buckets_.size() * 2);
+  buckets.swap(buckets_);
+  size_ = 0;
+  for (const auto &bucket : buckets) {
+    // insert from oldest to newest, to keep the order of entries
+    for (auto i = kBucketSize; i > 0; --i) {
+      const auto &entry = bucket.entries[i - 1];
+      if (entry.func) InsertEntry(entry);
+    }
+  }
+}
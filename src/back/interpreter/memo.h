@@ -0,0 +1,70 @@
+#ifndef FIRSTSTEP_BACK_INTERPRETER_MEMO_H_
+#define FIRSTSTEP_BACK_INTERPRETER_MEMO_H_
+
+#include <optional>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "define/ast.h"
+
+// bounded table of return values of pure function calls,
+// keyed by function and argument tuple
+// entries are grouped into buckets of one cache line, the table grows
+// until it reaches the memory limit, then a full bucket evicts its
+// oldest entry
+class MemoTable {
+ public:
+  // max count of arguments of memoized calls
+  static constexpr std::size_t kMaxArgs = 5;
+
+  MemoTable(std::size_t max_bytes);
+
+  // check if calls of the specific function can be memoized
+  bool IsMemoizable(const FunDefAST &func) const {
+    return func.is_pure() && func.args().size() <= kMaxArgs &&
+           !buckets_.empty();
+  }
+
+  // look up the return value of the specific call
+  std::optional<int> LookUp(const FunDefAST &func, const int *args);
+  // insert the return value of the specific call
+  void Insert(const FunDefAST &func, const int *args, int ret);
+
+  // statistics
+  std::uint64_t hits() const { return hits_; }
+  std::uint64_t misses() const { return misses_; }
+  std::uint64_t evictions() const { return evictions_; }
+  std::size_t size() const { return size_; }
+  std::size_t bytes() const { return buckets_.size() * sizeof(Bucket); }
+
+ private:
+  // entry of a call, 'func' is null if the entry is empty
+  struct Entry {
+    const FunDefAST *func;
+    int args[kMaxArgs];
+    int ret;
+  };
+
+  // count of entries in a bucket
+  static constexpr std::size_t kBucketSize = 2;
+  // initial count of buckets
+  static constexpr std::size_t kInitBuckets = 1024;
+
+  struct alignas(64) Bucket {
+    Entry entries[kBucketSize];
+  };
+
+  // get the bucket of the specific call
+  Bucket &GetBucket(const FunDefAST &func, const int *args);
+  // insert an entry without growing the table
+  void InsertEntry(const Entry &entry);
+  // double the count of buckets, and reinsert all entries
+  void Grow();
+
+  std::size_t max_buckets_, size_;
+  std::vector<Bucket> buckets_;
+  std::uint64_t hits_, misses_, evictions_;
+};
+
+#endif  // FIRSTSTEP_BACK_INTERPRETER_MEMO_H_
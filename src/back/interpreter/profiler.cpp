@@ -0,0 +1,204 @@
+#include "back/interpreter/profiler.h"
+
+#include <string>
+#include <algorithm>
+#include <limits>
+#include <iomanip>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define FIRSTSTEP_USE_ITIMER
+#include <csignal>
+#include <sys/time.h>
+#endif
+
+namespace {
+
+// function of the root node, never produced by symbol table
+constexpr SymbolId kRootFunc = std::numeric_limits<SymbolId>::max();
+
+#ifdef FIRSTSTEP_USE_ITIMER
+// signal action before profiling
+struct sigaction last_action;
+#endif
+
+}  // namespace
+
+std::atomic<std::uint32_t> Profiler::pending_samples_;
+
+Profiler::Profiler()
+    : cur_(0), stmt_num_(0), is_running_(true), total_secs_(0),
+      secs_per_sample_(0) {
+  nodes_.push_back({kRootFunc, 0, 0, 0, 0, 0, 0});
+  pending_samples_ = 0;
+  start_time_ = Clock::now();
+#ifdef FIRSTSTEP_USE_ITIMER
+  // install signal handler, interrupted system calls are restarted
+  struct sigaction action = {};
+  action.sa_handler = HandleSample;
+  action.sa_flags = SA_RESTART;
+  sigemptyset(&action.sa_mask);
+  sigaction(SIGALRM, &action, &last_action);
+  // start the timer of wall time
+  itimerval timer = {};
+  timer.it_interval.tv_usec = kSampleInterval;
+  timer.it_value.tv_usec = kSampleInterval;
+  setitimer(ITIMER_REAL, &timer, nullptr);
+#endif
+}
+
+void Profiler::HandleSample(int) {
+  pending_samples_.fetch_add(1, std::memory_order_relaxed);
+}
+
+std::uint32_t Profiler::NewNode(SymbolId func) {
+  std::uint32_t node = nodes_.size();
+  nodes_.push_back({func, cur_, 0, nodes_[cur_].first_child, 0, 0, 0});
+  nodes_[cur_].first_child = node;
+  if (func >= branches_.size()) branches_.resize(func + 1);
+  return node;
+}
+
+std::vector<std::uint64_t> Profiler::GetInclSamples() const {
+  // children are always created after their parents
+  std::vector<std::uint64_t> samples(nodes_.size());
+  for (auto i = nodes_.size() - 1; i > 0; --i) {
+    samples[i] += nodes_[i].samples;
+    samples[nodes_[i].parent] += samples[i];
+  }
+  samples[0] += nodes_[0].samples;
+  return samples;
+}
+
+template <typename Enter, typename Exit>
+void Profiler::Walk(Enter enter, Exit exit) const {
+  auto node = nodes_[0].first_child;
+  std::size_t depth = 1;
+  while (node) {
+    if (enter(node, depth) && nodes_[node].first_child) {
+      node = nodes_[node].first_child;
+      ++depth;
+      continue;
+    }
+    // exit the node and its ancestors until a sibling is found
+    for (;;) {
+      exit(node);
+      if (nodes_[node].next_sibling) {
+        node = nodes_[node].next_sibling;
+        break;
+      }
+      node = nodes_[node].parent;
+      --depth;
+      if (!node) break;
+    }
+  }
+}
+
+void Profiler::Stop() {
+  if (!is_running_) return;
+  is_running_ = false;
+#ifdef FIRSTSTEP_USE_ITIMER
+  itimerval timer = {};
+  setitimer(ITIMER_REAL, &timer, nullptr);
+  sigaction(SIGALRM, &last_action, nullptr);
+#endif
+  TakeSamples();
+  // scale samples to wall time
+  std::chrono::duration<double> secs = Clock::now() - start_time_;
+  total_secs_ = secs.count();
+  std::uint64_t samples = 0;
+  for (const auto &node : nodes_) samples += node.samples;
+  secs_per_sample_ = samples ? total_secs_ / samples : 0;
+}
+
+void Profiler::WriteReport(std::ostream &os,
+                           const SymbolTable &symbols) const {
+  // collect statistics of functions, time of recursive calls are
+  // counted only once in inclusive time
+  struct Stats {
+    SymbolId func;
+    std::uint64_t calls, stmts, incl_samples, self_samples;
+  };
+  auto incl = GetInclSamples();
+  std::vector<Stats> stats(branches_.size());
+  std::vector<std::size_t> active(branches_.size());
+  Walk(
+      [&](std::uint32_t node, std::size_t) {
+        const auto &n = nodes_[node];
+        auto &s = stats[n.func];
+        s.func = n.func;
+        s.calls += n.calls;
+        s.stmts += n.stmts;
+        s.self_samples += n.samples;
+        if (!active[n.func]++) s.incl_samples += incl[node];
+        return true;
+      },
+      [&](std::uint32_t node) { --active[nodes_[node].func]; });
+  stats.erase(std::remove_if(stats.begin(), stats.end(),
+                             [](const Stats &s) { return !s.calls; }),
+              stats.end());
+  std::stable_sort(stats.begin(), stats.end(),
+                   [](const Stats &l, const Stats &r) {
+                     return l.self_samples > r.self_samples;
+                   });
+  // print functions
+  auto print_time = [&](std::uint64_t samples) {
+    auto secs = ToSecs(samples);
+    os << std::setw(11) << std::setprecision(6) << secs << " s "
+       << std::setw(6) << std::setprecision(1)
+       << (total_secs_ ? secs / total_secs_ * 100 : 0) << '%';
+  };
+  os << std::fixed << std::setprecision(6);
+  os << "profile: " << total_secs_ << " s, " << stmt_num_
+     << " statements" << std::endl;
+  os << std::setw(12) << "calls" << std::setw(12) << "statements"
+     << std::setw(21) << "inclusive" << std::setw(21) << "exclusive"
+     << "  function" << std::endl;
+  for (const auto &s : stats) {
+    os << std::setw(12) << s.calls << std::setw(12) << s.stmts;
+    print_time(s.incl_samples);
+    print_time(s.self_samples);
+    os << "  " << symbols.GetName(s.func) << std::endl;
+  }
+  // print branches, named by function and index of branch
+  os << std::setw(12) << "taken" << std::setw(12) << "not taken"
+     << "  branch" << std::endl;
+  for (const auto &s : stats) {
+    const auto &branches = branches_[s.func];
+    for (std::size_t i = 0; i < branches.size(); ++i) {
+      os << std::setw(12) << branches[i].taken << std::setw(12)
+         << branches[i].not_taken << "  " << symbols.GetName(s.func)
+         << '#' << i << std::endl;
+    }
+  }
+  os << std::defaultfloat << std::setprecision(6);
+}
+
+void Profiler::WriteCollapsed(std::ostream &os,
+                              const SymbolTable &symbols) const {
+  auto incl = GetInclSamples();
+  // path of the current node, and lengths of paths of its ancestors
+  std::string path;
+  std::vector<std::size_t> lens;
+  auto print_stack = [&](std::uint64_t samples) {
+    auto us = static_cast<std::uint64_t>(ToSecs(samples) * 1e6);
+    if (us) os << path << ' ' << us << '\n';
+  };
+  Walk(
+      [&](std::uint32_t node, std::size_t depth) {
+        lens.push_back(path.size());
+        if (depth > 1) path += ';';
+        path += symbols.GetName(nodes_[node].func);
+        // merge deeper frames into the current node
+        if (depth >= kMaxStackDepth) {
+          print_stack(incl[node]);
+          return false;
+        }
+        print_stack(nodes_[node].samples);
+        return true;
+      },
+      [&](std::uint32_t) {
+        path.resize(lens.back());
+        lens.pop_back();
+      });
+  os.flush();
+}
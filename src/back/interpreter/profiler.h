@@ -0,0 +1,130 @@
+#ifndef FIRSTSTEP_BACK_INTERPRETER_PROFILER_H_
+#define FIRSTSTEP_BACK_INTERPRETER_PROFILER_H_
+
+#include <ostream>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+
+#include "define/symbol.h"
+
+// profiler of interpreted programs
+// records calls and executed statements of every path in the call
+// tree, and counts of taken/not-taken branches of every function
+// wall time is sampled by a timer signal, samples are charged to the
+// current path when entering or exiting functions, and scaled to the
+// wall time of the whole run, so that calls stay cheap
+// only one profiler can be running at the same time
+class Profiler {
+ public:
+  // interval of sampling in microseconds
+  static constexpr long kSampleInterval = 250;
+  // max depth of stacks in collapsed-stack file, deeper frames are
+  // merged into their ancestor at this depth
+  static constexpr std::size_t kMaxStackDepth = 512;
+
+  // start profiling
+  Profiler();
+  ~Profiler() { Stop(); }
+
+  Profiler(const Profiler &) = delete;
+  Profiler &operator=(const Profiler &) = delete;
+
+  // enter the specific function, called by the current function
+  void EnterFunction(SymbolId func) {
+    TakeSamples();
+    auto child = nodes_[cur_].first_child;
+    while (child && nodes_[child].func != func) {
+      child = nodes_[child].next_sibling;
+    }
+    if (!child) child = NewNode(func);
+    ++nodes_[child].calls;
+    cur_ = child;
+  }
+  // exit the current function
+  void ExitFunction() {
+    TakeSamples();
+    cur_ = nodes_[cur_].parent;
+  }
+  // count an executed statement of the current function
+  void CountStatement() {
+    ++nodes_[cur_].stmts;
+    ++stmt_num_;
+  }
+  // count a branch of the current function
+  void CountBranch(std::uint32_t index, bool taken) {
+    auto &branches = branches_[nodes_[cur_].func];
+    if (index >= branches.size()) branches.resize(index + 1);
+    ++(taken ? branches[index].taken : branches[index].not_taken);
+  }
+  // stop profiling, does nothing if already stopped
+  void Stop();
+
+  // write a text report, functions are sorted by exclusive time
+  void WriteReport(std::ostream &os, const SymbolTable &symbols) const;
+  // write collapsed stacks, with exclusive time in microseconds
+  // the file can be consumed by flamegraph tools
+  void WriteCollapsed(std::ostream &os, const SymbolTable &symbols) const;
+
+  // count of all executed statements
+  std::uint64_t stmt_num() const { return stmt_num_; }
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  // node of call tree, the root node has index zero
+  struct Node {
+    SymbolId func;
+    std::uint32_t parent, first_child, next_sibling;
+    // count of calls, samples taken and statements executed in the
+    // node itself
+    std::uint64_t calls, samples, stmts;
+  };
+
+  // counts of a branch
+  struct Branch {
+    std::uint64_t taken, not_taken;
+  };
+
+  // handler of timer signal
+  static void HandleSample(int);
+  // charge pending samples to the current node
+  void TakeSamples() {
+    if (pending_samples_.load(std::memory_order_relaxed)) {
+      nodes_[cur_].samples +=
+          pending_samples_.exchange(0, std::memory_order_relaxed);
+    }
+  }
+  // add a child node of the current node
+  std::uint32_t NewNode(SymbolId func);
+  // get inclusive samples of all nodes
+  std::vector<std::uint64_t> GetInclSamples() const;
+  // walk through the call tree in pre-order, 'enter' returns false if
+  // children of the node should be skipped
+  template <typename Enter, typename Exit>
+  void Walk(Enter enter, Exit exit) const;
+  // convert samples to seconds
+  double ToSecs(std::uint64_t samples) const {
+    return samples * secs_per_sample_;
+  }
+
+  // samples taken by signal handler but not charged to any node
+  static std::atomic<std::uint32_t> pending_samples_;
+
+  // call tree, and the current node
+  std::vector<Node> nodes_;
+  std::uint32_t cur_;
+  // counts of branches, indexed by function and index of branch
+  std::vector<std::vector<Branch>> branches_;
+  // count of all executed statements
+  std::uint64_t stmt_num_;
+  // set if the profiler is running
+  bool is_running_;
+  // start time and total wall time of profiling
+  Clock::time_point start_time_;
+  double total_secs_, secs_per_sample_;
+};
+
+#endif  // FIRSTSTEP_BACK_INTERPRETER_PROFILER_H_
@@ -0,0 +1,109 @@
+#include "back/interpreter/stack.h"
+
+#include <algorithm>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define FIRSTSTEP_USE_UCONTEXT
+#include <ucontext.h>
+#endif
+
+#if defined(__linux__)
+#include <pthread.h>
+#endif
+
+namespace {
+
+// assumed stack size of thread if it can not be queried, which is
+// the default size of main threads on most platforms
+constexpr std::size_t kDefaultStackSize = 8 << 20;
+static_assert(kDefaultStackSize > SegmentedStack::kReservedSize,
+              "default stack size is smaller than the reserved space");
+
+// function to be run on the new segment
+struct Task {
+  void (*func)(void *);
+  void *arg;
+};
+
+thread_local Task cur_task;
+
+// limit of the current thread's stack, zero if not queried yet
+// querying is slow on some platforms, e.g. reading '/proc' on Linux
+thread_local std::uintptr_t thread_limit;
+
+#ifdef FIRSTSTEP_USE_UCONTEXT
+// entry of segments
+void Trampoline() {
+  auto task = cur_task;
+  task.func(task.arg);
+}
+#endif
+
+}  // namespace
+
+struct SegmentedStack::Segment {
+  std::unique_ptr<char[]> mem;
+#ifdef FIRSTSTEP_USE_UCONTEXT
+  ucontext_t context;
+#endif
+};
+
+SegmentedStack::SegmentedStack() : depth_(0) { Reset(); }
+
+SegmentedStack::~SegmentedStack() = default;
+
+void SegmentedStack::Reset() {
+  if (thread_limit) {
+    limit_ = thread_limit;
+    return;
+  }
+  char probe;
+#if defined(__linux__)
+  // get the exact bounds of the current thread's stack
+  pthread_attr_t attr;
+  if (!pthread_getattr_np(pthread_self(), &attr)) {
+    void *addr;
+    std::size_t size;
+    auto ret = pthread_attr_getstack(&attr, &addr, &size);
+    pthread_attr_destroy(&attr);
+    if (!ret) {
+      // stacks smaller than the reserved space are never used by
+      // evaluations, which always run on new segments
+      limit_ = reinterpret_cast<std::uintptr_t>(addr) +
+               std::min(size, kReservedSize);
+      thread_limit = limit_;
+      return;
+    }
+  }
+#endif
+  limit_ = reinterpret_cast<std::uintptr_t>(&probe) -
+           (kDefaultStackSize - kReservedSize);
+  thread_limit = limit_;
+}
+
+bool SegmentedStack::RunOnNewSegment(void (*func)(void *), void *arg) {
+#ifdef FIRSTSTEP_USE_UCONTEXT
+  // get a free segment, memory of segments is committed lazily
+  if (depth_ == segments_.size()) {
+    segments_.push_back(std::make_unique<Segment>());
+    segments_.back()->mem.reset(new char[kSegmentSize]);
+  }
+  auto &seg = *segments_[depth_++];
+  // switch to the segment, and switch back after the function returns
+  ucontext_t caller;
+  getcontext(&seg.context);
+  seg.context.uc_stack.ss_sp = seg.mem.get();
+  seg.context.uc_stack.ss_size = kSegmentSize;
+  seg.context.uc_link = &caller;
+  makecontext(&seg.context, Trampoline, 0);
+  cur_task = {func, arg};
+  auto last_limit = limit_;
+  limit_ = reinterpret_cast<std::uintptr_t>(seg.mem.get()) + kReservedSize;
+  swapcontext(&caller, &seg.context);
+  limit_ = last_limit;
+  --depth_;
+  return true;
+#else
+  return false;
+#endif
+}
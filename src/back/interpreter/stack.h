@@ -0,0 +1,66 @@
+#ifndef FIRSTSTEP_BACK_INTERPRETER_STACK_H_
+#define FIRSTSTEP_BACK_INTERPRETER_STACK_H_
+
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// growable native stack for the recursive evaluation of interpreter
+// when the current stack is about to be exhausted, the evaluation
+// continues on a new heap-allocated segment, so the recursion depth
+// is limited by memory instead of the stack size of thread
+class SegmentedStack {
+ public:
+  // size of heap-allocated segments, which are committed lazily
+  static constexpr std::size_t kSegmentSize = 8 << 20;
+  // max nesting levels of ASTs, which must not be less than
+  // 'Parser::kMaxDepthLimit', and native stack used per level by
+  // walkers that never check for exhaustion, like operators of the
+  // interpreter and the compiler of JIT
+  static constexpr std::size_t kMaxLevels = 10000, kLevelSize = 256;
+  // space reserved at the end of every segment, the interpreter checks
+  // it at every call, so it must hold the deepest walk of one function
+  static constexpr std::size_t kReservedSize =
+      kMaxLevels * kLevelSize + (64 << 10);
+
+  SegmentedStack();
+  ~SegmentedStack();
+
+  SegmentedStack(const SegmentedStack &) = delete;
+  SegmentedStack &operator=(const SegmentedStack &) = delete;
+
+  // use the stack of the current thread as the first segment
+  void Reset();
+
+  // check if the current segment is about to be exhausted
+  bool IsLow() const {
+    char probe;
+    return reinterpret_cast<std::uintptr_t>(&probe) < limit_;
+  }
+
+  // run the specific function on a new segment
+  // returns false if segments are not supported on the current platform
+  template <typename Func>
+  bool RunOnNewSegment(Func &func) {
+    return RunOnNewSegment(
+        [](void *func) { (*static_cast<Func *>(func))(); }, &func);
+  }
+  bool RunOnNewSegment(void (*func)(void *), void *arg);
+
+  // lowest address allowed in the current segment
+  std::uintptr_t limit() const { return limit_; }
+  // peak bytes of heap-allocated segments
+  std::size_t peak_bytes() const { return segments_.size() * kSegmentSize; }
+
+ private:
+  struct Segment;
+
+  // lowest address allowed in the current segment
+  std::uintptr_t limit_;
+  // all allocated segments, and count of segments in use
+  std::vector<std::unique_ptr<Segment>> segments_;
+  std::size_t depth_;
+};
+
+#endif  // FIRSTSTEP_BACK_INTERPRETER_STACK_H_
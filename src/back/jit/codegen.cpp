@@ -0,0 +1,420 @@
+#include "back/jit/codegen.h"
+
+#include <limits>
+#include <cstddef>
+#include <cassert>
+
+namespace {
+
+// registers of arguments, the first argument is the runtime state
+constexpr X86Reg kArgRegs[JIT::kMaxArgs] = {
+    X86Reg::RSI, X86Reg::RDX, X86Reg::RCX, X86Reg::R8, X86Reg::R9,
+};
+
+// offsets of fields of runtime state
+constexpr std::int32_t kDepth = offsetof(JITState, depth);
+constexpr std::int32_t kMaxDepth = offsetof(JITState, max_depth);
+constexpr std::int32_t kPeakDepth = offsetof(JITState, peak_depth);
+constexpr std::int32_t kStackLimit = offsetof(JITState, stack_limit);
+constexpr std::int32_t kCallee = offsetof(JITState, callee);
+constexpr std::int32_t kFailed = offsetof(JITState, failed);
+
+// offset of saved RBX relative to RBP
+constexpr std::int32_t kSavedRbx = -8;
+
+// address of the specific function
+template <typename Func>
+std::uintptr_t GetAddr(Func *func) {
+  return reinterpret_cast<std::uintptr_t>(func);
+}
+
+}  // namespace
+
+bool NativeGen::Generate(const FunDefAST &func) {
+  asm_.Clear();
+  fail_jumps_.clear();
+  temp_num_ = 0;
+  return func.GenerateNative(*this);
+}
+
+std::int32_t NativeGen::GetSlotDisp(Slot slot) {
+  return kSavedRbx - 4 - static_cast<std::int32_t>(slot) * 4;
+}
+
+bool NativeGen::GenerateOperand(const BaseAST &ast) {
+  return ast.GenerateNative(*this);
+}
+
+bool NativeGen::GenerateExpr(const BaseAST &ast) {
+  if (!ast.GenerateNative(*this)) return false;
+  switch (opr_.kind) {
+    case Operand::Kind::Imm: asm_.MovImm32(X86Reg::RAX, opr_.val); break;
+    case Operand::Kind::Slot: {
+      asm_.Load32(X86Reg::RAX, X86Reg::RBP, opr_.val);
+      break;
+    }
+    default: assert(opr_.kind == Operand::Kind::Eax); break;
+  }
+  opr_.kind = Operand::Kind::Eax;
+  return true;
+}
+
+bool NativeGen::GenerateArgs(const FunCallAST &ast) {
+  const auto &args = ast.args();
+  if (args.size() > JIT::kMaxArgs) return false;
+  for (const auto &arg : args) {
+    if (!GenerateExpr(*arg)) return false;
+    PushTemp();
+  }
+  for (auto i = args.size(); i > 0; --i) PopTemp(kArgRegs[i - 1]);
+  return true;
+}
+
+void NativeGen::GenerateAlu(X86AluOp op) {
+  switch (opr_.kind) {
+    case Operand::Kind::Ecx: {
+      asm_.Alu32(op, X86Reg::RAX, X86Reg::RCX);
+      break;
+    }
+    case Operand::Kind::Imm: asm_.Alu32(op, X86Reg::RAX, opr_.val); break;
+    case Operand::Kind::Slot: {
+      asm_.Alu32(op, X86Reg::RAX, X86Reg::RBP, opr_.val);
+      break;
+    }
+    default: assert(false && "invalid operand");
+  }
+}
+
+void NativeGen::GenerateBinary(Operator op) {
+  switch (op) {
+    case Operator::Add: GenerateAlu(X86AluOp::Add); break;
+    case Operator::Sub: GenerateAlu(X86AluOp::Sub); break;
+    case Operator::Mul: {
+      if (opr_.kind == Operand::Kind::Ecx) {
+        asm_.Imul32(X86Reg::RAX, X86Reg::RCX);
+      }
+      else if (opr_.kind == Operand::Kind::Imm) {
+        asm_.Imul32Imm(X86Reg::RAX, X86Reg::RAX, opr_.val);
+      }
+      else {
+        asm_.Imul32(X86Reg::RAX, X86Reg::RBP, opr_.val);
+      }
+      break;
+    }
+    case Operator::Div: case Operator::Mod: {
+      GenerateDivision(op == Operator::Mod);
+      break;
+    }
+    case Operator::Less: case Operator::LessEq:
+    case Operator::Eq: case Operator::NotEq: {
+      GenerateAlu(X86AluOp::Cmp);
+      asm_.SetEax(op == Operator::Less     ? X86Cond::L
+                  : op == Operator::LessEq ? X86Cond::LE
+                  : op == Operator::Eq     ? X86Cond::E
+                                           : X86Cond::NE);
+      break;
+    }
+    default: assert(false && "unknown binary operator");
+  }
+}
+
+void NativeGen::GenerateDivision(bool is_mod) {
+  // divisors are checked at compile time if they are constants
+  bool is_imm = opr_.kind == Operand::Kind::Imm;
+  if (is_imm && opr_.val != 0 && opr_.val != -1) {
+    asm_.MovImm32(X86Reg::RCX, opr_.val);
+    asm_.Cdq();
+    asm_.Idiv32(X86Reg::RCX);
+    if (is_mod) asm_.Mov32(X86Reg::RAX, X86Reg::RDX);
+    return;
+  }
+  // divisor must be in a register
+  if (is_imm) {
+    asm_.MovImm32(X86Reg::RCX, opr_.val);
+  }
+  else if (opr_.kind == Operand::Kind::Slot) {
+    asm_.Load32(X86Reg::RCX, X86Reg::RBP, opr_.val);
+  }
+  // report division by zero
+  asm_.Alu32(X86AluOp::Test, X86Reg::RCX, X86Reg::RCX);
+  auto non_zero = asm_.Jcc(X86Cond::NE);
+  asm_.Mov64(X86Reg::RDI, X86Reg::RBX);
+  CallAddr(GetAddr(JIT::DivisionByZero));
+  fail_jumps_.push_back(asm_.Jmp());
+  asm_.PatchHere(non_zero);
+  // 'INT_MIN / -1' wraps around instead of trapping
+  asm_.Alu32(X86AluOp::Cmp, X86Reg::RCX, -1);
+  auto not_neg_one = asm_.Jcc(X86Cond::NE);
+  if (is_mod) {
+    asm_.Alu32(X86AluOp::Xor, X86Reg::RAX, X86Reg::RAX);
+  }
+  else {
+    asm_.Neg32(X86Reg::RAX);
+  }
+  auto end = asm_.Jmp();
+  asm_.PatchHere(not_neg_one);
+  asm_.Cdq();
+  asm_.Idiv32(X86Reg::RCX);
+  if (is_mod) asm_.Mov32(X86Reg::RAX, X86Reg::RDX);
+  asm_.PatchHere(end);
+}
+
+void NativeGen::PushTemp() {
+  asm_.Push(X86Reg::RAX);
+  ++temp_num_;
+}
+
+void NativeGen::PopTemp(X86Reg reg) {
+  asm_.Pop(reg);
+  --temp_num_;
+}
+
+void NativeGen::CallAddr(std::uintptr_t addr) {
+  asm_.MovImm64(X86Reg::RAX, addr);
+  CallReg(X86Reg::RAX);
+}
+
+void NativeGen::CallReg(X86Reg reg) {
+  // the stack is aligned to 16 bytes if there is no temporary
+  bool align = temp_num_ % 2;
+  if (align) asm_.Alu64(X86AluOp::Sub, X86Reg::RSP, 8);
+  asm_.Call(reg);
+  if (align) asm_.Alu64(X86AluOp::Add, X86Reg::RSP, 8);
+}
+
+void NativeGen::GenerateEpilogue() {
+  asm_.Load64(X86Reg::RBX, X86Reg::RBP, kSavedRbx);
+  asm_.Leave();
+  asm_.Ret();
+}
+
+void NativeGen::CheckFailed() {
+  asm_.CmpZero8(X86Reg::RBX, kFailed);
+  fail_jumps_.push_back(asm_.Jcc(X86Cond::NE));
+}
+
+bool NativeGen::GenerateOn(const FunDefAST &ast) {
+  func_ = &ast;
+  if (ast.args().size() > JIT::kMaxArgs) return false;
+  if (ast.frame_size() > (1u << 24)) return false;
+  // set up frame, the stack is aligned to 16 bytes after prologue
+  std::int32_t frame_bytes = (ast.frame_size() * 4 + 15) / 16 * 16 + 8;
+  asm_.Push(X86Reg::RBP);
+  asm_.Mov64(X86Reg::RBP, X86Reg::RSP);
+  asm_.Push(X86Reg::RBX);
+  asm_.Alu64(X86AluOp::Sub, X86Reg::RSP, frame_bytes);
+  // save runtime state and arguments
+  asm_.Mov64(X86Reg::RBX, X86Reg::RDI);
+  for (std::size_t i = 0; i < ast.args().size(); ++i) {
+    asm_.Store32(X86Reg::RBP, GetSlotDisp(i), kArgRegs[i]);
+  }
+  // generate body
+  body_pos_ = asm_.pos();
+  if (!ast.body()->GenerateNative(*this)) return false;
+  // reaching the end of body means there is no return value
+  asm_.Mov64(X86Reg::RDI, X86Reg::RBX);
+  CallAddr(GetAddr(JIT::NoReturnValue));
+  for (const auto &jump : fail_jumps_) asm_.PatchHere(jump);
+  GenerateEpilogue();
+  return true;
+}
+
+bool NativeGen::GenerateOn(const BlockAST &ast) {
+  for (const auto &stmt : ast.stmts()) {
+    if (!stmt->GenerateNative(*this)) return false;
+  }
+  return true;
+}
+
+bool NativeGen::GenerateOn(const DefineAST &ast) {
+  if (!GenerateExpr(*ast.expr())) return false;
+  asm_.Store32(X86Reg::RBP, GetSlotDisp(ast.slot()), X86Reg::RAX);
+  return true;
+}
+
+bool NativeGen::GenerateOn(const AssignAST &ast) {
+  if (!GenerateExpr(*ast.expr())) return false;
+  asm_.Store32(X86Reg::RBP, GetSlotDisp(ast.slot()), X86Reg::RAX);
+  return true;
+}
+
+bool NativeGen::GenerateOn(const IfAST &ast) {
+  // walk through the 'else if' chain
+  std::vector<std::size_t> end_jumps;
+  for (auto if_else = &ast; if_else; if_else = if_else->else_if()) {
+    // generate condition and conditional branch
+    if (!GenerateExpr(*if_else->cond())) return false;
+    asm_.Alu32(X86AluOp::Test, X86Reg::RAX, X86Reg::RAX);
+    auto branch = asm_.Jcc(X86Cond::E);
+    // generate the true branch
+    if (!if_else->then()->GenerateNative(*this)) return false;
+    if (if_else->else_then() || if_else->else_if()) {
+      end_jumps.push_back(asm_.Jmp());
+    }
+    // generate the false branch
+    asm_.PatchHere(branch);
+    if (if_else->else_then() &&
+        !if_else->else_then()->GenerateNative(*this)) {
+      return false;
+    }
+  }
+  for (const auto &jump : end_jumps) asm_.PatchHere(jump);
+  return true;
+}
+
+bool NativeGen::GenerateOn(const ReturnAST &ast) {
+  const auto call = ast.tail_call();
+  if (!call) {
+    if (!GenerateExpr(*ast.expr())) return false;
+    GenerateEpilogue();
+    return true;
+  }
+  // tail call, arguments are evaluated before replacing the frame
+  if (!GenerateArgs(*call)) return false;
+  const auto &callee = *call->callee();
+  if (&callee == func_) {
+    // jump to the body of the current function
+    for (std::size_t i = 0; i < callee.args().size(); ++i) {
+      asm_.Store32(X86Reg::RBP, GetSlotDisp(i), kArgRegs[i]);
+    }
+    asm_.JmpTo(body_pos_);
+    return true;
+  }
+  // jump to the callee if it has been compiled
+  asm_.MovImm64(X86Reg::R11, GetAddr(entries_ + callee.name()));
+  asm_.Load64(X86Reg::R11, X86Reg::R11, 0);
+  asm_.Alu64(X86AluOp::Test, X86Reg::R11, X86Reg::R11);
+  auto slow = asm_.Jcc(X86Cond::E);
+  asm_.Mov64(X86Reg::RDI, X86Reg::RBX);
+  asm_.Load64(X86Reg::RBX, X86Reg::RBP, kSavedRbx);
+  asm_.Leave();
+  asm_.Jmp(X86Reg::R11);
+  // otherwise call the interpreter, and return its result
+  asm_.PatchHere(slow);
+  asm_.MovImm64(X86Reg::RAX, GetAddr(&callee));
+  asm_.Store64(X86Reg::RBX, kCallee, X86Reg::RAX);
+  asm_.Mov64(X86Reg::RDI, X86Reg::RBX);
+  CallAddr(GetAddr(JIT::TailCallFunction));
+  CheckFailed();
+  GenerateEpilogue();
+  return true;
+}
+
+bool NativeGen::GenerateOn(const BinaryAST &ast) {
+  if (ast.op() == Operator::LAnd || ast.op() == Operator::LOr) {
+    // the result is the value of the last evaluated operand
+    if (!GenerateExpr(*ast.lhs())) return false;
+    asm_.Alu32(X86AluOp::Test, X86Reg::RAX, X86Reg::RAX);
+    auto cond = ast.op() == Operator::LAnd ? X86Cond::E : X86Cond::NE;
+    auto branch = asm_.Jcc(cond);
+    if (!GenerateExpr(*ast.rhs())) return false;
+    asm_.PatchHere(branch);
+  }
+  else {
+    // save lhs, since rhs may be evaluated to EAX
+    if (!GenerateExpr(*ast.lhs())) return false;
+    auto pos = asm_.pos();
+    PushTemp();
+    if (!GenerateOperand(*ast.rhs())) return false;
+    if (opr_.kind == Operand::Kind::Eax) {
+      asm_.Mov32(X86Reg::RCX, X86Reg::RAX);
+      PopTemp(X86Reg::RAX);
+      opr_.kind = Operand::Kind::Ecx;
+    }
+    else {
+      // constants and variables are used in place, drop the push
+      asm_.Rewind(pos);
+      --temp_num_;
+    }
+    GenerateBinary(ast.op());
+  }
+  opr_.kind = Operand::Kind::Eax;
+  return true;
+}
+
+bool NativeGen::GenerateOn(const UnaryAST &ast) {
+  if (!GenerateExpr(*ast.opr())) return false;
+  switch (ast.op()) {
+    case Operator::Sub: asm_.Neg32(X86Reg::RAX); break;
+    case Operator::LNot: {
+      asm_.Alu32(X86AluOp::Test, X86Reg::RAX, X86Reg::RAX);
+      asm_.SetEax(X86Cond::E);
+      break;
+    }
+    default: assert(false && "unknown unary operator");
+  }
+  opr_.kind = Operand::Kind::Eax;
+  return true;
+}
+
+bool NativeGen::GenerateOn(const FunCallAST &ast) {
+  opr_.kind = Operand::Kind::Eax;
+  if (ast.target() == CallTarget::Input) {
+    asm_.Mov64(X86Reg::RDI, X86Reg::RBX);
+    CallAddr(GetAddr(JIT::Input));
+    return true;
+  }
+  else if (ast.target() == CallTarget::Print) {
+    if (!GenerateExpr(*ast.args()[0])) return false;
+    asm_.Mov32(X86Reg::RSI, X86Reg::RAX);
+    asm_.Mov64(X86Reg::RDI, X86Reg::RBX);
+    CallAddr(GetAddr(JIT::Print));
+    // 'print' returns zero
+    asm_.Alu32(X86AluOp::Xor, X86Reg::RAX, X86Reg::RAX);
+    return true;
+  }
+  else if (ast.target() != CallTarget::Function) {
+    // errors are reported by the interpreter
+    return false;
+  }
+  // check depth of calls before evaluating arguments, like interpreter
+  asm_.Load64(X86Reg::RAX, X86Reg::RBX, kDepth);
+  asm_.Cmp64(X86Reg::RAX, X86Reg::RBX, kMaxDepth);
+  auto depth_ok = asm_.Jcc(X86Cond::B);
+  asm_.Mov64(X86Reg::RDI, X86Reg::RBX);
+  CallAddr(GetAddr(JIT::StackOverflow));
+  fail_jumps_.push_back(asm_.Jmp());
+  asm_.PatchHere(depth_ok);
+  if (!GenerateArgs(ast)) return false;
+  // call the callee directly if it has been compiled,
+  // and the native stack is not exhausted
+  const auto &callee = *ast.callee();
+  asm_.MovImm64(X86Reg::R11, GetAddr(entries_ + callee.name()));
+  asm_.Load64(X86Reg::R11, X86Reg::R11, 0);
+  asm_.Alu64(X86AluOp::Test, X86Reg::R11, X86Reg::R11);
+  auto not_compiled = asm_.Jcc(X86Cond::E);
+  asm_.Cmp64(X86Reg::RSP, X86Reg::RBX, kStackLimit);
+  auto stack_low = asm_.Jcc(X86Cond::B);
+  // update depth of calls
+  asm_.Load64(X86Reg::RAX, X86Reg::RBX, kDepth);
+  asm_.Alu64(X86AluOp::Add, X86Reg::RAX, 1);
+  asm_.Store64(X86Reg::RBX, kDepth, X86Reg::RAX);
+  asm_.Cmp64(X86Reg::RAX, X86Reg::RBX, kPeakDepth);
+  auto not_peak = asm_.Jcc(X86Cond::BE);
+  asm_.Store64(X86Reg::RBX, kPeakDepth, X86Reg::RAX);
+  asm_.PatchHere(not_peak);
+  asm_.Mov64(X86Reg::RDI, X86Reg::RBX);
+  CallReg(X86Reg::R11);
+  asm_.Dec64(X86Reg::RBX, kDepth);
+  auto done = asm_.Jmp();
+  // otherwise call the interpreter
+  asm_.PatchHere(not_compiled);
+  asm_.PatchHere(stack_low);
+  asm_.MovImm64(X86Reg::RAX, GetAddr(&callee));
+  asm_.Store64(X86Reg::RBX, kCallee, X86Reg::RAX);
+  asm_.Mov64(X86Reg::RDI, X86Reg::RBX);
+  CallAddr(GetAddr(JIT::CallFunction));
+  asm_.PatchHere(done);
+  CheckFailed();
+  return true;
+}
+
+bool NativeGen::GenerateOn(const IntAST &ast) {
+  opr_ = {Operand::Kind::Imm, ast.val()};
+  return true;
+}
+
+bool NativeGen::GenerateOn(const IdAST &ast) {
+  opr_ = {Operand::Kind::Slot, GetSlotDisp(ast.slot())};
+  return true;
+}
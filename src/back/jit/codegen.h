@@ -0,0 +1,90 @@
+#ifndef FIRSTSTEP_BACK_JIT_CODEGEN_H_
+#define FIRSTSTEP_BACK_JIT_CODEGEN_H_
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "define/ast.h"
+#include "back/jit/x86.h"
+#include "back/jit/jit.h"
+
+// generator of x86-64 machine code for a single function
+// variables live in slots of the native frame, results of expressions
+// are held in EAX, and temporaries are pushed on the native stack
+// functions with too many arguments, or calls that fail at runtime
+// because they are not linked, are not supported
+class NativeGen {
+ public:
+  // 'entries' is the table of compiled code indexed by symbol id
+  NativeGen(const NativeFunc *entries) : entries_(entries) {}
+
+  // generate code for the specific function
+  // returns false if the function is not supported
+  bool Generate(const FunDefAST &func);
+
+  // visitor methods, return false if not supported
+  bool GenerateOn(const FunDefAST &ast);
+  bool GenerateOn(const BlockAST &ast);
+  bool GenerateOn(const DefineAST &ast);
+  bool GenerateOn(const AssignAST &ast);
+  bool GenerateOn(const IfAST &ast);
+  bool GenerateOn(const ReturnAST &ast);
+  bool GenerateOn(const BinaryAST &ast);
+  bool GenerateOn(const UnaryAST &ast);
+  bool GenerateOn(const FunCallAST &ast);
+  bool GenerateOn(const IntAST &ast);
+  bool GenerateOn(const IdAST &ast);
+
+  // generated code
+  const std::vector<std::uint8_t> &code() const { return asm_.code(); }
+
+ private:
+  // location of the result of an expression
+  struct Operand {
+    enum class Kind { Eax, Ecx, Imm, Slot } kind;
+    std::int32_t val;
+  };
+
+  // generate the specific expression, returns false if not supported
+  // constants and variables are not loaded, their locations are
+  // stored in 'opr_'
+  bool GenerateOperand(const BaseAST &ast);
+  // generate the specific expression to EAX
+  bool GenerateExpr(const BaseAST &ast);
+  // generate arguments of the specific call to argument registers
+  bool GenerateArgs(const FunCallAST &ast);
+  // perform binary operation on EAX and 'opr_', which is not in EAX
+  void GenerateBinary(Operator op);
+  // perform division or modulo of EAX by 'opr_'
+  void GenerateDivision(bool is_mod);
+  // perform 'op eax, opr_'
+  void GenerateAlu(X86AluOp op);
+  // push/pop EAX as a temporary value
+  void PushTemp();
+  void PopTemp(X86Reg reg);
+  // call the specific address, keeps the stack aligned
+  void CallAddr(std::uintptr_t addr);
+  void CallReg(X86Reg reg);
+  // return from the function
+  void GenerateEpilogue();
+  // jump to the epilogue if there is an error
+  void CheckFailed();
+  // get the displacement of the specific slot relative to RBP
+  static std::int32_t GetSlotDisp(Slot slot);
+
+  X86Assembler asm_;
+  const NativeFunc *entries_;
+  // the current function
+  const FunDefAST *func_;
+  // position of the function body, the target of self tail calls
+  std::size_t body_pos_;
+  // count of temporaries pushed on the stack
+  std::size_t temp_num_;
+  // jumps to the epilogue of errors
+  std::vector<std::size_t> fail_jumps_;
+  // result of the last expression
+  Operand opr_;
+};
+
+#endif  // FIRSTSTEP_BACK_JIT_CODEGEN_H_
@@ -0,0 +1,172 @@
+#include "back/jit/jit.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "back/jit/codegen.h"
+#include "back/interpreter/interpreter.h"
+
+#if defined(__x86_64__) && (defined(__unix__) || defined(__APPLE__))
+#define FIRSTSTEP_USE_JIT
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// min size of memory chunks of compiled code
+constexpr std::size_t kChunkSize = 1 << 20;
+
+}  // namespace
+
+bool JIT::IsSupported() {
+#ifdef FIRSTSTEP_USE_JIT
+  return true;
+#else
+  return false;
+#endif
+}
+
+JIT::JIT(Interpreter &intp, std::size_t func_num)
+    : intp_(intp), entries_(new NativeFunc[func_num]()),
+      counts_(func_num) {
+  state_ = {&intp, 0, 0, 0, 0, nullptr, false};
+}
+
+JIT::~JIT() {
+#ifdef FIRSTSTEP_USE_JIT
+  for (const auto &chunk : chunks_) munmap(chunk.mem, chunk.size);
+#endif
+}
+
+NativeFunc JIT::Compile(const FunDefAST &func) {
+  NativeGen gen(entries_.get());
+  if (!gen.Generate(func)) return nullptr;
+  auto code = Install(gen.code());
+  entries_[func.name()] = code;
+  return code;
+}
+
+NativeFunc JIT::Install(const std::vector<std::uint8_t> &code) {
+#ifdef FIRSTSTEP_USE_JIT
+  // allocate a new chunk if there is no enough space
+  if (chunks_.empty() ||
+      chunks_.back().size - chunks_.back().used < code.size()) {
+    std::size_t page = sysconf(_SC_PAGESIZE);
+    auto size =
+        std::max(kChunkSize, (code.size() + page - 1) / page * page);
+    auto mem = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED) return nullptr;
+    chunks_.push_back({static_cast<std::uint8_t *>(mem), size, 0});
+  }
+  // new chunks are mapped read-write, used chunks are switched from
+  // read-execute back to read-write before appending, and the whole
+  // chunk is switched to read-execute after appending, so it is never
+  // writable and executable at the same time
+  // compiled code of the chunk may be suspended in a runtime call that
+  // triggered this compilation, but it resumes only after the chunk
+  // has been switched back to read-execute
+  auto &chunk = chunks_.back();
+  if (chunk.used &&
+      mprotect(chunk.mem, chunk.size, PROT_READ | PROT_WRITE)) {
+    return nullptr;
+  }
+  auto addr = chunk.mem + chunk.used;
+  std::memcpy(addr, code.data(), code.size());
+  chunk.used += (code.size() + 15) / 16 * 16;
+  chunk.used = std::min(chunk.used, chunk.size);
+  if (mprotect(chunk.mem, chunk.size, PROT_READ | PROT_EXEC)) {
+    return nullptr;
+  }
+  return reinterpret_cast<NativeFunc>(addr);
+#else
+  static_cast<void>(code);
+  return nullptr;
+#endif
+}
+
+std::optional<int> JIT::Run(NativeFunc code, const int *args,
+                            std::size_t arg_num) {
+  int a[kMaxArgs] = {};
+  std::copy_n(args, arg_num, a);
+  // compiled code may be run by runtime functions called by compiled
+  // code, so the state of the caller must be restored
+  auto last_depth = state_.depth;
+  auto last_limit = state_.stack_limit;
+  state_.depth = intp_.depth_;
+  state_.max_depth = intp_.max_depth_;
+  state_.peak_depth = intp_.peak_depth_;
+  state_.stack_limit = intp_.native_stack_.limit();
+  // compiled code is only run if there is no error, failures of
+  // the last evaluation must be cleared
+  state_.failed = false;
+  auto ret = code(&state_, a[0], a[1], a[2], a[3], a[4]);
+  intp_.peak_depth_ = state_.peak_depth;
+  state_.depth = last_depth;
+  state_.stack_limit = last_limit;
+  if (state_.failed) return {};
+  return ret;
+}
+
+int JIT::CallInterpreter(JITState *state, const int *args,
+                         bool is_tail) {
+  auto &intp = *state->intp;
+  // continue on a new stack segment if the native stack is exhausted
+  if (intp.native_stack_.IsLow()) {
+    int ret = 0;
+    auto call = [state, args, is_tail, &ret] {
+      ret = CallInterpreter(state, args, is_tail);
+    };
+    if (!intp.native_stack_.RunOnNewSegment(call)) {
+      intp.LogError("native stack overflow");
+      state->failed = true;
+    }
+    return ret;
+  }
+  // call the function, tail calls do not increase the depth
+  auto last_depth = intp.depth_;
+  intp.depth_ = state->depth + !is_tail;
+  intp.peak_depth_ = std::max(state->peak_depth, intp.depth_);
+  auto ret = intp.CallWithArgs(*state->callee, args);
+  intp.depth_ = last_depth;
+  state->peak_depth = intp.peak_depth_;
+  state->failed = intp.error_num_ != 0;
+  return ret ? *ret : 0;
+}
+
+int JIT::CallFunction(JITState *state, int a0, int a1, int a2, int a3,
+                      int a4) {
+  int args[] = {a0, a1, a2, a3, a4};
+  return CallInterpreter(state, args, false);
+}
+
+int JIT::TailCallFunction(JITState *state, int a0, int a1, int a2,
+                          int a3, int a4) {
+  int args[] = {a0, a1, a2, a3, a4};
+  return CallInterpreter(state, args, true);
+}
+
+void JIT::StackOverflow(JITState *state) {
+  state->intp->LogError("call stack overflow");
+  state->failed = true;
+}
+
+void JIT::NoReturnValue(JITState *state) {
+  // do not report again if the body has failed
+  if (!state->intp->error_num_) {
+    state->intp->LogError("function has no return value");
+  }
+  state->failed = true;
+}
+
+void JIT::DivisionByZero(JITState *state) {
+  state->intp->LogError("division by zero");
+  state->failed = true;
+}
+
+int JIT::Input(JITState *state) { return state->intp->io_->ReadInt(); }
+
+void JIT::Print(JITState *state, int val) {
+  state->intp->io_->WriteInt(val);
+}
@@ -0,0 +1,111 @@
+#ifndef FIRSTSTEP_BACK_JIT_JIT_H_
+#define FIRSTSTEP_BACK_JIT_JIT_H_
+
+#include <optional>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+#include "define/ast.h"
+
+// forwarded declarations
+class Interpreter;
+
+// runtime state shared by the interpreter and compiled code,
+// fields are accessed by compiled code at fixed offsets
+struct JITState {
+  Interpreter *intp;
+  // current depth, max depth and peak depth of calls
+  std::size_t depth, max_depth, peak_depth;
+  // compiled code calls compiled functions directly only if the stack
+  // pointer is above this address, otherwise calls the interpreter,
+  // which may switch to a new stack segment
+  std::uintptr_t stack_limit;
+  // callee of the current call through the interpreter
+  const FunDefAST *callee;
+  // set if there is an error, compiled code returns immediately
+  bool failed;
+};
+
+// compiled function, takes the state and up to 'JIT::kMaxArgs' arguments
+using NativeFunc = int (*)(JITState *, int, int, int, int, int);
+
+// tiered compiler of the interpreter
+// calls of every function are counted, functions called more than
+// 'kHotCalls' times are compiled to x86-64 machine code, which calls
+// compiled functions directly, and other functions through interpreter
+// only supported on x86-64 with System V ABI
+class JIT {
+ public:
+  // max count of arguments of compiled functions
+  static constexpr std::size_t kMaxArgs = 5;
+  // count of calls before a function is compiled
+  static constexpr std::uint32_t kHotCalls = 100;
+
+  // check if compiled code can be run on the current platform
+  static bool IsSupported();
+
+  // 'func_num' is the upper bound of symbol ids of all functions
+  JIT(Interpreter &intp, std::size_t func_num);
+  ~JIT();
+
+  JIT(const JIT &) = delete;
+  JIT &operator=(const JIT &) = delete;
+
+  // count a call of the specific function, returns its compiled code
+  // if the function is hot, otherwise returns null
+  NativeFunc GetCode(const FunDefAST &func) {
+    auto code = entries_[func.name()];
+    if (code) return code;
+    auto &count = counts_[func.name()];
+    if (count >= kHotCalls || ++count < kHotCalls) return nullptr;
+    return Compile(func);
+  }
+  // run compiled code with the specific arguments
+  // returns 'nullopt' if there is an error
+  std::optional<int> Run(NativeFunc code, const int *args,
+                         std::size_t arg_num);
+
+  // runtime functions called by compiled code
+  // call 'state->callee' through interpreter, the depth of calls
+  // is not increased for tail calls
+  static int CallFunction(JITState *state, int a0, int a1, int a2,
+                          int a3, int a4);
+  static int TailCallFunction(JITState *state, int a0, int a1, int a2,
+                              int a3, int a4);
+  // report errors
+  static void StackOverflow(JITState *state);
+  static void NoReturnValue(JITState *state);
+  static void DivisionByZero(JITState *state);
+  // library functions
+  static int Input(JITState *state);
+  static void Print(JITState *state, int val);
+
+ private:
+  // memory chunk of compiled code
+  struct Chunk {
+    std::uint8_t *mem;
+    std::size_t size, used;
+  };
+
+  // compile the specific function, returns null if failed
+  NativeFunc Compile(const FunDefAST &func);
+  // copy code to executable memory
+  NativeFunc Install(const std::vector<std::uint8_t> &code);
+  // call 'state->callee' with arguments
+  static int CallInterpreter(JITState *state, const int *args,
+                             bool is_tail);
+
+  Interpreter &intp_;
+  JITState state_;
+  // compiled code and call counts of functions, indexed by symbol id
+  // code addresses are referenced by compiled code, so the table
+  // must never be reallocated
+  std::unique_ptr<NativeFunc[]> entries_;
+  std::vector<std::uint32_t> counts_;
+  // memory chunks of compiled code
+  std::vector<Chunk> chunks_;
+};
+
+#endif  // FIRSTSTEP_BACK_JIT_JIT_H_
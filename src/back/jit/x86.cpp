@@ -0,0 +1,112 @@
+#include "back/jit/x86.h"
+
+#include <cassert>
+
+namespace {
+
+// low 3 bits and high bit of register number
+inline int Low(X86Reg reg) { return static_cast<int>(reg) & 7; }
+inline bool High(X86Reg reg) { return static_cast<int>(reg) >= 8; }
+
+}  // namespace
+
+void X86Assembler::MovImm32(X86Reg dst, std::int32_t imm) {
+  EmitShort(0xb8, dst);
+  Emit32(imm);
+}
+
+void X86Assembler::MovImm64(X86Reg dst, std::uint64_t imm) {
+  Emit8(0x48 | High(dst));
+  Emit8(0xb8 | Low(dst));
+  Emit32(imm);
+  Emit32(imm >> 32);
+}
+
+void X86Assembler::SetEax(X86Cond cond) {
+  // setcc al; movzx eax, al
+  Emit8(0x0f);
+  Emit8(0x90 | static_cast<int>(cond));
+  Emit8(0xc0);
+  Emit8(0x0f);
+  Emit8(0xb6);
+  Emit8(0xc0);
+}
+
+std::size_t X86Assembler::Jmp() {
+  Emit8(0xe9);
+  Emit32(0);
+  return code_.size();
+}
+
+std::size_t X86Assembler::Jcc(X86Cond cond) {
+  Emit8(0x0f);
+  Emit8(0x80 | static_cast<int>(cond));
+  Emit32(0);
+  return code_.size();
+}
+
+void X86Assembler::PatchTo(std::size_t pos, std::size_t target) {
+  // 'pos' is the end of the jump instruction
+  auto disp = static_cast<std::uint32_t>(target - pos);
+  for (int i = 0; i < 4; ++i) code_[pos - 4 + i] = disp >> (i * 8);
+}
+
+void X86Assembler::Emit32(std::uint32_t val) {
+  for (int i = 0; i < 4; ++i) Emit8(val >> (i * 8));
+}
+
+void X86Assembler::EmitShort(std::uint8_t op, X86Reg reg) {
+  if (High(reg)) Emit8(0x41);
+  Emit8(op | Low(reg));
+}
+
+void X86Assembler::EmitOp(bool w, std::uint16_t op, X86Reg reg,
+                          X86Reg rm) {
+  std::uint8_t rex = 0x40 | (w << 3) | (High(reg) << 2) | High(rm);
+  if (rex != 0x40) Emit8(rex);
+  Emit8(op);
+  if (op >> 8) Emit8(op >> 8);
+}
+
+void X86Assembler::EmitRR(bool w, std::uint16_t op, X86Reg reg,
+                          X86Reg rm) {
+  EmitOp(w, op, reg, rm);
+  Emit8(0xc0 | (Low(reg) << 3) | Low(rm));
+}
+
+void X86Assembler::EmitRM(bool w, std::uint16_t op, X86Reg reg,
+                          X86Reg base, std::int32_t disp) {
+  assert(Low(base) != Low(X86Reg::RSP) && "base requires SIB byte");
+  EmitOp(w, op, reg, base);
+  // use 8-bit displacement if possible
+  if (disp >= -128 && disp <= 127) {
+    Emit8(0x40 | (Low(reg) << 3) | Low(base));
+    Emit8(disp);
+  }
+  else {
+    Emit8(0x80 | (Low(reg) << 3) | Low(base));
+    Emit32(disp);
+  }
+}
+
+void X86Assembler::EmitAluImm(bool w, X86AluOp op, X86Reg dst,
+                              std::int32_t imm) {
+  // get opcode extension
+  X86Reg ext;
+  switch (op) {
+    case X86AluOp::Add: ext = X86Reg::RAX; break;
+    case X86AluOp::Sub: ext = X86Reg::RBP; break;
+    case X86AluOp::Xor: ext = X86Reg::RSI; break;
+    case X86AluOp::Cmp: ext = X86Reg::RDI; break;
+    default: assert(false && "invalid operation"); return;
+  }
+  // use 8-bit immediate if possible
+  if (imm >= -128 && imm <= 127) {
+    EmitRR(w, 0x83, ext, dst);
+    Emit8(imm);
+  }
+  else {
+    EmitRR(w, 0x81, ext, dst);
+    Emit32(imm);
+  }
+}
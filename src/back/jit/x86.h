@@ -0,0 +1,141 @@
+#ifndef FIRSTSTEP_BACK_JIT_X86_H_
+#define FIRSTSTEP_BACK_JIT_X86_H_
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// general purpose registers of x86-64
+enum class X86Reg : std::uint8_t {
+  RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI,
+  R8, R9, R10, R11, R12, R13, R14, R15,
+};
+
+// condition codes of x86-64
+enum class X86Cond : std::uint8_t {
+  B = 0x2, AE = 0x3, E = 0x4, NE = 0x5, BE = 0x6, A = 0x7,
+  L = 0xc, GE = 0xd, LE = 0xe, G = 0xf,
+};
+
+// arithmetic instructions, values are opcodes of the form 'op r/m, r'
+enum class X86AluOp : std::uint8_t {
+  Add = 0x01, Sub = 0x29, Xor = 0x31, Cmp = 0x39, Test = 0x85,
+};
+
+// assembler of a small subset of x86-64 instructions
+// memory operands are always '[base + disp]', 'base' must not be
+// RSP or R12, which require a SIB byte
+// jumps are relative, so the code is position-independent
+class X86Assembler {
+ public:
+  // stack operations
+  void Push(X86Reg reg) { EmitShort(0x50, reg); }
+  void Pop(X86Reg reg) { EmitShort(0x58, reg); }
+  void Leave() { Emit8(0xc9); }
+  void Ret() { Emit8(0xc3); }
+
+  // data movement, '32' and '64' are sizes of operands
+  void Mov32(X86Reg dst, X86Reg src) { EmitRR(false, 0x89, src, dst); }
+  void Mov64(X86Reg dst, X86Reg src) { EmitRR(true, 0x89, src, dst); }
+  void MovImm32(X86Reg dst, std::int32_t imm);
+  void MovImm64(X86Reg dst, std::uint64_t imm);
+  void Load32(X86Reg dst, X86Reg base, std::int32_t disp) {
+    EmitRM(false, 0x8b, dst, base, disp);
+  }
+  void Store32(X86Reg base, std::int32_t disp, X86Reg src) {
+    EmitRM(false, 0x89, src, base, disp);
+  }
+  void Load64(X86Reg dst, X86Reg base, std::int32_t disp) {
+    EmitRM(true, 0x8b, dst, base, disp);
+  }
+  void Store64(X86Reg base, std::int32_t disp, X86Reg src) {
+    EmitRM(true, 0x89, src, base, disp);
+  }
+
+  // arithmetic
+  void Alu32(X86AluOp op, X86Reg dst, X86Reg src) {
+    EmitRR(false, static_cast<std::uint8_t>(op), src, dst);
+  }
+  void Alu64(X86AluOp op, X86Reg dst, X86Reg src) {
+    EmitRR(true, static_cast<std::uint8_t>(op), src, dst);
+  }
+  // 'op dst, [base + disp]', 'Test' is not allowed
+  void Alu32(X86AluOp op, X86Reg dst, X86Reg base, std::int32_t disp) {
+    EmitRM(false, static_cast<std::uint8_t>(op) + 2, dst, base, disp);
+  }
+  // 'op dst, imm', 'Test' is not allowed
+  void Alu32(X86AluOp op, X86Reg dst, std::int32_t imm) {
+    EmitAluImm(false, op, dst, imm);
+  }
+  void Alu64(X86AluOp op, X86Reg dst, std::int32_t imm) {
+    EmitAluImm(true, op, dst, imm);
+  }
+  void Cmp64(X86Reg lhs, X86Reg base, std::int32_t disp) {
+    EmitRM(true, 0x3b, lhs, base, disp);
+  }
+  void Imul32(X86Reg dst, X86Reg src) { EmitRR(false, 0xaf0f, dst, src); }
+  void Imul32(X86Reg dst, X86Reg base, std::int32_t disp) {
+    EmitRM(false, 0xaf0f, dst, base, disp);
+  }
+  void Imul32Imm(X86Reg dst, X86Reg src, std::int32_t imm) {
+    EmitRR(false, 0x69, dst, src);
+    Emit32(imm);
+  }
+  // sign-extend EAX to EDX:EAX
+  void Cdq() { Emit8(0x99); }
+  // instructions with an opcode extension in the reg field of ModRM
+  void Idiv32(X86Reg src) { EmitRR(false, 0xf7, X86Reg::RDI, src); }
+  void Neg32(X86Reg dst) { EmitRR(false, 0xf7, X86Reg::RBX, dst); }
+  void Inc64(X86Reg base, std::int32_t disp) {
+    EmitRM(true, 0xff, X86Reg::RAX, base, disp);
+  }
+  void Dec64(X86Reg base, std::int32_t disp) {
+    EmitRM(true, 0xff, X86Reg::RCX, base, disp);
+  }
+  // compare the byte at '[base + disp]' with zero
+  void CmpZero8(X86Reg base, std::int32_t disp) {
+    EmitRM(false, 0x80, X86Reg::RDI, base, disp);
+    Emit8(0);
+  }
+  // 'eax = cond ? 1 : 0'
+  void SetEax(X86Cond cond);
+
+  // control flow, jumps to unknown targets return their positions,
+  // which must be patched later
+  std::size_t Jmp();
+  std::size_t Jcc(X86Cond cond);
+  void JmpTo(std::size_t target) { PatchTo(Jmp(), target); }
+  void JccTo(X86Cond cond, std::size_t target) {
+    PatchTo(Jcc(cond), target);
+  }
+  void Call(X86Reg target) { EmitRR(false, 0xff, X86Reg::RDX, target); }
+  void Jmp(X86Reg target) { EmitRR(false, 0xff, X86Reg::RSP, target); }
+  // set the target of the specific jump
+  void PatchTo(std::size_t pos, std::size_t target);
+  void PatchHere(std::size_t pos) { PatchTo(pos, code_.size()); }
+
+  // current position
+  std::size_t pos() const { return code_.size(); }
+  // generated code
+  const std::vector<std::uint8_t> &code() const { return code_; }
+  void Clear() { code_.clear(); }
+  // remove code after the specific position
+  void Rewind(std::size_t pos) { code_.resize(pos); }
+
+ private:
+  void Emit8(std::uint8_t byte) { code_.push_back(byte); }
+  void Emit32(std::uint32_t val);
+  // emit a one-byte opcode with the register in its low bits
+  void EmitShort(std::uint8_t op, X86Reg reg);
+  // emit REX prefix if required, and the opcode (low byte first)
+  void EmitOp(bool w, std::uint16_t op, X86Reg reg, X86Reg rm);
+  // emit instructions with register or memory operand
+  void EmitRR(bool w, std::uint16_t op, X86Reg reg, X86Reg rm);
+  void EmitRM(bool w, std::uint16_t op, X86Reg reg, X86Reg base,
+              std::int32_t disp);
+  void EmitAluImm(bool w, X86AluOp op, X86Reg dst, std::int32_t imm);
+
+  std::vector<std::uint8_t> code_;
+};
+
+#endif  // FIRSTSTEP_BACK_JIT_X86_H_
@@ -0,0 +1,192 @@
+#include "back/lanes/kernels.h"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define FIRSTSTEP_LANES_X86
+#include <immintrin.h>
+#endif
+
+namespace {
+
+/*
+  scalar implementation
+  operations are performed on unsigned integers, so that overflow
+  wraps around without undefined behavior
+*/
+
+inline int Add(int l, int r) {
+  return static_cast<int>(static_cast<unsigned>(l) + r);
+}
+
+inline int Sub(int l, int r) {
+  return static_cast<int>(static_cast<unsigned>(l) - r);
+}
+
+inline int Mul(int l, int r) {
+  return static_cast<int>(static_cast<unsigned>(l) * r);
+}
+
+inline int Less(int l, int r) { return l < r; }
+inline int LessEq(int l, int r) { return l <= r; }
+inline int Eq(int l, int r) { return l == r; }
+inline int NotEq(int l, int r) { return l != r; }
+
+template <int (*Op)(int, int)>
+void BinaryScalar(const LaneVal &lhs, const LaneVal &rhs, LaneVal &ret) {
+  for (std::size_t i = 0; i < kLaneNum; ++i) {
+    ret.vals[i] = Op(lhs.vals[i], rhs.vals[i]);
+  }
+}
+
+void NegScalar(const LaneVal &opr, LaneVal &ret) {
+  for (std::size_t i = 0; i < kLaneNum; ++i) {
+    ret.vals[i] = Sub(0, opr.vals[i]);
+  }
+}
+
+void LNotScalar(const LaneVal &opr, LaneVal &ret) {
+  for (std::size_t i = 0; i < kLaneNum; ++i) ret.vals[i] = !opr.vals[i];
+}
+
+void BlendScalar(LaneVal &dst, const LaneVal &src, LaneMask mask) {
+  for (std::size_t i = 0; i < kLaneNum; ++i) {
+    if (mask & (1u << i)) dst.vals[i] = src.vals[i];
+  }
+}
+
+LaneMask NonZeroScalar(const LaneVal &val) {
+  LaneMask mask = 0;
+  for (std::size_t i = 0; i < kLaneNum; ++i) {
+    if (val.vals[i]) mask |= 1u << i;
+  }
+  return mask;
+}
+
+const LaneFuncs kScalarFuncs = {
+    BinaryScalar<Add>,  BinaryScalar<Sub>,    BinaryScalar<Mul>,
+    BinaryScalar<Less>, BinaryScalar<LessEq>, BinaryScalar<Eq>,
+    BinaryScalar<NotEq>, NegScalar, LNotScalar, BlendScalar, NonZeroScalar,
+};
+
+#ifdef FIRSTSTEP_LANES_X86
+
+/*
+  AVX2 implementation, all lanes in one register
+  comparisons produce 0 or -1, which are turned into 0 or 1
+*/
+
+#define FIRSTSTEP_AVX2 __attribute__((target("avx2")))
+
+FIRSTSTEP_AVX2 inline __m256i Load(const LaneVal &val) {
+  return _mm256_load_si256(reinterpret_cast<const __m256i *>(val.vals));
+}
+
+FIRSTSTEP_AVX2 inline void Store(LaneVal &val, __m256i v) {
+  _mm256_store_si256(reinterpret_cast<__m256i *>(val.vals), v);
+}
+
+// turn 0 or -1 into 0 or 1
+FIRSTSTEP_AVX2 inline __m256i ToBool(__m256i v) {
+  return _mm256_sub_epi32(_mm256_setzero_si256(), v);
+}
+
+// turn 0 or -1 into 1 or 0
+FIRSTSTEP_AVX2 inline __m256i ToNotBool(__m256i v) {
+  return _mm256_add_epi32(v, _mm256_set1_epi32(1));
+}
+
+FIRSTSTEP_AVX2 inline __m256i Add32(__m256i l, __m256i r) {
+  return _mm256_add_epi32(l, r);
+}
+
+FIRSTSTEP_AVX2 inline __m256i Sub32(__m256i l, __m256i r) {
+  return _mm256_sub_epi32(l, r);
+}
+
+FIRSTSTEP_AVX2 inline __m256i Mul32(__m256i l, __m256i r) {
+  return _mm256_mullo_epi32(l, r);
+}
+
+FIRSTSTEP_AVX2 inline __m256i Less32(__m256i l, __m256i r) {
+  return ToBool(_mm256_cmpgt_epi32(r, l));
+}
+
+FIRSTSTEP_AVX2 inline __m256i LessEq32(__m256i l, __m256i r) {
+  return ToNotBool(_mm256_cmpgt_epi32(l, r));
+}
+
+FIRSTSTEP_AVX2 inline __m256i Eq32(__m256i l, __m256i r) {
+  return ToBool(_mm256_cmpeq_epi32(l, r));
+}
+
+FIRSTSTEP_AVX2 inline __m256i NotEq32(__m256i l, __m256i r) {
+  return ToNotBool(_mm256_cmpeq_epi32(l, r));
+}
+
+template <__m256i (*Op)(__m256i, __m256i)>
+FIRSTSTEP_AVX2 void BinaryAVX2(const LaneVal &lhs, const LaneVal &rhs,
+                               LaneVal &ret) {
+  Store(ret, Op(Load(lhs), Load(rhs)));
+}
+
+FIRSTSTEP_AVX2 void NegAVX2(const LaneVal &opr, LaneVal &ret) {
+  Store(ret, _mm256_sub_epi32(_mm256_setzero_si256(), Load(opr)));
+}
+
+FIRSTSTEP_AVX2 void LNotAVX2(const LaneVal &opr, LaneVal &ret) {
+  auto zero = _mm256_setzero_si256();
+  Store(ret, ToBool(_mm256_cmpeq_epi32(Load(opr), zero)));
+}
+
+FIRSTSTEP_AVX2 void BlendAVX2(LaneVal &dst, const LaneVal &src,
+                              LaneMask mask) {
+  // expand bits of mask to lanes
+  auto bits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+  auto sel = _mm256_and_si256(_mm256_set1_epi32(mask), bits);
+  sel = _mm256_cmpeq_epi32(sel, bits);
+  Store(dst, _mm256_blendv_epi8(Load(dst), Load(src), sel));
+}
+
+FIRSTSTEP_AVX2 LaneMask NonZeroAVX2(const LaneVal &val) {
+  auto zero = _mm256_cmpeq_epi32(Load(val), _mm256_setzero_si256());
+  auto mask = _mm256_movemask_ps(_mm256_castsi256_ps(zero));
+  return ~static_cast<LaneMask>(mask) & ((1u << kLaneNum) - 1);
+}
+
+const LaneFuncs kAVX2Funcs = {
+    BinaryAVX2<Add32>,  BinaryAVX2<Sub32>,    BinaryAVX2<Mul32>,
+    BinaryAVX2<Less32>, BinaryAVX2<LessEq32>, BinaryAVX2<Eq32>,
+    BinaryAVX2<NotEq32>, NegAVX2, LNotAVX2, BlendAVX2, NonZeroAVX2,
+};
+
+#endif  // FIRSTSTEP_LANES_X86
+
+}  // namespace
+
+LaneISA GetBestLaneISA() {
+#ifdef FIRSTSTEP_LANES_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) return LaneISA::AVX2;
+#endif
+  return LaneISA::Scalar;
+}
+
+const char *GetLaneISAName(LaneISA isa) {
+  switch (isa) {
+    case LaneISA::AVX2: return "avx2";
+    default: return "scalar";
+  }
+}
+
+const LaneFuncs &GetLaneFuncs(LaneISA isa) {
+  switch (isa) {
+#ifdef FIRSTSTEP_LANES_X86
+    case LaneISA::AVX2: return kAVX2Funcs;
+#endif
+    default: return kScalarFuncs;
+  }
+}
+
+const LaneFuncs &GetLaneFuncs() {
+  static const LaneFuncs &funcs = GetLaneFuncs(GetBestLaneISA());
+  return funcs;
+}
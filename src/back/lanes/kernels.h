@@ -0,0 +1,53 @@
+#ifndef FIRSTSTEP_BACK_LANES_KERNELS_H_
+#define FIRSTSTEP_BACK_LANES_KERNELS_H_
+
+#include <cstdint>
+#include <cstddef>
+
+// arithmetic kernels of the lane interpreter, vectorized if possible
+
+// count of lanes, every lane holds an integer of a program instance
+constexpr std::size_t kLaneNum = 8;
+
+// values of all lanes
+struct alignas(32) LaneVal {
+  int vals[kLaneNum];
+};
+
+// bit mask of lanes, bit 'i' is set if lane 'i' is selected
+using LaneMask = std::uint32_t;
+
+// instruction set extensions of the kernels
+enum class LaneISA { Scalar, AVX2 };
+
+// function table of kernels, operations wrap around on overflow,
+// comparisons and logical not produce 0 or 1
+struct LaneFuncs {
+  // binary operations
+  void (*add)(const LaneVal &lhs, const LaneVal &rhs, LaneVal &ret);
+  void (*sub)(const LaneVal &lhs, const LaneVal &rhs, LaneVal &ret);
+  void (*mul)(const LaneVal &lhs, const LaneVal &rhs, LaneVal &ret);
+  void (*lt)(const LaneVal &lhs, const LaneVal &rhs, LaneVal &ret);
+  void (*le)(const LaneVal &lhs, const LaneVal &rhs, LaneVal &ret);
+  void (*eq)(const LaneVal &lhs, const LaneVal &rhs, LaneVal &ret);
+  void (*ne)(const LaneVal &lhs, const LaneVal &rhs, LaneVal &ret);
+  // unary operations
+  void (*neg)(const LaneVal &opr, LaneVal &ret);
+  void (*lnot)(const LaneVal &opr, LaneVal &ret);
+  // copy selected lanes of 'src' to 'dst'
+  void (*blend)(LaneVal &dst, const LaneVal &src, LaneMask mask);
+  // get the mask of non-zero lanes
+  LaneMask (*non_zero)(const LaneVal &val);
+};
+
+// get the best instruction set extension supported by the current CPU
+LaneISA GetBestLaneISA();
+// get name of the specific instruction set extension
+const char *GetLaneISAName(LaneISA isa);
+// get kernels of the specific instruction set extension
+// the extension must be supported by the current CPU
+const LaneFuncs &GetLaneFuncs(LaneISA isa);
+// get kernels of the best instruction set extension
+const LaneFuncs &GetLaneFuncs();
+
+#endif  // FIRSTSTEP_BACK_LANES_KERNELS_H_
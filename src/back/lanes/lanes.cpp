@@ -0,0 +1,361 @@
+#include "back/lanes/lanes.h"
+
+#include <algorithm>
+#include <bitset>
+#include <utility>
+#include <cassert>
+
+#include "define/symbol.h"
+
+namespace {
+
+// get the mask of the specific lane
+inline LaneMask LaneBit(std::size_t i) { return LaneMask(1) << i; }
+
+// get the count of lanes in the specific mask
+inline std::size_t LaneCount(LaneMask mask) {
+  return std::bitset<kLaneNum>(mask).count();
+}
+
+}  // namespace
+
+LaneInterpreter::LaneInterpreter(const std::vector<ASTPtr> &funcs)
+    : ops_(GetLaneFuncs()), main_(nullptr), live_(0), active_(0),
+      failed_(0), returned_(0), entry_(0), tail_lanes_(0),
+      tail_callee_(nullptr), frame_base_(0), frame_top_(0), ret_(),
+      max_depth_(Interpreter::kDefaultMaxDepth), depth_(0) {
+  for (const auto &func : funcs) {
+    auto def = static_cast<const FunDefAST *>(func);
+    if (def->name() == kSymMain) main_ = def;
+    intp_.AddFunctionDef(func);
+  }
+  intp_.set_resolved(true);
+  intp_.set_err_stream(err_);
+}
+
+LaneMask LaneInterpreter::Eval(const std::string_view *inputs,
+                               std::size_t num, int *rets,
+                               std::string *outputs) {
+  assert(num <= kLaneNum && "too many lanes");
+  live_ = LaneBit(num) - 1;
+  if (!main_) return live_;
+  active_ = live_;
+  failed_ = returned_ = 0;
+  err_.str({});
+  for (std::size_t i = 0; i < num; ++i) {
+    io_[i].emplace(inputs[i], outputs[i]);
+  }
+  // initialize the frame of 'main' function
+  native_stack_.Reset();
+  depth_ = 0;
+  frame_base_ = frame_top_ = 0;
+  GrowFrame(main_->frame_size());
+  auto ret = main_->EvalLanes(*this);
+  // outputs are flushed when I/O is destructed
+  for (std::size_t i = 0; i < num; ++i) {
+    rets[i] = ret.vals[i];
+    io_[i].reset();
+  }
+  return failed_;
+}
+
+void LaneInterpreter::GrowFrame(std::size_t size) {
+  frame_top_ += size;
+  if (stack_.size() < frame_top_) {
+    stack_.resize(std::max(stack_.size() * 2, frame_top_));
+  }
+}
+
+LaneVal LaneInterpreter::EvalDivMod(const BinaryAST &ast,
+                                    const LaneVal &lhs,
+                                    const LaneVal &rhs) {
+  // there is no vector division, so divide lane by lane
+  LaneVal ret = lhs;
+  bool is_div = ast.op() == Operator::Div;
+  for (std::size_t i = 0; i < kLaneNum; ++i) {
+    if (!(active_ & LaneBit(i))) continue;
+    auto l = lhs.vals[i], r = rhs.vals[i];
+    if (!r) {
+      Fail(LaneBit(i));
+    }
+    else if (r == -1) {
+      // 'INT_MIN / -1' wraps around like other operators
+      ret.vals[i] = is_div ? static_cast<int>(0u - l) : 0;
+    }
+    else {
+      ret.vals[i] = is_div ? l / r : l % r;
+    }
+  }
+  return ret;
+}
+
+LaneVal LaneInterpreter::CallLibFunction(const FunCallAST &ast) {
+  LaneVal ret = {};
+  if (ast.target() == CallTarget::Input) {
+    // read an integer from the inputs of every lane
+    for (std::size_t i = 0; i < kLaneNum; ++i) {
+      if (active_ & LaneBit(i)) ret.vals[i] = io_[i]->ReadInt();
+    }
+  }
+  else {
+    assert(ast.target() == CallTarget::Print && "not a library call");
+    auto arg = ast.args()[0]->EvalLanes(*this);
+    for (std::size_t i = 0; i < kLaneNum; ++i) {
+      if (active_ & LaneBit(i)) io_[i]->WriteInt(arg.vals[i]);
+    }
+  }
+  return ret;
+}
+
+LaneVal LaneInterpreter::CallLockstep(const FunCallAST &ast) {
+  const auto &def = *ast.callee();
+  // lanes that can not go deeper continue on the scalar interpreter,
+  // which evaluates tail calls in place and switches to new stack
+  // segments, so deep programs are not evaluated twice
+  if (depth_ >= max_depth_ || native_stack_.IsLow()) {
+    return CallScalar(ast);
+  }
+  // allocate frame of callee on the top of stack
+  auto base = frame_top_;
+  GrowFrame(def.frame_size());
+  // evaluate arguments in the frame of caller
+  for (std::size_t i = 0; i < ast.args().size(); ++i) {
+    auto arg = ast.args()[i]->EvalLanes(*this);
+    stack_[base + i] = arg;
+  }
+  LaneVal ret = {};
+  if (active_) {
+    // call the specific function
+    auto last_base = frame_base_;
+    frame_base_ = base;
+    ++depth_;
+    ret = def.EvalLanes(*this);
+    --depth_;
+    frame_base_ = last_base;
+  }
+  frame_top_ = base;
+  return ret;
+}
+
+LaneVal LaneInterpreter::TailCall(const FunCallAST &ast) {
+  const auto &def = *ast.callee();
+  // evaluate arguments on the top of stack
+  auto top = frame_top_;
+  GrowFrame(ast.args().size());
+  for (std::size_t i = 0; i < ast.args().size(); ++i) {
+    auto arg = ast.args()[i]->EvalLanes(*this);
+    stack_[top + i] = arg;
+  }
+  // replace the current frame with the frame of callee
+  std::copy_n(stack_.begin() + top, ast.args().size(),
+              stack_.begin() + frame_base_);
+  frame_top_ = frame_base_;
+  GrowFrame(def.frame_size());
+  // exit the current function, and let the caller evaluate callee
+  if (active_) tail_callee_ = &def;
+  tail_lanes_ = active_;
+  returned_ |= active_;
+  active_ = 0;
+  return {};
+}
+
+LaneVal LaneInterpreter::CallScalar(const FunCallAST &ast) {
+  const auto &def = *ast.callee();
+  // evaluate arguments of all lanes on the top of stack
+  auto top = frame_top_;
+  GrowFrame(ast.args().size());
+  for (std::size_t i = 0; i < ast.args().size(); ++i) {
+    auto arg = ast.args()[i]->EvalLanes(*this);
+    stack_[top + i] = arg;
+  }
+  // call the specific function lane by lane
+  LaneVal ret = {};
+  auto &args = scalar_args_;
+  args.resize(ast.args().size());
+  for (std::size_t i = 0; i < kLaneNum; ++i) {
+    if (!(active_ & LaneBit(i))) continue;
+    for (std::size_t j = 0; j < args.size(); ++j) {
+      args[j] = stack_[top + j].vals[i];
+    }
+    intp_.set_io(*io_[i]);
+    auto val = intp_.Call(def, args.data(), depth_);
+    if (val) {
+      ret.vals[i] = *val;
+    }
+    else {
+      Fail(LaneBit(i));
+      err_.str({});
+    }
+  }
+  frame_top_ = top;
+  return ret;
+}
+
+LaneVal LaneInterpreter::EvalOn(const FunDefAST &ast) {
+  // frame has been set up by caller
+  auto entry = active_, last_entry = entry_, last_returned = returned_;
+  auto last_ret = ret_;
+  entry_ = entry;
+  returned_ = 0;
+  // evaluate function body, then bodies of tail calls in the same frame
+  for (auto func = &ast; func; func = std::exchange(tail_callee_, {})) {
+    func->body()->EvalLanes(*this);
+    // lanes that made the tail call have not returned yet
+    if (tail_callee_) {
+      returned_ &= ~tail_lanes_;
+      active_ = tail_lanes_;
+    }
+  }
+  // lanes that have not returned have no return value
+  Fail(entry & ~returned_ & ~failed_);
+  active_ = entry & ~failed_;
+  auto ret = ret_;
+  ret_ = last_ret;
+  entry_ = last_entry;
+  returned_ = last_returned;
+  return ret;
+}
+
+LaneVal LaneInterpreter::EvalOn(const BlockAST &ast) {
+  // evaluate all statements in block
+  for (const auto &stmt : ast.stmts()) {
+    stmt->EvalLanes(*this);
+    // stop if all lanes have failed or returned
+    if (!active_) break;
+  }
+  return {};
+}
+
+LaneVal LaneInterpreter::EvalOn(const DefineAST &ast) {
+  auto expr = ast.expr()->EvalLanes(*this);
+  ops_.blend(stack_[frame_base_ + ast.slot()], expr, active_);
+  return {};
+}
+
+LaneVal LaneInterpreter::EvalOn(const AssignAST &ast) {
+  auto expr = ast.expr()->EvalLanes(*this);
+  ops_.blend(stack_[frame_base_ + ast.slot()], expr, active_);
+  return {};
+}
+
+LaneVal LaneInterpreter::EvalOn(const IfAST &ast) {
+  auto entry = active_;
+  // walk through the 'else if' chain, 'rest' holds lanes that have not
+  // taken any branch
+  auto rest = entry;
+  for (auto if_else = &ast; if_else && rest; if_else = if_else->else_if()) {
+    active_ = rest;
+    auto cond = if_else->cond()->EvalLanes(*this);
+    rest = active_;
+    auto taken = ops_.non_zero(cond) & rest;
+    rest &= ~taken;
+    if (taken) {
+      // evaluate the true branch
+      active_ = taken;
+      if_else->then()->EvalLanes(*this);
+    }
+    if (if_else->else_then()) {
+      // evaluate the false branch
+      if (rest) {
+        active_ = rest;
+        if_else->else_then()->EvalLanes(*this);
+      }
+      break;
+    }
+  }
+  // lanes join again after the statement
+  active_ = entry & ~returned_ & ~failed_;
+  return {};
+}
+
+LaneVal LaneInterpreter::EvalOn(const ReturnAST &ast) {
+  // tail calls run in the same frame only if all remaining lanes of
+  // the function make them, otherwise the frame may still be used by
+  // lanes of other branches
+  if (ast.tail_call() && active_ == (entry_ & ~returned_ & ~failed_) &&
+      LaneCount(active_) >= kMinLockstepLanes) {
+    return TailCall(*ast.tail_call());
+  }
+  auto expr = ast.expr()->EvalLanes(*this);
+  // exit the current function
+  ops_.blend(ret_, expr, active_);
+  returned_ |= active_;
+  active_ = 0;
+  return {};
+}
+
+LaneVal LaneInterpreter::EvalOn(const BinaryAST &ast) {
+  // check if is logical operator
+  if (ast.op() == Operator::LAnd || ast.op() == Operator::LOr) {
+    auto entry = active_;
+    // evaluate lhs first
+    auto ret = ast.lhs()->EvalLanes(*this);
+    auto non_zero = ops_.non_zero(ret);
+    // then evaluate rhs of lanes that are not short-circuited
+    auto rest = active_ & (ast.op() == Operator::LAnd ? non_zero
+                                                      : ~non_zero);
+    if (rest) {
+      active_ = rest;
+      auto rhs = ast.rhs()->EvalLanes(*this);
+      ops_.blend(ret, rhs, active_);
+      active_ = entry & ~failed_;
+    }
+    return ret;
+  }
+  // evaluate the lhs & rhs
+  auto lhs = ast.lhs()->EvalLanes(*this);
+  auto rhs = ast.rhs()->EvalLanes(*this);
+  // perform binary operation
+  LaneVal ret;
+  switch (ast.op()) {
+    case Operator::Add: ops_.add(lhs, rhs, ret); break;
+    case Operator::Sub: ops_.sub(lhs, rhs, ret); break;
+    case Operator::Mul: ops_.mul(lhs, rhs, ret); break;
+    case Operator::Div: case Operator::Mod:
+      return EvalDivMod(ast, lhs, rhs);
+    case Operator::Less: ops_.lt(lhs, rhs, ret); break;
+    case Operator::LessEq: ops_.le(lhs, rhs, ret); break;
+    case Operator::Eq: ops_.eq(lhs, rhs, ret); break;
+    case Operator::NotEq: ops_.ne(lhs, rhs, ret); break;
+    default: assert(false && "unknown binary operator");
+  }
+  return ret;
+}
+
+LaneVal LaneInterpreter::EvalOn(const UnaryAST &ast) {
+  // evaluate the operand
+  auto opr = ast.opr()->EvalLanes(*this);
+  // perform unary operation
+  LaneVal ret;
+  switch (ast.op()) {
+    case Operator::Sub: ops_.neg(opr, ret); break;
+    case Operator::LNot: ops_.lnot(opr, ret); break;
+    default: assert(false && "unknown unary operator");
+  }
+  return ret;
+}
+
+LaneVal LaneInterpreter::EvalOn(const FunCallAST &ast) {
+  if (!active_) return {};
+  // dispatch by the target linked by resolver
+  switch (ast.target()) {
+    case CallTarget::Function: break;
+    case CallTarget::Input: case CallTarget::Print:
+      return CallLibFunction(ast);
+    default: Fail(active_); return {};
+  }
+  // inactive lanes are masked out in lockstep, so it is worth it as
+  // long as enough lanes make the call, otherwise call lane by lane
+  if (LaneCount(active_) >= kMinLockstepLanes) return CallLockstep(ast);
+  return CallScalar(ast);
+}
+
+LaneVal LaneInterpreter::EvalOn(const IntAST &ast) {
+  LaneVal ret;
+  std::fill_n(ret.vals, kLaneNum, ast.val());
+  return ret;
+}
+
+LaneVal LaneInterpreter::EvalOn(const IdAST &ast) {
+  return stack_[frame_base_ + ast.slot()];
+}
@@ -0,0 +1,108 @@
+#ifndef FIRSTSTEP_BACK_LANES_LANES_H_
+#define FIRSTSTEP_BACK_LANES_LANES_H_
+
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstddef>
+
+#include "define/ast.h"
+#include "back/lanes/kernels.h"
+#include "back/interpreter/interpreter.h"
+#include "back/interpreter/stack.h"
+#include "back/runtime/io.h"
+
+// interpreter that evaluates up to 'kLaneNum' instances of a program
+// in lockstep, every lane runs the program with its own inputs
+// variables hold the values of all lanes, divergent branches and
+// calls are evaluated under masks of active lanes, calls made by only
+// a few lanes or too deep for lockstep are evaluated lane by lane on
+// a scalar interpreter
+// lanes that fail are reported to the caller, which should evaluate
+// them again to get the exact diagnostics, so this interpreter never
+// reports errors
+class LaneInterpreter {
+ public:
+  // min count of active lanes for calls to stay in lockstep
+  static constexpr std::size_t kMinLockstepLanes = 2;
+
+  // all functions must have been resolved to frames by 'Resolver'
+  explicit LaneInterpreter(const std::vector<ASTPtr> &funcs);
+
+  // evaluate the program for the specific inputs, at most 'kLaneNum',
+  // return values and outputs of lanes are stored in 'rets' and
+  // 'outputs', returns the mask of failed lanes
+  LaneMask Eval(const std::string_view *inputs, std::size_t num,
+                int *rets, std::string *outputs);
+
+  // visitor methods
+  LaneVal EvalOn(const FunDefAST &ast);
+  LaneVal EvalOn(const BlockAST &ast);
+  LaneVal EvalOn(const DefineAST &ast);
+  LaneVal EvalOn(const AssignAST &ast);
+  LaneVal EvalOn(const IfAST &ast);
+  LaneVal EvalOn(const ReturnAST &ast);
+  LaneVal EvalOn(const BinaryAST &ast);
+  LaneVal EvalOn(const UnaryAST &ast);
+  LaneVal EvalOn(const FunCallAST &ast);
+  LaneVal EvalOn(const IntAST &ast);
+  LaneVal EvalOn(const IdAST &ast);
+
+  // set max depth of calls
+  void set_max_depth(std::size_t max_depth) {
+    max_depth_ = max_depth;
+    intp_.set_max_depth(max_depth);
+  }
+
+ private:
+  // mark the specific lanes as failed
+  void Fail(LaneMask mask) {
+    failed_ |= mask;
+    active_ &= ~mask;
+  }
+  // grow the current frame by the specific count of slots
+  void GrowFrame(std::size_t size);
+  // perform division or modulo of active lanes
+  LaneVal EvalDivMod(const BinaryAST &ast, const LaneVal &lhs,
+                     const LaneVal &rhs);
+  // perform library function call
+  LaneVal CallLibFunction(const FunCallAST &ast);
+  // call the linked function of all active lanes in lockstep
+  LaneVal CallLockstep(const FunCallAST &ast);
+  // replace the current frame of all active lanes with a tail callee
+  LaneVal TailCall(const FunCallAST &ast);
+  // call the linked function of every active lane on scalar interpreter
+  LaneVal CallScalar(const FunCallAST &ast);
+
+  // kernels of the best instruction set extension
+  const LaneFuncs &ops_;
+  // the 'main' function, null if not found
+  const FunDefAST *main_;
+  // lanes of the current evaluation, lanes running the current
+  // statement, failed lanes, and lanes returned from the current function
+  LaneMask live_, active_, failed_, returned_;
+  // lanes that entered the current function
+  LaneMask entry_;
+  // lanes making the last tail call, and the callee
+  LaneMask tail_lanes_;
+  const FunDefAST *tail_callee_;
+  // frames of all functions, and the frame of the current function
+  std::vector<LaneVal> stack_;
+  std::size_t frame_base_, frame_top_;
+  // return values of the current function
+  LaneVal ret_;
+  // max depth and current depth of calls
+  std::size_t max_depth_, depth_;
+  // native stack, lanes fail instead of switching to a new segment
+  SegmentedStack native_stack_;
+  // I/O of all lanes
+  std::optional<RuntimeIO> io_[kLaneNum];
+  // interpreter of divergent calls, its arguments and error messages
+  Interpreter intp_;
+  std::vector<int> scalar_args_;
+  std::ostringstream err_;
+};
+
+#endif  // FIRSTSTEP_BACK_LANES_LANES_H_
@@ -0,0 +1,234 @@
+#include "back/resolver/resolver.h"
+
+bool Resolver::Resolve(const std::vector<ASTPtr> &funcs) {
+  // get definitions of all functions
+  for (const auto &func : funcs) {
+    if (!func) continue;
+    auto def = static_cast<const FunDefAST *>(func);
+    if (def->name() >= funcs_.size()) funcs_.resize(def->name() + 1);
+    funcs_[def->name()] = def;
+  }
+  // resolve all functions
+  for (const auto &func : funcs) {
+    if (func) func->Resolve(*this);
+  }
+  PropagateImpurity();
+  MarkForkable();
+  return is_resolved_;
+}
+
+void Resolver::Unresolvable(std::string_view reason) {
+  // functions that depend on the dynamic environment are not pure
+  func_->set_is_pure(false);
+  if (!is_resolved_) return;
+  is_resolved_ = false;
+  reason_ = reason;
+}
+
+void Resolver::LinkCall(FunCallAST &ast) const {
+  auto arg_num = ast.args().size();
+  // library functions take precedence over defined functions
+  if (ast.name() == kSymInput) {
+    ast.set_target(arg_num == 0 ? CallTarget::Input
+                                : CallTarget::ArgCountMismatch);
+  }
+  else if (ast.name() == kSymPrint) {
+    ast.set_target(arg_num == 1 ? CallTarget::Print
+                                : CallTarget::ArgCountMismatch);
+  }
+  else if (ast.name() >= funcs_.size() || !funcs_[ast.name()]) {
+    ast.set_target(CallTarget::NotFound);
+  }
+  else if (arg_num != funcs_[ast.name()]->args().size()) {
+    ast.set_target(CallTarget::ArgCountMismatch);
+  }
+  else {
+    ast.set_target(CallTarget::Function, funcs_[ast.name()]);
+  }
+}
+
+bool Resolver::LookUpVar(SymbolId name, Slot &slot) const {
+  for (auto it = vars_.rbegin(); it != vars_.rend(); ++it) {
+    if (it->first == name) {
+      slot = it->second;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool Resolver::DefineVar(SymbolId name, Slot &slot) {
+  for (auto i = block_base_; i < vars_.size(); ++i) {
+    if (vars_[i].first == name) return false;
+  }
+  slot = next_slot_++;
+  if (next_slot_ > frame_size_) frame_size_ = next_slot_;
+  vars_.push_back({name, slot});
+  return true;
+}
+
+void Resolver::PropagateImpurity() {
+  // sort calls by callee, so callers of a function are adjacent
+  std::sort(calls_.begin(), calls_.end(),
+            [](const auto &l, const auto &r) { return l.first < r.first; });
+  // walk from impure functions to their callers
+  std::vector<SymbolId> impure;
+  for (const auto &func : funcs_) {
+    if (func && !func->is_pure()) impure.push_back(func->name());
+  }
+  while (!impure.empty()) {
+    auto callee = impure.back();
+    impure.pop_back();
+    auto it = std::lower_bound(
+        calls_.begin(), calls_.end(), callee,
+        [](const auto &call, SymbolId id) { return call.first < id; });
+    for (; it != calls_.end() && it->first == callee; ++it) {
+      if (!it->second->is_pure()) continue;
+      it->second->set_is_pure(false);
+      impure.push_back(it->second->name());
+    }
+  }
+  calls_.clear();
+}
+
+void Resolver::MarkForkable() {
+  for (const auto &fork : forks_) {
+    bool is_pure = std::all_of(
+        callees_.begin() + fork.begin, callees_.begin() + fork.end,
+        [](const FunDefAST *callee) { return callee->is_pure(); });
+    fork.ast->set_is_forkable(is_pure);
+  }
+  forks_.clear();
+  callees_.clear();
+}
+
+void Resolver::ResolveOn(FunDefAST &ast) {
+  func_ = &ast;
+  ast.set_is_pure(true);
+  vars_.clear();
+  block_base_ = 0;
+  next_slot_ = frame_size_ = 0;
+  branch_num_ = 0;
+  // 'main' function is called without an argument environment,
+  // so its arguments are defined only when called by other functions
+  if (ast.name() == kSymMain && !ast.args().empty()) {
+    Unresolvable("'main' function has parameters");
+  }
+  // arguments are stored in the first slots
+  for (const auto &arg : ast.args()) {
+    Slot slot;
+    if (!DefineVar(arg, slot)) Unresolvable("redefinition of argument");
+  }
+  ast.body()->Resolve(*this);
+  ast.set_frame_size(frame_size_);
+}
+
+void Resolver::ResolveOn(BlockAST &ast) {
+  // enter a new scope
+  auto last_base = block_base_;
+  auto slot_base = next_slot_;
+  block_base_ = vars_.size();
+  for (const auto &stmt : ast.stmts()) stmt->Resolve(*this);
+  // exit the current scope, slots of variables can be reused
+  vars_.resize(block_base_);
+  block_base_ = last_base;
+  next_slot_ = slot_base;
+}
+
+void Resolver::ResolveOn(DefineAST &ast) {
+  // the expression can not see the variable being defined
+  ast.expr()->Resolve(*this);
+  Slot slot;
+  if (!DefineVar(ast.name(), slot)) {
+    return Unresolvable("symbol has already been defined");
+  }
+  ast.set_slot(slot);
+}
+
+void Resolver::ResolveOn(AssignAST &ast) {
+  ast.expr()->Resolve(*this);
+  Slot slot;
+  if (!LookUpVar(ast.name(), slot)) {
+    return Unresolvable("assigning to non-local variable");
+  }
+  ast.set_slot(slot);
+}
+
+void Resolver::ResolveOn(IfAST &ast) {
+  for (auto if_else = &ast; if_else; if_else = if_else->else_if()) {
+    if_else->set_index(branch_num_++);
+    if_else->cond()->Resolve(*this);
+    if_else->then()->Resolve(*this);
+    if (if_else->else_then()) if_else->else_then()->Resolve(*this);
+  }
+}
+
+void Resolver::ResolveOn(ReturnAST &ast) {
+  ast.set_tail_call(nullptr);
+  ret_ = &ast;
+  ast.expr()->Resolve(*this);
+  ret_ = nullptr;
+}
+
+void Resolver::ResolveOn(BinaryAST &ast) {
+  ast.set_is_forkable(false);
+  auto begin = callees_.size();
+  auto has_lib_call = std::exchange(has_lib_call_, false);
+  ast.lhs()->Resolve(*this);
+  auto mid = callees_.size();
+  ast.rhs()->Resolve(*this);
+  // logical operators are never forked, since they short-circuit
+  if (ast.op() != Operator::LAnd && ast.op() != Operator::LOr &&
+      !has_lib_call_ && begin < mid && mid < callees_.size()) {
+    forks_.push_back({&ast, begin, callees_.size()});
+  }
+  has_lib_call_ |= has_lib_call;
+}
+
+void Resolver::ResolveOn(UnaryAST &ast) { ast.opr()->Resolve(*this); }
+
+void Resolver::ResolveOn(FunCallAST &ast) {
+  LinkCall(ast);
+  // record calls for purity analysis
+  if (ast.target() == CallTarget::Function) {
+    calls_.push_back({ast.callee()->name(), func_});
+    callees_.push_back(ast.callee());
+    // check if is the whole expression of return statement
+    if (ret_ && ret_->expr() == &ast) ret_->set_tail_call(&ast);
+  }
+  else {
+    func_->set_is_pure(false);
+    has_lib_call_ = true;
+  }
+  // arguments of library functions are evaluated in the current
+  // environment, and arguments of mismatched calls are never evaluated
+  if (ast.target() != CallTarget::Function) {
+    for (const auto &arg : ast.args()) arg->Resolve(*this);
+    return;
+  }
+  const auto &params = ast.callee()->args();
+  for (std::size_t i = 0; i < ast.args().size(); ++i) {
+    // parameters that have been evaluated shadow other variables
+    shadows_.push_back({params.begin(), i});
+    ast.args()[i]->Resolve(*this);
+    shadows_.pop_back();
+  }
+}
+
+void Resolver::ResolveOn(IntAST &ast) {}
+
+void Resolver::ResolveOn(IdAST &ast) {
+  // check if the variable is shadowed by parameters of callees
+  for (const auto &params : shadows_) {
+    for (const auto &param : params) {
+      if (param == ast.id()) {
+        return Unresolvable("reading argument of callee");
+      }
+    }
+  }
+  Slot slot;
+  if (!LookUpVar(ast.id(), slot)) {
+    return Unresolvable("reading non-local variable");
+  }
+  ast.set_slot(slot);
+}
@@ -0,0 +1,100 @@
+#ifndef FIRSTSTEP_BACK_RESOLVER_RESOLVER_H_
+#define FIRSTSTEP_BACK_RESOLVER_RESOLVER_H_
+
+#include <string_view>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+
+#include "define/ast.h"
+#include "define/symbol.h"
+
+// resolver of variables and function calls
+// every function call is linked to its target, and every argument and
+// local variable is assigned a fixed slot in the frame of its function
+// calls of defined functions in return statements are marked as tail calls
+// branches of every function are numbered in source order
+// resolvable functions that never reach library functions or unlinked
+// calls, directly or transitively, are marked as pure
+// arithmetic expressions whose operands both call pure functions only
+// are marked as forkable
+// variables are resolved lexically, so programs whose behavior depends
+// on the dynamic environment of the interpreter (e.g. reading variables
+// of callers) can not be resolved, and must be run with environments
+class Resolver {
+ public:
+  Resolver() : is_resolved_(true), ret_(nullptr), has_lib_call_(false) {}
+
+  // resolve the specific function definitions, null pointers are ignored
+  // function calls are always linked, returns false if variables of
+  // the program can not be resolved
+  bool Resolve(const std::vector<ASTPtr> &funcs);
+
+  // visitor methods
+  void ResolveOn(FunDefAST &ast);
+  void ResolveOn(BlockAST &ast);
+  void ResolveOn(DefineAST &ast);
+  void ResolveOn(AssignAST &ast);
+  void ResolveOn(IfAST &ast);
+  void ResolveOn(ReturnAST &ast);
+  void ResolveOn(BinaryAST &ast);
+  void ResolveOn(UnaryAST &ast);
+  void ResolveOn(FunCallAST &ast);
+  void ResolveOn(IntAST &ast);
+  void ResolveOn(IdAST &ast);
+
+  // reason why the program can not be resolved
+  std::string_view reason() const { return reason_; }
+
+ private:
+  // binary expression that may be forked, with its range of callees
+  struct Fork {
+    BinaryAST *ast;
+    std::size_t begin, end;
+  };
+
+  // mark the program as unresolvable, keeps the first reason
+  void Unresolvable(std::string_view reason);
+  // link the specific function call to its target
+  void LinkCall(FunCallAST &ast) const;
+  // look up the slot of the specific variable, returns false if not found
+  bool LookUpVar(SymbolId name, Slot &slot) const;
+  // define a new variable in the current block
+  bool DefineVar(SymbolId name, Slot &slot);
+  // mark callers of impure functions as impure
+  void PropagateImpurity();
+  // mark binary expressions whose callees are all pure as forkable
+  void MarkForkable();
+
+  bool is_resolved_;
+  std::string_view reason_;
+  // all function definitions, indexed by symbol id
+  std::vector<const FunDefAST *> funcs_;
+  // defined variables and their slots, from outer to inner
+  std::vector<std::pair<SymbolId, Slot>> vars_;
+  // index of the first variable in the current block
+  std::size_t block_base_;
+  // parameters of callees that shadow variables when evaluating
+  // arguments, just like the argument environment of the interpreter
+  std::vector<IdList> shadows_;
+  // next free slot, and frame size of the current function
+  Slot next_slot_, frame_size_;
+  // count of branches in the current function
+  std::uint32_t branch_num_;
+  // the current function, and the current return statement
+  FunDefAST *func_;
+  ReturnAST *ret_;
+  // all calls between defined functions, as pairs of (callee, caller)
+  std::vector<std::pair<SymbolId, FunDefAST *>> calls_;
+  // callees of defined functions in the order of resolving, and
+  // whether library functions or unlinked calls have been reached
+  // in the current expression
+  std::vector<const FunDefAST *> callees_;
+  bool has_lib_call_;
+  // candidates of forkable expressions
+  std::vector<Fork> forks_;
+};
+
+#endif  // FIRSTSTEP_BACK_RESOLVER_RESOLVER_H_
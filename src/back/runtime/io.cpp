@@ -0,0 +1,172 @@
+#include "back/runtime/io.h"
+
+#include <cstring>
+#include <cstdint>
+#include <climits>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define FIRSTSTEP_USE_UNISTD
+#include <unistd.h>
+#include <cerrno>
+#else
+#include <cstdio>
+#endif
+
+namespace {
+
+bool IsSpace(int c) { return c == ' ' || (c >= '\t' && c <= '\r'); }
+
+bool IsDigit(int c) { return c >= '0' && c <= '9'; }
+
+}  // namespace
+
+RuntimeIO::RuntimeIO()
+    : use_stdin_(true), is_pushed_(false), is_closed_(false),
+      failed_(false), in_buf_(new char[kBufferSize]), in_pos_(nullptr),
+      in_end_(nullptr), out_buf_(new char[kBufferSize]),
+      out_size_(kBufferSize), out_len_(0), output_(nullptr) {
+#ifdef FIRSTSTEP_USE_UNISTD
+  is_interactive_ = isatty(STDIN_FILENO);
+#else
+  // terminal can not be detected, always flush before reading
+  is_interactive_ = true;
+#endif
+}
+
+RuntimeIO::RuntimeIO(std::string_view input, std::string &output)
+    : use_stdin_(false), is_interactive_(false), is_pushed_(false),
+      is_closed_(false), failed_(false), in_pos_(input.data()),
+      in_end_(input.data() + input.size()),
+      out_buf_(new char[kBufferSize]), out_size_(kBufferSize),
+      out_len_(0), output_(&output) {}
+
+RuntimeIO::RuntimeIO(std::string &output)
+    : use_stdin_(false), is_interactive_(false), is_pushed_(true),
+      is_closed_(false), failed_(false), in_pos_(nullptr),
+      in_end_(nullptr), out_buf_(new char[kPushBufferSize]),
+      out_size_(kPushBufferSize), out_len_(0), output_(&output) {}
+
+int RuntimeIO::ReadInt() {
+  if (failed_) return 0;
+  // skip spaces
+  auto c = Peek();
+  while (IsSpace(c)) {
+    ++in_pos_;
+    c = Peek();
+  }
+  // read sign
+  bool is_neg = c == '-';
+  if (c == '-' || c == '+') {
+    ++in_pos_;
+    c = Peek();
+  }
+  if (!IsDigit(c)) {
+    failed_ = true;
+    return 0;
+  }
+  // read digits, saturate on overflow
+  std::int64_t val = 0;
+  std::int64_t max = is_neg ? -static_cast<std::int64_t>(INT_MIN)
+                            : INT_MAX;
+  do {
+    if (val <= max) val = val * 10 + (c - '0');
+    ++in_pos_;
+    c = Peek();
+  } while (IsDigit(c));
+  if (val > max) {
+    failed_ = true;
+    val = max;
+  }
+  return static_cast<int>(is_neg ? -val : val);
+}
+
+void RuntimeIO::PushInput(std::string_view data) {
+  // drop consumed inputs
+  if (in_pos_) pushed_.erase(0, in_pos_ - pushed_.data());
+  pushed_.append(data);
+  in_pos_ = pushed_.data();
+  in_end_ = in_pos_ + pushed_.size();
+}
+
+bool RuntimeIO::IsInputReady() const {
+  if (!is_pushed_ || is_closed_ || failed_) return true;
+  // an integer is complete if it is followed by any other character
+  auto pos = in_pos_;
+  while (pos != in_end_ && IsSpace(*pos)) ++pos;
+  if (pos != in_end_ && (*pos == '-' || *pos == '+')) ++pos;
+  if (pos == in_end_) return false;
+  // reading non-digits fails immediately
+  if (!IsDigit(*pos)) return true;
+  while (pos != in_end_ && IsDigit(*pos)) ++pos;
+  return pos != in_end_;
+}
+
+void RuntimeIO::Flush() {
+  if (!out_len_) return;
+  if (output_) {
+    output_->append(out_buf_.get(), out_len_);
+  }
+  else {
+    // write errors (e.g. closed pipes) are ignored, just like 'std::cout'
+#ifdef FIRSTSTEP_USE_UNISTD
+    auto data = out_buf_.get();
+    auto len = out_len_;
+    while (len) {
+      auto ret = write(STDOUT_FILENO, data, len);
+      if (ret < 0) {
+        if (errno == EINTR) continue;
+        break;
+      }
+      data += ret;
+      len -= ret;
+    }
+#else
+    std::fwrite(out_buf_.get(), 1, out_len_, stdout);
+    std::fflush(stdout);
+#endif
+  }
+  out_len_ = 0;
+}
+
+std::size_t RuntimeIO::FormatInt(int val, char *buf) {
+  // write digits from back to front
+  char digits[kMaxIntLen];
+  auto end = digits + kMaxIntLen, p = end;
+  *--p = '\n';
+  auto abs = val < 0 ? 0u - static_cast<unsigned>(val)
+                     : static_cast<unsigned>(val);
+  do {
+    *--p = '0' + abs % 10;
+    abs /= 10;
+  } while (abs);
+  if (val < 0) *--p = '-';
+  std::memcpy(buf, p, end - p);
+  return end - p;
+}
+
+bool RuntimeIO::Refill() {
+  if (!use_stdin_) return false;
+  // make sure prompts are visible before waiting for user inputs
+  if (is_interactive_) Flush();
+#ifdef FIRSTSTEP_USE_UNISTD
+  ssize_t len;
+  do {
+    len = read(STDIN_FILENO, in_buf_.get(), kBufferSize);
+  } while (len < 0 && errno == EINTR);
+  if (len <= 0) return use_stdin_ = false;
+#else
+  // read line by line, so that terminals are not blocked
+  if (!std::fgets(in_buf_.get(), kBufferSize, stdin)) {
+    return use_stdin_ = false;
+  }
+  auto len = std::strlen(in_buf_.get());
+#endif
+  in_pos_ = in_buf_.get();
+  in_end_ = in_pos_ + len;
+  return true;
+}
+
+RuntimeIO &GetStdIO() {
+  static RuntimeIO io;
+  return io;
+}
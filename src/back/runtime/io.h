@@ -0,0 +1,92 @@
+#ifndef FIRSTSTEP_BACK_RUNTIME_IO_H_
+#define FIRSTSTEP_BACK_RUNTIME_IO_H_
+
+#include <string>
+#include <string_view>
+#include <memory>
+#include <cstddef>
+
+// buffered integer I/O of library functions 'input' and 'print'
+// inputs are read in blocks and parsed by hand, outputs are formatted
+// by hand and written when the buffer is full, when reading inputs from
+// an interactive terminal, or when flushed explicitly
+class RuntimeIO {
+ public:
+  // size of input and output buffers
+  static constexpr std::size_t kBufferSize = 1 << 16;
+  // size of output buffer with pushed inputs
+  static constexpr std::size_t kPushBufferSize = 256;
+  // max size of outputs that have not been consumed with pushed inputs
+  static constexpr std::size_t kMaxPendingOutput = 4096;
+
+  // use stdin and stdout
+  RuntimeIO();
+  // read from the specific string, and append outputs to another string
+  RuntimeIO(std::string_view input, std::string &output);
+  // read from inputs pushed by 'PushInput', and append outputs to
+  // the specific string, which should be consumed by the caller
+  // reading never waits, callers must check 'IsInputReady' first
+  explicit RuntimeIO(std::string &output);
+  ~RuntimeIO() { Flush(); }
+
+  RuntimeIO(const RuntimeIO &) = delete;
+  RuntimeIO &operator=(const RuntimeIO &) = delete;
+
+  // read an integer, behaves like 'std::cin >> val'
+  // returns 0 on failure, and all later reads will fail
+  int ReadInt();
+  // write an integer followed by a new line
+  void WriteInt(int val) {
+    if (out_len_ + kMaxIntLen > out_size_) Flush();
+    out_len_ += FormatInt(val, out_buf_.get() + out_len_);
+  }
+  // write all buffered outputs
+  void Flush();
+
+  // append pushed inputs
+  void PushInput(std::string_view data);
+  // mark the end of pushed inputs
+  void CloseInput() { is_closed_ = true; }
+  // check if 'ReadInt' can return without more pushed inputs,
+  // always true if inputs are not pushed
+  bool IsInputReady() const;
+  // check if outputs should be consumed before writing more,
+  // always false if inputs are not pushed
+  bool IsOutputFull() const {
+    return is_pushed_ && output_->size() + out_len_ >= kMaxPendingOutput;
+  }
+
+ private:
+  // max length of a formatted integer, including sign and new line
+  static constexpr std::size_t kMaxIntLen = 12;
+
+  // format an integer followed by a new line, returns length
+  static std::size_t FormatInt(int val, char *buf);
+  // read the next block of inputs, returns false at the end of inputs
+  bool Refill();
+  // get the current character of inputs, returns -1 at the end of inputs
+  int Peek() {
+    if (in_pos_ == in_end_ && !Refill()) return -1;
+    return static_cast<unsigned char>(*in_pos_);
+  }
+
+  // set if more inputs can be read from stdin, or stdin is a terminal
+  bool use_stdin_, is_interactive_;
+  // set if inputs are pushed, and if the end of inputs has been pushed
+  bool is_pushed_, is_closed_;
+  // set if the last read has failed
+  bool failed_;
+  // input buffer and unread inputs
+  std::unique_ptr<char[]> in_buf_;
+  std::string pushed_;
+  const char *in_pos_, *in_end_;
+  // output buffer, and the string outputs appended to (or null)
+  std::unique_ptr<char[]> out_buf_;
+  std::size_t out_size_, out_len_;
+  std::string *output_;
+};
+
+// get the I/O of stdin and stdout, which is flushed at exit
+RuntimeIO &GetStdIO();
+
+#endif  // FIRSTSTEP_BACK_RUNTIME_IO_H_
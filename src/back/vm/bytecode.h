@@ -0,0 +1,61 @@
+#ifndef FIRSTSTEP_BACK_VM_BYTECODE_H_
+#define FIRSTSTEP_BACK_VM_BYTECODE_H_
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// all opcodes of the register bytecode
+// 'a', 'b' and 'c' are operands of instruction, 'rX' means register 'X'
+#define FIRSTSTEP_OPCODES(e) \
+  e(Imm)    /* ra = int(b) */ \
+  e(Mov)    /* ra = rb */ \
+  e(Add) e(Sub) e(Mul) e(Div) e(Mod) \
+  e(Less) e(LessEq) e(Eq) e(NotEq)  /* ra = rb op rc */ \
+  e(Neg) e(Not)  /* ra = op rb */ \
+  e(Jmp)    /* goto b */ \
+  e(Jz)     /* if !ra goto b */ \
+  e(Jnz)    /* if ra goto b */ \
+  e(Call)   /* ra = funcs[c](rb, rb+1, ...) */ \
+  e(TailCall)  /* return funcs[c](rb, rb+1, ...), reuses frame */ \
+  e(Ret)    /* return ra */ \
+  e(Input)  /* ra = input() */ \
+  e(Print)  /* print(ra) */
+
+// expand opcodes to comma-separated list
+#define FIRSTSTEP_EXPAND_OPCODE(op) op,
+
+enum class Opcode : std::uint8_t {
+  FIRSTSTEP_OPCODES(FIRSTSTEP_EXPAND_OPCODE)
+};
+
+// register index of bytecode
+using Reg = std::uint16_t;
+
+// bytecode instruction, 12 bytes
+struct Inst {
+  Opcode op;
+  Reg a;
+  // register, immediate, jump target or function index
+  std::uint32_t b, c;
+};
+
+// function of bytecode
+struct BytecodeFunc {
+  // index of the first instruction
+  std::uint32_t entry;
+  // count of parameters, which are stored in the first registers
+  Reg param_num;
+  // count of registers used by function
+  std::uint32_t reg_num;
+};
+
+// bytecode of the whole program
+struct Bytecode {
+  std::vector<Inst> code;
+  std::vector<BytecodeFunc> funcs;
+  // index of the 'main' function
+  std::uint32_t main;
+};
+
+#endif  // FIRSTSTEP_BACK_VM_BYTECODE_H_
@@ -0,0 +1,289 @@
+#include "back/vm/codegen.h"
+
+#include "back/resolver/resolver.h"
+
+#include <limits>
+#include <cassert>
+
+namespace {
+
+// opcode of the specific binary operator
+Opcode GetBinaryOpcode(Operator op) {
+  switch (op) {
+    case Operator::Add: return Opcode::Add;
+    case Operator::Sub: return Opcode::Sub;
+    case Operator::Mul: return Opcode::Mul;
+    case Operator::Div: return Opcode::Div;
+    case Operator::Mod: return Opcode::Mod;
+    case Operator::Less: return Opcode::Less;
+    case Operator::LessEq: return Opcode::LessEq;
+    case Operator::Eq: return Opcode::Eq;
+    case Operator::NotEq: return Opcode::NotEq;
+    default: assert(false && "unknown binary operator");
+  }
+  return Opcode::Add;
+}
+
+}  // namespace
+
+bool BytecodeGen::Generate(const std::vector<ASTPtr> &funcs) {
+  // link function calls and resolve variables to slots
+  Resolver resolver;
+  if (!resolver.Resolve(funcs)) {
+    Unsupported(resolver.reason());
+    return false;
+  }
+  // assign indices to all functions
+  for (std::size_t i = 0; i < funcs.size(); ++i) {
+    auto func = static_cast<const FunDefAST *>(funcs[i]);
+    if (func->name() >= func_ids_.size()) {
+      func_ids_.resize(func->name() + 1, -1);
+    }
+    func_ids_[func->name()] = i;
+  }
+  // find the 'main' function
+  if (kSymMain >= func_ids_.size() || func_ids_[kSymMain] < 0) {
+    Unsupported("'main' function not found");
+    return false;
+  }
+  bytecode_.main = func_ids_[kSymMain];
+  // generate all functions
+  bytecode_.funcs.resize(funcs.size());
+  for (const auto &func : funcs) {
+    if (func->GenerateBytecode(*this) < 0) return false;
+  }
+  return true;
+}
+
+int BytecodeGen::Unsupported(std::string_view reason) {
+  reason_ = reason;
+  return -1;
+}
+
+int BytecodeGen::GenerateExpr(const BaseAST &ast, int dest) {
+  auto last_dest = dest_;
+  dest_ = dest;
+  auto reg = ast.GenerateBytecode(*this);
+  dest_ = last_dest;
+  return reg;
+}
+
+int BytecodeGen::GetDest() {
+  return dest_ >= 0 ? dest_ : AllocReg();
+}
+
+int BytecodeGen::AllocReg() {
+  if (next_reg_ > std::numeric_limits<Reg>::max()) {
+    return Unsupported("too many registers");
+  }
+  auto reg = next_reg_++;
+  if (next_reg_ > reg_num_) reg_num_ = next_reg_;
+  return reg;
+}
+
+int BytecodeGen::GenerateArgs(const FunCallAST &ast) {
+  for (const auto &arg : ast.args()) {
+    auto reg = AllocReg();
+    if (reg < 0 || GenerateExpr(*arg, reg) < 0) return -1;
+    next_reg_ = reg + 1;
+  }
+  return 0;
+}
+
+std::uint32_t BytecodeGen::PushInst(Opcode op, int a, std::uint32_t b,
+                                    std::uint32_t c) {
+  bytecode_.code.push_back({op, static_cast<Reg>(a), b, c});
+  return bytecode_.code.size() - 1;
+}
+
+void BytecodeGen::SetTargetHere(std::uint32_t index) {
+  bytecode_.code[index].b = bytecode_.code.size();
+}
+
+int BytecodeGen::GenerateOn(const FunDefAST &ast) {
+  auto &func = bytecode_.funcs[func_ids_[ast.name()]];
+  func.entry = bytecode_.code.size();
+  func.param_num = ast.args().size();
+  // slots of the frame are the first registers,
+  // temporaries follow them
+  temp_base_ = next_reg_ = reg_num_ = ast.frame_size();
+  if (temp_base_ > std::numeric_limits<Reg>::max()) {
+    return Unsupported("too many registers");
+  }
+  ret_set_ = false;
+  // generate body
+  if (ast.body()->GenerateBytecode(*this) < 0) return -1;
+  if (!ret_set_) return Unsupported("function may have no return value");
+  func.reg_num = reg_num_;
+  return 0;
+}
+
+int BytecodeGen::GenerateOn(const BlockAST &ast) {
+  // generate all statements, every statement frees its temporaries
+  for (const auto &stmt : ast.stmts()) {
+    if (GenerateExpr(*stmt, kDiscard) < 0) return -1;
+    next_reg_ = temp_base_;
+    // remaining statements are unreachable if returned in all paths
+    if (ret_set_) break;
+  }
+  return 0;
+}
+
+int BytecodeGen::GenerateOn(const DefineAST &ast) {
+  // generate the expression to the register of variable
+  return GenerateExpr(*ast.expr(), ast.slot()) < 0 ? -1 : 0;
+}
+
+int BytecodeGen::GenerateOn(const AssignAST &ast) {
+  return GenerateExpr(*ast.expr(), ast.slot()) < 0 ? -1 : 0;
+}
+
+int BytecodeGen::GenerateOn(const IfAST &ast) {
+  auto top = next_reg_;
+  // the statement returns in all paths if all branches return
+  auto all_ret_set = true;
+  // walk through the 'else if' chain
+  std::vector<std::uint32_t> end_jumps;
+  for (auto if_else = &ast; if_else; if_else = if_else->else_if()) {
+    // generate condition and conditional branch
+    auto cond = GenerateExpr(*if_else->cond());
+    if (cond < 0) return -1;
+    next_reg_ = top;
+    auto branch = PushInst(Opcode::Jz, cond);
+    // generate the true branch
+    ret_set_ = false;
+    if (if_else->then()->GenerateBytecode(*this) < 0) return -1;
+    all_ret_set = all_ret_set && ret_set_;
+    if (!ret_set_ && (if_else->else_then() || if_else->else_if())) {
+      end_jumps.push_back(PushInst(Opcode::Jmp));
+    }
+    // generate the false branch
+    SetTargetHere(branch);
+    if (if_else->else_then()) {
+      ret_set_ = false;
+      if (if_else->else_then()->GenerateBytecode(*this) < 0) return -1;
+      all_ret_set = all_ret_set && ret_set_;
+    }
+    else if (!if_else->else_if()) {
+      all_ret_set = false;
+    }
+  }
+  for (const auto &jump : end_jumps) SetTargetHere(jump);
+  ret_set_ = all_ret_set;
+  return 0;
+}
+
+int BytecodeGen::GenerateOn(const ReturnAST &ast) {
+  if (const auto &call = ast.tail_call()) {
+    // generate arguments, then replace the current frame with callee
+    auto top = next_reg_;
+    if (GenerateArgs(*call) < 0) return -1;
+    PushInst(Opcode::TailCall, 0, top, func_ids_[call->callee()->name()]);
+    ret_set_ = true;
+    return 0;
+  }
+  auto ret = GenerateExpr(*ast.expr());
+  if (ret < 0) return -1;
+  PushInst(Opcode::Ret, ret);
+  ret_set_ = true;
+  return 0;
+}
+
+int BytecodeGen::GenerateOn(const BinaryAST &ast) {
+  auto top = next_reg_;
+  // check if is logical operator
+  if (ast.op() == Operator::LAnd || ast.op() == Operator::LOr) {
+    // generate to a temporary register, since 'dest' may be read by rhs
+    auto temp = AllocReg();
+    if (temp < 0 || GenerateExpr(*ast.lhs(), temp) < 0) return -1;
+    auto op = ast.op() == Operator::LAnd ? Opcode::Jz : Opcode::Jnz;
+    auto branch = PushInst(op, temp);
+    if (GenerateExpr(*ast.rhs(), temp) < 0) return -1;
+    SetTargetHere(branch);
+    next_reg_ = temp + 1;
+    if (dest_ < 0) return temp;
+    next_reg_ = top;
+    PushInst(Opcode::Mov, dest_, temp);
+    return dest_;
+  }
+  else {
+    // generate the lhs & rhs
+    auto lhs = GenerateExpr(*ast.lhs());
+    if (lhs < 0) return -1;
+    auto rhs = GenerateExpr(*ast.rhs());
+    if (rhs < 0) return -1;
+    // reuse registers of operands
+    next_reg_ = top;
+    auto dest = GetDest();
+    if (dest < 0) return -1;
+    PushInst(GetBinaryOpcode(ast.op()), dest, lhs, rhs);
+    return dest;
+  }
+}
+
+int BytecodeGen::GenerateOn(const UnaryAST &ast) {
+  auto top = next_reg_;
+  auto opr = GenerateExpr(*ast.opr());
+  if (opr < 0) return -1;
+  next_reg_ = top;
+  auto dest = GetDest();
+  if (dest < 0) return -1;
+  switch (ast.op()) {
+    case Operator::Sub: PushInst(Opcode::Neg, dest, opr); break;
+    case Operator::LNot: PushInst(Opcode::Not, dest, opr); break;
+    default: assert(false && "unknown unary operator");
+  }
+  return dest;
+}
+
+int BytecodeGen::GenerateOn(const FunCallAST &ast) {
+  auto top = next_reg_;
+  const auto &args = ast.args();
+  int dest;
+  // handle library function call
+  if (ast.target() == CallTarget::Input) {
+    if ((dest = GetDest()) < 0) return -1;
+    PushInst(Opcode::Input, dest);
+  }
+  else if (ast.target() == CallTarget::Print) {
+    auto arg = GenerateExpr(*args[0]);
+    if (arg < 0) return -1;
+    PushInst(Opcode::Print, arg);
+    next_reg_ = top;
+    // 'print' returns zero
+    if (dest_ == kDiscard) return 0;
+    if ((dest = GetDest()) < 0) return -1;
+    PushInst(Opcode::Imm, dest, 0);
+  }
+  else if (ast.target() == CallTarget::Function) {
+    auto index = func_ids_[ast.callee()->name()];
+    if (GenerateArgs(ast) < 0) return -1;
+    // generate function call
+    next_reg_ = top;
+    if ((dest = GetDest()) < 0) return -1;
+    PushInst(Opcode::Call, dest, top, index);
+  }
+  else if (ast.target() == CallTarget::ArgCountMismatch) {
+    return Unsupported("argument count mismatch");
+  }
+  else {
+    return Unsupported("function not found");
+  }
+  if (dest_ == kDiscard) next_reg_ = top;
+  return dest;
+}
+
+int BytecodeGen::GenerateOn(const IntAST &ast) {
+  auto dest = GetDest();
+  if (dest < 0) return -1;
+  PushInst(Opcode::Imm, dest, static_cast<std::uint32_t>(ast.val()));
+  return dest;
+}
+
+int BytecodeGen::GenerateOn(const IdAST &ast) {
+  // read the register of variable
+  int reg = ast.slot();
+  if (dest_ < 0) return reg;
+  PushInst(Opcode::Mov, dest_, reg);
+  return dest_;
+}
@@ -0,0 +1,82 @@
+#ifndef FIRSTSTEP_BACK_VM_CODEGEN_H_
+#define FIRSTSTEP_BACK_VM_CODEGEN_H_
+
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "define/ast.h"
+#include "define/symbol.h"
+#include "back/vm/bytecode.h"
+
+// generator of register bytecode
+// slots of variables given by the resolver are used as registers,
+// so programs that can not be resolved, or may have errors at runtime,
+// are not supported, and must be run by the interpreter instead
+class BytecodeGen {
+ public:
+  BytecodeGen() : dest_(kNoDest) {}
+
+  // resolve and generate bytecode for the specific function definitions
+  // returns false if the program is not supported
+  bool Generate(const std::vector<ASTPtr> &funcs);
+
+  // visitor methods
+  // expressions return the register that holds the result,
+  // and other ASTs return zero, returns -1 if not supported
+  int GenerateOn(const FunDefAST &ast);
+  int GenerateOn(const BlockAST &ast);
+  int GenerateOn(const DefineAST &ast);
+  int GenerateOn(const AssignAST &ast);
+  int GenerateOn(const IfAST &ast);
+  int GenerateOn(const ReturnAST &ast);
+  int GenerateOn(const BinaryAST &ast);
+  int GenerateOn(const UnaryAST &ast);
+  int GenerateOn(const FunCallAST &ast);
+  int GenerateOn(const IntAST &ast);
+  int GenerateOn(const IdAST &ast);
+
+  // generated bytecode
+  const Bytecode &bytecode() const { return bytecode_; }
+  // reason why the program is not supported
+  std::string_view reason() const { return reason_; }
+
+ private:
+  // destination of expressions that has no destination register
+  static constexpr int kNoDest = -1;
+  // destination of expressions whose result is unused
+  static constexpr int kDiscard = -2;
+
+  // mark the program as unsupported
+  int Unsupported(std::string_view reason);
+  // generate the specific expression, stores the result to 'dest'
+  // if 'dest' is a register, returns the register of the result
+  int GenerateExpr(const BaseAST &ast, int dest = kNoDest);
+  // generate arguments of the specific call to consecutive registers
+  // on the top of register stack, which are the first registers of callee
+  int GenerateArgs(const FunCallAST &ast);
+  // get a register for storing the result of the current expression
+  int GetDest();
+  // allocate a new register on the top of register stack
+  int AllocReg();
+  // push instruction, returns index of the instruction
+  std::uint32_t PushInst(Opcode op, int a = 0, std::uint32_t b = 0,
+                         std::uint32_t c = 0);
+  // set the jump target of the specific jump instruction to here
+  void SetTargetHere(std::uint32_t index);
+
+  std::string_view reason_;
+  Bytecode bytecode_;
+  // function indices of all functions, indexed by symbol id
+  std::vector<std::int32_t> func_ids_;
+  // destination of the current expression
+  int dest_;
+  // first register after variables, next free register,
+  // and max count of registers of the function
+  int temp_base_, next_reg_, reg_num_;
+  // set if returned in all paths of the current statement
+  bool ret_set_;
+};
+
+#endif  // FIRSTSTEP_BACK_VM_CODEGEN_H_
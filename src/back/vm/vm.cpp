@@ -0,0 +1,207 @@
+#include "back/vm/vm.h"
+
+#include <iostream>
+#include <algorithm>
+
+// use computed goto for dispatching if possible
+#if defined(__GNUC__) || defined(__clang__)
+#define FIRSTSTEP_VM_COMPUTED_GOTO
+#endif
+
+VMStatus VM::LogError(std::string_view message) {
+  // keep the order of outputs and errors
+  io_->Flush();
+  reporter_.Report(kRuntimeStage, message);
+  ++error_num_;
+  return VMStatus::Failed;
+}
+
+std::optional<int> VM::Run() {
+  Start();
+  // never suspends unless inputs are pushed
+  if (Resume() != VMStatus::Finished) return {};
+  return ret_;
+}
+
+void VM::Start() {
+  // initialize the frame of 'main' function
+  const auto &main = bytecode_.funcs[bytecode_.main];
+  frames_.clear();
+  peak_depth_ = 0;
+  regs_.assign(main.reg_num, 0);
+  pc_ = bytecode_.code.data() + main.entry;
+  base_ = 0;
+}
+
+VMStatus VM::Resume() {
+  const auto code = bytecode_.code.data();
+  std::size_t base = base_;
+  auto regs = regs_.data() + base;
+  auto pc = pc_;
+
+#ifdef FIRSTSTEP_VM_COMPUTED_GOTO
+#define FIRSTSTEP_EXPAND_LABEL(op) &&L_##op,
+  static const void *kLabels[] = {
+      FIRSTSTEP_OPCODES(FIRSTSTEP_EXPAND_LABEL)};
+#undef FIRSTSTEP_EXPAND_LABEL
+#define VM_DISPATCH() goto *kLabels[static_cast<int>(pc->op)]
+#define VM_CASE(op) L_##op:
+  VM_DISPATCH();
+#else
+#define VM_DISPATCH() continue
+#define VM_CASE(op) case Opcode::op:
+  for (;;) {
+    switch (pc->op) {
+#endif
+// go to the next instruction
+#define VM_NEXT() \
+  ++pc;           \
+  VM_DISPATCH()
+// suspend at the current instruction
+#define VM_SUSPEND(status) \
+  pc_ = pc;                \
+  base_ = base;            \
+  return status
+
+  VM_CASE(Imm) {
+    regs[pc->a] = static_cast<int>(pc->b);
+    VM_NEXT();
+  }
+  VM_CASE(Mov) {
+    regs[pc->a] = regs[pc->b];
+    VM_NEXT();
+  }
+  // arithmetic is performed on unsigned integers, so that overflow
+  // wraps around without undefined behavior
+  VM_CASE(Add) {
+    unsigned lhs = regs[pc->b];
+    regs[pc->a] = static_cast<int>(lhs + regs[pc->c]);
+    VM_NEXT();
+  }
+  VM_CASE(Sub) {
+    unsigned lhs = regs[pc->b];
+    regs[pc->a] = static_cast<int>(lhs - regs[pc->c]);
+    VM_NEXT();
+  }
+  VM_CASE(Mul) {
+    unsigned lhs = regs[pc->b];
+    regs[pc->a] = static_cast<int>(lhs * regs[pc->c]);
+    VM_NEXT();
+  }
+  VM_CASE(Div) {
+    // 'INT_MIN / -1' wraps around like other operators
+    if (!regs[pc->c]) return LogError("division by zero");
+    regs[pc->a] = regs[pc->c] == -1
+                      ? static_cast<int>(0u - regs[pc->b])
+                      : regs[pc->b] / regs[pc->c];
+    VM_NEXT();
+  }
+  VM_CASE(Mod) {
+    if (!regs[pc->c]) return LogError("division by zero");
+    regs[pc->a] = regs[pc->c] == -1 ? 0 : regs[pc->b] % regs[pc->c];
+    VM_NEXT();
+  }
+  VM_CASE(Less) {
+    regs[pc->a] = regs[pc->b] < regs[pc->c];
+    VM_NEXT();
+  }
+  VM_CASE(LessEq) {
+    regs[pc->a] = regs[pc->b] <= regs[pc->c];
+    VM_NEXT();
+  }
+  VM_CASE(Eq) {
+    regs[pc->a] = regs[pc->b] == regs[pc->c];
+    VM_NEXT();
+  }
+  VM_CASE(NotEq) {
+    regs[pc->a] = regs[pc->b] != regs[pc->c];
+    VM_NEXT();
+  }
+  VM_CASE(Neg) {
+    regs[pc->a] = static_cast<int>(0u - regs[pc->b]);
+    VM_NEXT();
+  }
+  VM_CASE(Not) {
+    regs[pc->a] = !regs[pc->b];
+    VM_NEXT();
+  }
+  VM_CASE(Jmp) {
+    pc = code + pc->b;
+    VM_DISPATCH();
+  }
+  VM_CASE(Jz) {
+    pc = regs[pc->a] ? pc + 1 : code + pc->b;
+    VM_DISPATCH();
+  }
+  VM_CASE(Jnz) {
+    pc = regs[pc->a] ? code + pc->b : pc + 1;
+    VM_DISPATCH();
+  }
+  VM_CASE(Call) {
+    const auto &func = bytecode_.funcs[pc->c];
+    if (frames_.size() >= max_depth_) {
+      return LogError("call stack overflow");
+    }
+    frames_.push_back({pc + 1, base});
+    if (frames_.size() > peak_depth_) peak_depth_ = frames_.size();
+    // arguments are the first registers of callee
+    base += pc->b;
+    if (regs_.size() < base + func.reg_num) {
+      regs_.resize(std::max(regs_.size() * 2, base + func.reg_num));
+    }
+    regs = regs_.data() + base;
+    pc = code + func.entry;
+    VM_DISPATCH();
+  }
+  VM_CASE(TailCall) {
+    const auto &func = bytecode_.funcs[pc->c];
+    // move arguments to the first registers of the current frame
+    std::copy_n(regs + pc->b, func.param_num, regs);
+    if (regs_.size() < base + func.reg_num) {
+      regs_.resize(std::max(regs_.size() * 2, base + func.reg_num));
+      regs = regs_.data() + base;
+    }
+    pc = code + func.entry;
+    VM_DISPATCH();
+  }
+  VM_CASE(Ret) {
+    auto ret = regs[pc->a];
+    // check if returned from 'main'
+    if (frames_.empty()) {
+      ret_ = ret;
+      return VMStatus::Finished;
+    }
+    // restore frame of caller
+    const auto &frame = frames_.back();
+    pc = frame.ret_pc;
+    base = frame.base;
+    frames_.pop_back();
+    regs = regs_.data() + base;
+    regs[pc[-1].a] = ret;
+    VM_DISPATCH();
+  }
+  VM_CASE(Input) {
+    // read an integer from stdin
+    if (!io_->IsInputReady()) {
+      VM_SUSPEND(VMStatus::WaitInput);
+    }
+    regs[pc->a] = io_->ReadInt();
+    VM_NEXT();
+  }
+  VM_CASE(Print) {
+    if (io_->IsOutputFull()) {
+      VM_SUSPEND(VMStatus::WaitOutput);
+    }
+    io_->WriteInt(regs[pc->a]);
+    VM_NEXT();
+  }
+
+#ifndef FIRSTSTEP_VM_COMPUTED_GOTO
+    }
+  }
+#endif
+#undef VM_DISPATCH
+#undef VM_CASE
+#undef VM_NEXT
+#undef VM_SUSPEND
+}
@@ -0,0 +1,102 @@
+#ifndef FIRSTSTEP_BACK_VM_VM_H_
+#define FIRSTSTEP_BACK_VM_VM_H_
+
+#include <iostream>
+#include <optional>
+#include <string_view>
+#include <vector>
+#include <cstddef>
+
+#include "define/error.h"
+#include "back/vm/bytecode.h"
+#include "back/runtime/io.h"
+
+// status of a resumable run of VM
+enum class VMStatus {
+  // 'main' function has returned
+  Finished,
+  // an error has been reported
+  Failed,
+  // 'input' is waiting for more pushed inputs
+  WaitInput,
+  // 'print' is waiting for outputs to be consumed
+  WaitOutput,
+};
+
+// virtual machine that runs register bytecode
+// frames live on a heap-allocated stack, calls never recurse natively,
+// so a run can be suspended at any instruction and resumed later
+class VM {
+ public:
+  // default max depth of calls
+  static constexpr std::size_t kDefaultMaxDepth = 1 << 20;
+
+  VM(const Bytecode &bytecode)
+      : bytecode_(bytecode), error_num_(0), max_depth_(kDefaultMaxDepth),
+        peak_depth_(0), pc_(nullptr), base_(0), ret_(0),
+        io_(&GetStdIO()) {}
+
+  // set max depth of calls
+  void set_max_depth(std::size_t max_depth) { max_depth_ = max_depth; }
+  // set I/O of library functions, stdin and stdout by default
+  void set_io(RuntimeIO &io) { io_ = &io; }
+  // set the stream for printing error messages
+  void set_err_stream(std::ostream &err) { reporter_.set_err_stream(err); }
+  // set the list for collecting errors, instead of printing them
+  void set_error_list(ErrorList &errors) {
+    reporter_.set_error_list(errors);
+  }
+
+  // run the 'main' function
+  // returns return value of 'main' function, or 'nullopt' if failed
+  std::optional<int> Run();
+  // start a resumable run of the 'main' function, call 'Resume' to run
+  // the function, which suspends at 'input' or 'print' if the I/O has
+  // pushed inputs and is not ready
+  void Start();
+  // continue the current run until it finishes or suspends
+  VMStatus Resume();
+
+  // count of error
+  std::size_t error_num() const { return error_num_; }
+  // return value of 'main' function, after a run has finished
+  int ret() const { return ret_; }
+  // peak depth of calls
+  std::size_t peak_depth() const { return peak_depth_; }
+  // peak bytes of registers and frames
+  std::size_t peak_stack_bytes() const {
+    return regs_.capacity() * sizeof(int) +
+           frames_.capacity() * sizeof(Frame);
+  }
+
+ private:
+  // call frame
+  struct Frame {
+    // instruction after the call instruction
+    const Inst *ret_pc;
+    // register base of caller
+    std::size_t base;
+  };
+
+  // report error message, and stop the current run
+  VMStatus LogError(std::string_view message);
+
+  const Bytecode &bytecode_;
+  std::size_t error_num_;
+  // max depth and peak depth of calls
+  std::size_t max_depth_, peak_depth_;
+  // registers of all frames
+  std::vector<int> regs_;
+  std::vector<Frame> frames_;
+  // next instruction and register base of a suspended run
+  const Inst *pc_;
+  std::size_t base_;
+  // return value of 'main' function
+  int ret_;
+  // I/O of library functions
+  RuntimeIO *io_;
+  // reporter of error messages
+  ErrorReporter reporter_;
+};
+
+#endif  // FIRSTSTEP_BACK_VM_VM_H_
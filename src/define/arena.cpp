@@ -0,0 +1,28 @@
+#include "define/arena.h"
+
+void Arena::Absorb(Arena &arena) {
+  for (auto &block : arena.blocks_) blocks_.push_back(std::move(block));
+  alloc_num_ += arena.alloc_num_;
+  alloc_bytes_ += arena.alloc_bytes_;
+  // reset the absorbed arena
+  arena.blocks_.clear();
+  arena.cur_ = arena.end_ = nullptr;
+  arena.alloc_num_ = arena.alloc_bytes_ = 0;
+}
+
+void *Arena::AllocateSlow(std::size_t size, std::size_t align) {
+  // allocate large objects in dedicated blocks
+  // so that the rest of the current block can still be used
+  if (size > kBlockSize / 4) {
+    blocks_.emplace_back(new char[size + align]);
+    auto block = blocks_.back().get();
+    return block + GetPadding(block, align);
+  }
+  // switch to a new block
+  blocks_.emplace_back(new char[kBlockSize]);
+  auto block = blocks_.back().get();
+  auto ptr = block + GetPadding(block, align);
+  cur_ = ptr + size;
+  end_ = block + kBlockSize;
+  return ptr;
+}
@@ -0,0 +1,97 @@
+#ifndef FIRSTSTEP_DEFINE_ARENA_H_
+#define FIRSTSTEP_DEFINE_ARENA_H_
+
+#include <memory>
+#include <vector>
+#include <new>
+#include <utility>
+#include <cstring>
+#include <cstdint>
+#include <cstddef>
+
+// non-owning view of a contiguous sequence
+template <typename T>
+class Span {
+ public:
+  Span() : data_(nullptr), size_(0) {}
+  Span(T *data, std::size_t size) : data_(data), size_(size) {}
+
+  T *begin() const { return data_; }
+  T *end() const { return data_ + size_; }
+  T &operator[](std::size_t i) const { return data_[i]; }
+  std::size_t size() const { return size_; }
+  bool empty() const { return !size_; }
+
+ private:
+  T *data_;
+  std::size_t size_;
+};
+
+// bump pointer allocator, frees all allocated memory at once
+// destructors of objects allocated in arena will never be called
+class Arena {
+ public:
+  Arena() : cur_(nullptr), end_(nullptr), alloc_num_(0), alloc_bytes_(0) {}
+
+  Arena(const Arena &) = delete;
+  Arena &operator=(const Arena &) = delete;
+
+  // allocate a memory block with the specific size and alignment
+  void *Allocate(std::size_t size, std::size_t align) {
+    ++alloc_num_;
+    alloc_bytes_ += size;
+    auto pad = GetPadding(cur_, align);
+    if (static_cast<std::size_t>(end_ - cur_) < pad + size) {
+      return AllocateSlow(size, align);
+    }
+    auto ptr = cur_ + pad;
+    cur_ = ptr + size;
+    return ptr;
+  }
+
+  // create a new object in arena
+  template <typename T, typename... Args>
+  T *New(Args &&...args) {
+    return new (Allocate(sizeof(T), alignof(T)))
+        T(std::forward<Args>(args)...);
+  }
+
+  // copy the specific trivially copyable elements to arena
+  template <typename T>
+  Span<T> NewList(const T *data, std::size_t size) {
+    if (!size) return {};
+    auto list = static_cast<T *>(Allocate(sizeof(T) * size, alignof(T)));
+    std::memcpy(list, data, sizeof(T) * size);
+    return {list, size};
+  }
+
+  // take over all memory blocks of the specific arena
+  // objects allocated in that arena will be freed along with this arena
+  void Absorb(Arena &arena);
+
+  // count of allocations
+  std::size_t alloc_num() const { return alloc_num_; }
+  // total bytes of allocations
+  std::size_t alloc_bytes() const { return alloc_bytes_; }
+  // count of memory blocks requested from system
+  std::size_t block_num() const { return blocks_.size(); }
+
+ private:
+  // default size of memory blocks
+  static constexpr std::size_t kBlockSize = 64 * 1024;
+
+  // get padding bytes for aligning the specific pointer
+  static std::size_t GetPadding(const char *ptr, std::size_t align) {
+    auto addr = reinterpret_cast<std::uintptr_t>(ptr);
+    return (align - addr % align) % align;
+  }
+
+  // allocate memory in a new block
+  void *AllocateSlow(std::size_t size, std::size_t align);
+
+  char *cur_, *end_;
+  std::size_t alloc_num_, alloc_bytes_;
+  std::vector<std::unique_ptr<char[]>> blocks_;
+};
+
+#endif  // FIRSTSTEP_DEFINE_ARENA_H_
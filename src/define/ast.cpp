@@ -2,6 +2,11 @@
 
 #include "back/interpreter/interpreter.h"
 #include "back/compiler/irgen.h"
+#include "back/vm/codegen.h"
+#include "back/jit/codegen.h"
+#include "back/resolver/resolver.h"
+#include "back/lanes/lanes.h"
+#include "front/cache.h"
 
 std::optional<int> FunDefAST::Eval(Interpreter &intp) const {
   return intp.EvalOn(*this);
@@ -90,3 +95,223 @@ ValPtr IntAST::GenerateIR(IRGenerator &gen) const {
 ValPtr IdAST::GenerateIR(IRGenerator &gen) const {
   return gen.GenerateOn(*this);
 }
+
+void FunDefAST::Write(ASTWriter &writer) const {
+  writer.WriteOn(*this);
+}
+
+void BlockAST::Write(ASTWriter &writer) const {
+  writer.WriteOn(*this);
+}
+
+void DefineAST::Write(ASTWriter &writer) const {
+  writer.WriteOn(*this);
+}
+
+void AssignAST::Write(ASTWriter &writer) const {
+  writer.WriteOn(*this);
+}
+
+void IfAST::Write(ASTWriter &writer) const {
+  writer.WriteOn(*this);
+}
+
+void ReturnAST::Write(ASTWriter &writer) const {
+  writer.WriteOn(*this);
+}
+
+void BinaryAST::Write(ASTWriter &writer) const {
+  writer.WriteOn(*this);
+}
+
+void UnaryAST::Write(ASTWriter &writer) const {
+  writer.WriteOn(*this);
+}
+
+void FunCallAST::Write(ASTWriter &writer) const {
+  writer.WriteOn(*this);
+}
+
+void IntAST::Write(ASTWriter &writer) const {
+  writer.WriteOn(*this);
+}
+
+void IdAST::Write(ASTWriter &writer) const {
+  writer.WriteOn(*this);
+}
+
+int FunDefAST::GenerateBytecode(BytecodeGen &gen) const {
+  return gen.GenerateOn(*this);
+}
+
+int BlockAST::GenerateBytecode(BytecodeGen &gen) const {
+  return gen.GenerateOn(*this);
+}
+
+int DefineAST::GenerateBytecode(BytecodeGen &gen) const {
+  return gen.GenerateOn(*this);
+}
+
+int AssignAST::GenerateBytecode(BytecodeGen &gen) const {
+  return gen.GenerateOn(*this);
+}
+
+int IfAST::GenerateBytecode(BytecodeGen &gen) const {
+  return gen.GenerateOn(*this);
+}
+
+int ReturnAST::GenerateBytecode(BytecodeGen &gen) const {
+  return gen.GenerateOn(*this);
+}
+
+int BinaryAST::GenerateBytecode(BytecodeGen &gen) const {
+  return gen.GenerateOn(*this);
+}
+
+int UnaryAST::GenerateBytecode(BytecodeGen &gen) const {
+  return gen.GenerateOn(*this);
+}
+
+int FunCallAST::GenerateBytecode(BytecodeGen &gen) const {
+  return gen.GenerateOn(*this);
+}
+
+int IntAST::GenerateBytecode(BytecodeGen &gen) const {
+  return gen.GenerateOn(*this);
+}
+
+int IdAST::GenerateBytecode(BytecodeGen &gen) const {
+  return gen.GenerateOn(*this);
+}
+
+bool FunDefAST::GenerateNative(NativeGen &gen) const {
+  return gen.GenerateOn(*this);
+}
+
+bool BlockAST::GenerateNative(NativeGen &gen) const {
+  return gen.GenerateOn(*this);
+}
+
+bool DefineAST::GenerateNative(NativeGen &gen) const {
+  return gen.GenerateOn(*this);
+}
+
+bool AssignAST::GenerateNative(NativeGen &gen) const {
+  return gen.GenerateOn(*this);
+}
+
+bool IfAST::GenerateNative(NativeGen &gen) const {
+  return gen.GenerateOn(*this);
+}
+
+bool ReturnAST::GenerateNative(NativeGen &gen) const {
+  return gen.GenerateOn(*this);
+}
+
+bool BinaryAST::GenerateNative(NativeGen &gen) const {
+  return gen.GenerateOn(*this);
+}
+
+bool UnaryAST::GenerateNative(NativeGen &gen) const {
+  return gen.GenerateOn(*this);
+}
+
+bool FunCallAST::GenerateNative(NativeGen &gen) const {
+  return gen.GenerateOn(*this);
+}
+
+bool IntAST::GenerateNative(NativeGen &gen) const {
+  return gen.GenerateOn(*this);
+}
+
+bool IdAST::GenerateNative(NativeGen &gen) const {
+  return gen.GenerateOn(*this);
+}
+
+void FunDefAST::Resolve(Resolver &resolver) {
+  resolver.ResolveOn(*this);
+}
+
+void BlockAST::Resolve(Resolver &resolver) {
+  resolver.ResolveOn(*this);
+}
+
+void DefineAST::Resolve(Resolver &resolver) {
+  resolver.ResolveOn(*this);
+}
+
+void AssignAST::Resolve(Resolver &resolver) {
+  resolver.ResolveOn(*this);
+}
+
+void IfAST::Resolve(Resolver &resolver) {
+  resolver.ResolveOn(*this);
+}
+
+void ReturnAST::Resolve(Resolver &resolver) {
+  resolver.ResolveOn(*this);
+}
+
+void BinaryAST::Resolve(Resolver &resolver) {
+  resolver.ResolveOn(*this);
+}
+
+void UnaryAST::Resolve(Resolver &resolver) {
+  resolver.ResolveOn(*this);
+}
+
+void FunCallAST::Resolve(Resolver &resolver) {
+  resolver.ResolveOn(*this);
+}
+
+void IntAST::Resolve(Resolver &resolver) {
+  resolver.ResolveOn(*this);
+}
+
+void IdAST::Resolve(Resolver &resolver) {
+  resolver.ResolveOn(*this);
+}
+
+LaneVal FunDefAST::EvalLanes(LaneInterpreter &intp) const {
+  return intp.EvalOn(*this);
+}
+
+LaneVal BlockAST::EvalLanes(LaneInterpreter &intp) const {
+  return intp.EvalOn(*this);
+}
+
+LaneVal DefineAST::EvalLanes(LaneInterpreter &intp) const {
+  return intp.EvalOn(*this);
+}
+
+LaneVal AssignAST::EvalLanes(LaneInterpreter &intp) const {
+  return intp.EvalOn(*this);
+}
+
+LaneVal IfAST::EvalLanes(LaneInterpreter &intp) const {
+  return intp.EvalOn(*this);
+}
+
+LaneVal ReturnAST::EvalLanes(LaneInterpreter &intp) const {
+  return intp.EvalOn(*this);
+}
+
+LaneVal BinaryAST::EvalLanes(LaneInterpreter &intp) const {
+  return intp.EvalOn(*this);
+}
+
+LaneVal UnaryAST::EvalLanes(LaneInterpreter &intp) const {
+  return intp.EvalOn(*this);
+}
+
+LaneVal FunCallAST::EvalLanes(LaneInterpreter &intp) const {
+  return intp.EvalOn(*this);
+}
+
+LaneVal IntAST::EvalLanes(LaneInterpreter &intp) const {
+  return intp.EvalOn(*this);
+}
+
+LaneVal IdAST::EvalLanes(LaneInterpreter &intp) const {
+  return intp.EvalOn(*this);
+}
@@ -2,59 +2,95 @@
 #define FIRSTSTEP_DEFINE_AST_H_
 
 #include <optional>
-#include <memory>
-#include <vector>
-#include <string>
-#include <utility>
+#include <cstdint>
 
 #include "define/token.h"
+#include "define/symbol.h"
+#include "define/arena.h"
 #include "define/ir.h"
 
 // forwarded declarations
 class Interpreter;
 class IRGenerator;
+class ASTWriter;
+class BytecodeGen;
+class NativeGen;
+class Resolver;
+class LaneInterpreter;
+class FunCallAST;
+struct LaneVal;
 
 // base class of all ASTs
+// all ASTs are allocated in arena, and they must not own any resource
 class BaseAST {
  public:
   virtual ~BaseAST() = default;
 
   virtual std::optional<int> Eval(Interpreter &intp) const = 0;
   virtual ValPtr GenerateIR(IRGenerator &gen) const = 0;
+  virtual void Write(ASTWriter &writer) const = 0;
+  virtual int GenerateBytecode(BytecodeGen &gen) const = 0;
+  virtual bool GenerateNative(NativeGen &gen) const = 0;
+  virtual void Resolve(Resolver &resolver) = 0;
+  virtual LaneVal EvalLanes(LaneInterpreter &intp) const = 0;
 };
 
 // some type definitions
-using ASTPtr = std::unique_ptr<BaseAST>;
-using ASTPtrList = std::vector<ASTPtr>;
-using IdList = std::vector<std::string>;
+using ASTPtr = BaseAST *;
+using ASTPtrList = Span<ASTPtr>;
+using IdList = Span<SymbolId>;
+// index of variable in the frame of function, set by resolver
+using Slot = std::uint32_t;
 
 // function definition
 class FunDefAST : public BaseAST {
  public:
-  FunDefAST(const std::string &name, IdList args, ASTPtr body)
-      : name_(name), args_(std::move(args)), body_(std::move(body)) {}
+  FunDefAST(SymbolId name, IdList args, ASTPtr body)
+      : name_(name), args_(args), body_(body), frame_size_(0),
+        is_pure_(false) {}
 
   std::optional<int> Eval(Interpreter &intp) const override;
   ValPtr GenerateIR(IRGenerator &gen) const override;
+  void Write(ASTWriter &writer) const override;
+  int GenerateBytecode(BytecodeGen &gen) const override;
+  bool GenerateNative(NativeGen &gen) const override;
+  void Resolve(Resolver &resolver) override;
+  LaneVal EvalLanes(LaneInterpreter &intp) const override;
 
   // getters
-  const std::string &name() const { return name_; }
+  SymbolId name() const { return name_; }
   const IdList &args() const { return args_; }
   const ASTPtr &body() const { return body_; }
+  // count of slots of arguments and local variables
+  Slot frame_size() const { return frame_size_; }
+  // set if the function can be resolved, and never reaches library
+  // functions or unlinked calls, so its result depends on arguments only
+  bool is_pure() const { return is_pure_; }
+
+  // setters
+  void set_frame_size(Slot frame_size) { frame_size_ = frame_size; }
+  void set_is_pure(bool is_pure) { is_pure_ = is_pure; }
 
  private:
-  std::string name_;
+  SymbolId name_;
   IdList args_;
   ASTPtr body_;
+  Slot frame_size_;
+  bool is_pure_;
 };
 
 // statement block
 class BlockAST : public BaseAST {
  public:
-  BlockAST(ASTPtrList stmts) : stmts_(std::move(stmts)) {}
+  BlockAST(ASTPtrList stmts) : stmts_(stmts) {}
 
   std::optional<int> Eval(Interpreter &intp) const override;
   ValPtr GenerateIR(IRGenerator &gen) const override;
+  void Write(ASTWriter &writer) const override;
+  int GenerateBytecode(BytecodeGen &gen) const override;
+  bool GenerateNative(NativeGen &gen) const override;
+  void Resolve(Resolver &resolver) override;
+  LaneVal EvalLanes(LaneInterpreter &intp) const override;
 
   // getters
   const ASTPtrList &stmts() const { return stmts_; }
@@ -66,99 +102,165 @@ class BlockAST : public BaseAST {
 // define statement
 class DefineAST : public BaseAST {
  public:
-  DefineAST(const std::string &name, ASTPtr expr)
-      : name_(name), expr_(std::move(expr)) {}
+  DefineAST(SymbolId name, ASTPtr expr)
+      : name_(name), expr_(expr), slot_(0) {}
 
   std::optional<int> Eval(Interpreter &intp) const override;
   ValPtr GenerateIR(IRGenerator &gen) const override;
+  void Write(ASTWriter &writer) const override;
+  int GenerateBytecode(BytecodeGen &gen) const override;
+  bool GenerateNative(NativeGen &gen) const override;
+  void Resolve(Resolver &resolver) override;
+  LaneVal EvalLanes(LaneInterpreter &intp) const override;
 
   // getters
-  const std::string &name() const { return name_; }
+  SymbolId name() const { return name_; }
   const ASTPtr &expr() const { return expr_; }
+  Slot slot() const { return slot_; }
+
+  // setters
+  void set_slot(Slot slot) { slot_ = slot; }
 
  private:
-  std::string name_;
+  SymbolId name_;
   ASTPtr expr_;
+  Slot slot_;
 };
 
 // assign statement
 class AssignAST : public BaseAST {
  public:
-  AssignAST(const std::string &name, ASTPtr expr)
-      : name_(name), expr_(std::move(expr)) {}
+  AssignAST(SymbolId name, ASTPtr expr)
+      : name_(name), expr_(expr), slot_(0) {}
 
   std::optional<int> Eval(Interpreter &intp) const override;
   ValPtr GenerateIR(IRGenerator &gen) const override;
+  void Write(ASTWriter &writer) const override;
+  int GenerateBytecode(BytecodeGen &gen) const override;
+  bool GenerateNative(NativeGen &gen) const override;
+  void Resolve(Resolver &resolver) override;
+  LaneVal EvalLanes(LaneInterpreter &intp) const override;
 
   // getters
-  const std::string &name() const { return name_; }
+  SymbolId name() const { return name_; }
   const ASTPtr &expr() const { return expr_; }
+  Slot slot() const { return slot_; }
+
+  // setters
+  void set_slot(Slot slot) { slot_ = slot; }
 
  private:
-  std::string name_;
+  SymbolId name_;
   ASTPtr expr_;
+  Slot slot_;
 };
 
 // if-else statement
+// 'else if' branch is stored in 'else_if' rather than in 'else_then',
+// so that long 'else if' chains can be walked without recursion
 class IfAST : public BaseAST {
  public:
-  IfAST(ASTPtr cond, ASTPtr then, ASTPtr else_then)
-      : cond_(std::move(cond)), then_(std::move(then)),
-        else_then_(std::move(else_then)) {}
+  IfAST(ASTPtr cond, ASTPtr then, ASTPtr else_then, IfAST *else_if)
+      : cond_(cond), then_(then), else_then_(else_then),
+        else_if_(else_if), index_(0) {}
 
   std::optional<int> Eval(Interpreter &intp) const override;
   ValPtr GenerateIR(IRGenerator &gen) const override;
+  void Write(ASTWriter &writer) const override;
+  int GenerateBytecode(BytecodeGen &gen) const override;
+  bool GenerateNative(NativeGen &gen) const override;
+  void Resolve(Resolver &resolver) override;
+  LaneVal EvalLanes(LaneInterpreter &intp) const override;
 
   // getters
   const ASTPtr &cond() const { return cond_; }
   const ASTPtr &then() const { return then_; }
   const ASTPtr &else_then() const { return else_then_; }
+  const IfAST *else_if() const { return else_if_; }
+  IfAST *else_if() { return else_if_; }
+  // index of the branch in its function, in source order
+  std::uint32_t index() const { return index_; }
+
+  // setters
+  void set_index(std::uint32_t index) { index_ = index; }
 
  private:
   ASTPtr cond_, then_, else_then_;
+  IfAST *else_if_;
+  std::uint32_t index_;
 };
 
 // return statement
 class ReturnAST : public BaseAST {
  public:
-  ReturnAST(ASTPtr expr) : expr_(std::move(expr)) {}
+  ReturnAST(ASTPtr expr) : expr_(expr), tail_call_(nullptr) {}
 
   std::optional<int> Eval(Interpreter &intp) const override;
   ValPtr GenerateIR(IRGenerator &gen) const override;
+  void Write(ASTWriter &writer) const override;
+  int GenerateBytecode(BytecodeGen &gen) const override;
+  bool GenerateNative(NativeGen &gen) const override;
+  void Resolve(Resolver &resolver) override;
+  LaneVal EvalLanes(LaneInterpreter &intp) const override;
 
   // getters
   const ASTPtr &expr() const { return expr_; }
+  // the expression if it is a call of defined function, otherwise null
+  const FunCallAST *tail_call() const { return tail_call_; }
+
+  // setters
+  void set_tail_call(const FunCallAST *tail_call) {
+    tail_call_ = tail_call;
+  }
 
  private:
   ASTPtr expr_;
+  const FunCallAST *tail_call_;
 };
 
 // binary expression
 class BinaryAST : public BaseAST {
  public:
   BinaryAST(Operator op, ASTPtr lhs, ASTPtr rhs)
-      : op_(op), lhs_(std::move(lhs)), rhs_(std::move(rhs)) {}
+      : op_(op), lhs_(lhs), rhs_(rhs), is_forkable_(false) {}
 
   std::optional<int> Eval(Interpreter &intp) const override;
   ValPtr GenerateIR(IRGenerator &gen) const override;
+  void Write(ASTWriter &writer) const override;
+  int GenerateBytecode(BytecodeGen &gen) const override;
+  bool GenerateNative(NativeGen &gen) const override;
+  void Resolve(Resolver &resolver) override;
+  LaneVal EvalLanes(LaneInterpreter &intp) const override;
 
   // getters
   Operator op() const { return op_; }
   const ASTPtr &lhs() const { return lhs_; }
   const ASTPtr &rhs() const { return rhs_; }
+  // set if both operands call defined functions, and never reach
+  // library functions, so they can be evaluated in parallel
+  bool is_forkable() const { return is_forkable_; }
+
+  // setters
+  void set_is_forkable(bool is_forkable) { is_forkable_ = is_forkable; }
 
  private:
   Operator op_;
   ASTPtr lhs_, rhs_;
+  bool is_forkable_;
 };
 
 // unary expression
 class UnaryAST : public BaseAST {
  public:
-  UnaryAST(Operator op, ASTPtr opr) : op_(op), opr_(std::move(opr)) {}
+  UnaryAST(Operator op, ASTPtr opr) : op_(op), opr_(opr) {}
 
   std::optional<int> Eval(Interpreter &intp) const override;
   ValPtr GenerateIR(IRGenerator &gen) const override;
+  void Write(ASTWriter &writer) const override;
+  int GenerateBytecode(BytecodeGen &gen) const override;
+  bool GenerateNative(NativeGen &gen) const override;
+  void Resolve(Resolver &resolver) override;
+  LaneVal EvalLanes(LaneInterpreter &intp) const override;
 
   // getters
   Operator op() const { return op_; }
@@ -169,22 +271,44 @@ class UnaryAST : public BaseAST {
   ASTPtr opr_;
 };
 
+// target of function call, linked by resolver
+enum class CallTarget : unsigned char {
+  Unlinked, Input, Print, Function, NotFound, ArgCountMismatch,
+};
+
 // function call
 class FunCallAST : public BaseAST {
  public:
-  FunCallAST(const std::string &name, ASTPtrList args)
-      : name_(name), args_(std::move(args)) {}
+  FunCallAST(SymbolId name, ASTPtrList args)
+      : name_(name), args_(args), target_(CallTarget::Unlinked),
+        callee_(nullptr) {}
 
   std::optional<int> Eval(Interpreter &intp) const override;
   ValPtr GenerateIR(IRGenerator &gen) const override;
+  void Write(ASTWriter &writer) const override;
+  int GenerateBytecode(BytecodeGen &gen) const override;
+  bool GenerateNative(NativeGen &gen) const override;
+  void Resolve(Resolver &resolver) override;
+  LaneVal EvalLanes(LaneInterpreter &intp) const override;
 
   // getters
-  const std::string &name() const { return name_; }
+  SymbolId name() const { return name_; }
   const ASTPtrList &args() const { return args_; }
+  CallTarget target() const { return target_; }
+  // definition of callee, only available if target is 'Function'
+  const FunDefAST *callee() const { return callee_; }
+
+  // setters
+  void set_target(CallTarget target, const FunDefAST *callee = nullptr) {
+    target_ = target;
+    callee_ = callee;
+  }
 
  private:
-  std::string name_;
+  SymbolId name_;
   ASTPtrList args_;
+  CallTarget target_;
+  const FunDefAST *callee_;
 };
 
 // integer literal
@@ -194,6 +318,11 @@ class IntAST : public BaseAST {
 
   std::optional<int> Eval(Interpreter &intp) const override;
   ValPtr GenerateIR(IRGenerator &gen) const override;
+  void Write(ASTWriter &writer) const override;
+  int GenerateBytecode(BytecodeGen &gen) const override;
+  bool GenerateNative(NativeGen &gen) const override;
+  void Resolve(Resolver &resolver) override;
+  LaneVal EvalLanes(LaneInterpreter &intp) const override;
 
   // getters
   int val() const { return val_; }
@@ -205,16 +334,26 @@ class IntAST : public BaseAST {
 // identifier
 class IdAST : public BaseAST {
  public:
-  IdAST(const std::string &id) : id_(id) {}
+  IdAST(SymbolId id) : id_(id), slot_(0) {}
 
   std::optional<int> Eval(Interpreter &intp) const override;
   ValPtr GenerateIR(IRGenerator &gen) const override;
+  void Write(ASTWriter &writer) const override;
+  int GenerateBytecode(BytecodeGen &gen) const override;
+  bool GenerateNative(NativeGen &gen) const override;
+  void Resolve(Resolver &resolver) override;
+  LaneVal EvalLanes(LaneInterpreter &intp) const override;
 
   // getters
-  const std::string &id() const { return id_; }
+  SymbolId id() const { return id_; }
+  Slot slot() const { return slot_; }
+
+  // setters
+  void set_slot(Slot slot) { slot_ = slot; }
 
  private:
-  std::string id_;
+  SymbolId id_;
+  Slot slot_;
 };
 
 #endif  // FIRSTSTEP_DEFINE_AST_H_
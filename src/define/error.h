@@ -0,0 +1,61 @@
+#ifndef FIRSTSTEP_DEFINE_ERROR_H_
+#define FIRSTSTEP_DEFINE_ERROR_H_
+
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstddef>
+
+// error reported by a stage of the compiler
+struct ErrorInfo {
+  // offset of errors that are not related to any token
+  static constexpr std::size_t kNoOffset = static_cast<std::size_t>(-1);
+
+  // name of the stage, e.g. "parser", must be a string literal
+  std::string_view stage;
+  std::string message;
+  // offset of the token that caused the error in source
+  std::size_t offset;
+};
+
+using ErrorList = std::vector<ErrorInfo>;
+
+// stage of errors reported during evaluations, shared by all engines,
+// so that a program fails with the same message on every engine
+constexpr std::string_view kRuntimeStage = "interpreter";
+
+// reporter of errors, prints error messages to a stream in the form of
+// 'error(<stage>): <message>', or appends them to a list if it is set
+class ErrorReporter {
+ public:
+  ErrorReporter() : err_(&std::cerr), errors_(nullptr) {}
+
+  // report an error
+  void Report(std::string_view stage, std::string_view message,
+              std::size_t offset = ErrorInfo::kNoOffset) {
+    if (errors_) {
+      errors_->push_back({stage, std::string(message), offset});
+    }
+    else {
+      *err_ << "error(" << stage << "): " << message << std::endl;
+    }
+  }
+  void Report(const ErrorInfo &error) {
+    Report(error.stage, error.message, error.offset);
+  }
+
+  // set the stream for printing error messages
+  void set_err_stream(std::ostream &err) {
+    err_ = &err;
+    errors_ = nullptr;
+  }
+  // set the list for collecting errors, instead of printing them
+  void set_error_list(ErrorList &errors) { errors_ = &errors; }
+
+ private:
+  std::ostream *err_;
+  ErrorList *errors_;
+};
+
+#endif  // FIRSTSTEP_DEFINE_ERROR_H_
@@ -11,9 +11,6 @@ constexpr const char *kTempReg = "t1";
 
 }  // namespace
 
-// definition of static class members
-std::size_t LabelVal::next_id_ = 0;
-
 ValPtr FunctionDef::AddSlot() {
   return std::make_shared<SlotVal>(slot_num_++);
 }
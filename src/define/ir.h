@@ -6,13 +6,17 @@
 #include <vector>
 #include <string>
 #include <utility>
+#include <type_traits>
 #include <unordered_map>
 #include <cstddef>
 
 #include "define/token.h"
 
-// forwarded declaration of function definition
+// forwarded declarations of function definition and instructions
 class FunctionDef;
+class JumpInst;
+class LabelInst;
+class ReturnInst;
 
 // base class of all instructions
 class InstBase {
@@ -46,13 +50,20 @@ using ValPtrList = std::vector<ValPtr>;
 class FunctionDef {
  public:
   FunctionDef(const std::string &name, std::size_t arg_num)
-      : name_(name), arg_num_(arg_num), slot_num_(0) {}
+      : name_(name), arg_num_(arg_num), slot_num_(0),
+        is_reachable_(true) {}
 
   // create & push instruction to current function
+  // instructions after jumps or returns are unreachable until
+  // the next label, so they will be dropped
   template <typename Inst, typename... Args>
   void PushInst(Args &&...args) {
+    constexpr bool kIsLabel = std::is_same_v<Inst, LabelInst>;
+    if (!is_reachable_ && !kIsLabel) return;
     insts_.emplace_back(
         std::make_shared<Inst>(std::forward<Args>(args)...));
+    is_reachable_ = !std::is_same_v<Inst, JumpInst> &&
+                    !std::is_same_v<Inst, ReturnInst>;
   }
 
   // create a new stack slot definition
@@ -70,6 +81,8 @@ class FunctionDef {
  private:
   std::string name_;
   std::size_t arg_num_, slot_num_;
+  // set if the next instruction is reachable
+  bool is_reachable_;
   // empty if is library function ('input' and 'print')
   InstPtrList insts_;
 };
@@ -207,13 +220,12 @@ class ArgRefVal : public ValueBase {
 // label
 class LabelVal : public ValueBase {
  public:
-  LabelVal() : id_(next_id_++) {}
+  LabelVal(std::size_t id) : id_(id) {}
 
   void DumpRead(std::ostream &os) const override;
   void DumpWrite(std::ostream &os) const override;
 
  private:
-  static std::size_t next_id_;
   std::size_t id_;
 };
 
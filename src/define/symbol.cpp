@@ -0,0 +1,26 @@
+#include "define/symbol.h"
+
+#include <cassert>
+
+SymbolTable::SymbolTable() {
+  // intern all predefined symbols
+  auto input = Intern("input"), print = Intern("print");
+  auto main = Intern("main");
+  assert(input == kSymInput && print == kSymPrint && main == kSymMain &&
+         "predefined symbols corrupted");
+  static_cast<void>(input);
+  static_cast<void>(print);
+  static_cast<void>(main);
+}
+
+SymbolId SymbolTable::Intern(std::string_view name) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  // find in existing symbols
+  auto it = ids_.find(name);
+  if (it != ids_.end()) return it->second;
+  // add a new symbol
+  SymbolId id = names_.size();
+  const auto &str = names_.emplace_back(name);
+  ids_.insert({str, id});
+  return id;
+}
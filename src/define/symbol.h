@@ -0,0 +1,45 @@
+#ifndef FIRSTSTEP_DEFINE_SYMBOL_H_
+#define FIRSTSTEP_DEFINE_SYMBOL_H_
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <deque>
+#include <mutex>
+#include <cstdint>
+#include <cstddef>
+
+// id of interned symbols, dense integers starting from zero
+using SymbolId = std::uint32_t;
+
+// predefined symbols
+enum : SymbolId { kSymInput, kSymPrint, kSymMain };
+
+// symbol table, interns all identifiers of a compilation, thread-safe
+class SymbolTable {
+ public:
+  SymbolTable();
+
+  // get id of the specific identifier, add it to table if not found
+  SymbolId Intern(std::string_view name);
+  // get name of the specific symbol
+  std::string_view GetName(SymbolId id) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return names_[id];
+  }
+
+  // count of symbols
+  std::size_t size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return names_.size();
+  }
+
+ private:
+  // names of all symbols, indexed by symbol id
+  std::deque<std::string> names_;
+  // map of names to symbol ids, keys refer to elements of 'names_'
+  std::unordered_map<std::string_view, SymbolId> ids_;
+  mutable std::mutex mutex_;
+};
+
+#endif  // FIRSTSTEP_DEFINE_SYMBOL_H_
@@ -5,18 +5,22 @@
 #define FIRSTSTEP_KEYWORDS(e) \
   e(If, "if") e(Else, "else") e(Return, "return")
 
-// all supported operators
+// all supported operators, with precedence of binary operators
+// (0 if the operator is not a binary operator)
 #define FIRSTSTEP_OPERATORS(e) \
-  e(Add, "+") e(Sub, "-") e(Mul, "*") e(Div, "/") e(Mod, "%") \
-  e(Less, "<") e(LessEq, "<=") e(Eq, "==") e(NotEq, "!=") \
-  e(LAnd, "&&") e(LOr, "||") e(LNot, "!") e(Define, ":=") e(Assign, "=")
+  e(Add, "+", 5) e(Sub, "-", 5) e(Mul, "*", 6) e(Div, "/", 6) \
+  e(Mod, "%", 6) e(Less, "<", 4) e(LessEq, "<=", 4) e(Eq, "==", 3) \
+  e(NotEq, "!=", 3) e(LAnd, "&&", 2) e(LOr, "||", 1) e(LNot, "!", 0) \
+  e(Define, ":=", 0) e(Assign, "=", 0)
 
 // expand first element to comma-separated list
 #define FIRSTSTEP_EXPAND_FIRST(i, ...)      i,
 // expand second element to comma-separated list
 #define FIRSTSTEP_EXPAND_SECOND(i, j, ...)  j,
+// expand third element to comma-separated list
+#define FIRSTSTEP_EXPAND_THIRD(i, j, k, ...)  k,
 
-enum class Token {
+enum class Token : unsigned char {
   Error, End,
   Id, Integer, Keyword, Operator, Other,
 };
@@ -0,0 +1,445 @@
+#include "front/cache.h"
+
+#include <fstream>
+#include <chrono>
+#include <iterator>
+#include <cstdio>
+#include <cstring>
+
+#include "front/source.h"
+
+namespace {
+
+// magic number of cache files ("FSTC" in little-endian)
+// also rejects files written on machines with different byte order
+constexpr std::uint32_t kMagic = 0x43545346;
+// version of cache file format, must be increased if the format changes
+constexpr std::uint32_t kFormatVersion = 1;
+
+// tags of ASTs
+enum class ASTTag : std::uint8_t {
+  FunDef, Block, Define, Assign, If, Return,
+  Binary, Unary, FunCall, Int, Id,
+};
+
+// positions of ASTs, every position allows specific tags only
+enum class ASTPos { TopLevel, Body, Statement, Expr };
+
+constexpr std::string_view kOperators[] = {
+    FIRSTSTEP_OPERATORS(FIRSTSTEP_EXPAND_SECOND)};
+// precedence of all operators, zero if is not a binary operator
+constexpr int kPrecedence[] = {FIRSTSTEP_OPERATORS(FIRSTSTEP_EXPAND_THIRD)};
+
+// check if the specific tag can appear at the specific position,
+// as it can in ASTs produced by parser
+bool IsAllowed(ASTTag tag, ASTPos pos) {
+  switch (pos) {
+    case ASTPos::TopLevel: return tag == ASTTag::FunDef;
+    case ASTPos::Body: return tag == ASTTag::Block;
+    case ASTPos::Statement:
+      return tag == ASTTag::Define || tag == ASTTag::Assign ||
+             tag == ASTTag::If || tag == ASTTag::Return ||
+             tag == ASTTag::FunCall;
+    case ASTPos::Expr:
+      return tag == ASTTag::Binary || tag == ASTTag::Unary ||
+             tag == ASTTag::FunCall || tag == ASTTag::Int ||
+             tag == ASTTag::Id;
+  }
+  return false;
+}
+
+// 64-bit multiply-xor hash with the constants of FNV-1a, which mixes
+// 8 bytes at a time instead of one byte, so it is not FNV-1a, and it
+// only detects stale caches, but not crafted collisions
+std::uint64_t HashWords(std::string_view data) {
+  constexpr std::uint64_t kPrime = 0x100000001b3;
+  std::uint64_t hash = 0xcbf29ce484222325;
+  std::size_t i = 0;
+  for (; i + sizeof(std::uint64_t) <= data.size();
+       i += sizeof(std::uint64_t)) {
+    std::uint64_t word;
+    std::memcpy(&word, data.data() + i, sizeof(word));
+    hash = (hash ^ word) * kPrime;
+    // fold high bits down, since multiplication only mixes bits upward
+    hash ^= hash >> 32;
+  }
+  for (; i < data.size(); ++i) {
+    hash = (hash ^ static_cast<std::uint8_t>(data[i])) * kPrime;
+  }
+  return hash;
+}
+
+// deserializer of ASTs, fails safely on broken data
+// ASTs and operators that parser never produces at their positions
+// are rejected, so engines only see well-formed ASTs
+// nodes that can nest (blocks, binary and unary operators, and calls)
+// are counted like nesting levels of parser, and trees deeper than
+// the limit are rejected, so loaded ASTs are as shallow as parsed ones
+class ASTReader {
+ public:
+  ASTReader(std::string_view data, Arena &arena, std::size_t max_depth)
+      : pos_(data.data()), end_(data.data() + data.size()),
+        arena_(arena), depth_(0), max_depth_(max_depth) {}
+
+  // read integers and strings, returns false if failed
+  bool ReadU8(std::uint8_t &val) { return ReadBytes(&val, sizeof(val)); }
+  bool ReadVar(std::uint32_t &val) {
+    val = 0;
+    for (int shift = 0; shift < 32; shift += 7) {
+      std::uint8_t byte;
+      if (!ReadU8(byte)) return false;
+      val |= static_cast<std::uint32_t>(byte & 0x7f) << shift;
+      if (!(byte & 0x80)) return true;
+    }
+    return false;
+  }
+  bool ReadStr(std::string_view &str) {
+    std::uint32_t len;
+    if (!ReadVar(len) || len > Left()) return false;
+    str = {pos_, len};
+    pos_ += len;
+    return true;
+  }
+  // read count of elements, every element takes at least one byte
+  bool ReadCount(std::uint32_t &count) {
+    return ReadVar(count) && count <= Left();
+  }
+
+  // read an AST at the specific position, returns null if failed
+  ASTPtr ReadAST(ASTPos pos);
+
+  // check if reached the end of data
+  bool IsEnd() const { return pos_ == end_; }
+
+  // add a symbol, symbols are numbered in order of addition
+  void AddSymbol(SymbolId id) { syms_.push_back(id); }
+
+ private:
+  std::size_t Left() const { return end_ - pos_; }
+
+  bool ReadBytes(void *data, std::size_t size) {
+    if (size > Left()) return false;
+    std::memcpy(data, pos_, size);
+    pos_ += size;
+    return true;
+  }
+
+  bool ReadId(SymbolId &id);
+  bool ReadOp(Operator &op, bool is_binary);
+  bool ReadIds(IdList &ids);
+  bool ReadASTs(ASTPtrList &asts, ASTPos pos);
+  // read an AST with the specific tag
+  ASTPtr ReadNode(ASTTag tag);
+  ASTPtr ReadIf();
+
+  const char *pos_, *end_;
+  Arena &arena_;
+  // current & max nesting depth
+  std::size_t depth_, max_depth_;
+  // symbol ids in cache file to symbol ids in symbol table
+  std::vector<SymbolId> syms_;
+};
+
+ASTPtr ASTReader::ReadAST(ASTPos pos) {
+  std::uint8_t byte;
+  if (!ReadU8(byte)) return nullptr;
+  auto tag = static_cast<ASTTag>(byte);
+  if (!IsAllowed(tag, pos)) return nullptr;
+  bool is_nesting = tag == ASTTag::Block || tag == ASTTag::Binary ||
+                    tag == ASTTag::Unary || tag == ASTTag::FunCall;
+  if (is_nesting && ++depth_ > max_depth_) return nullptr;
+  auto ast = ReadNode(tag);
+  if (is_nesting) --depth_;
+  return ast;
+}
+
+ASTPtr ASTReader::ReadNode(ASTTag tag) {
+  switch (tag) {
+    case ASTTag::FunDef: {
+      SymbolId name;
+      IdList args;
+      if (!ReadId(name) || !ReadIds(args)) return nullptr;
+      auto body = ReadAST(ASTPos::Body);
+      if (!body) return nullptr;
+      return arena_.New<FunDefAST>(name, args, body);
+    }
+    case ASTTag::Block: {
+      ASTPtrList stmts;
+      if (!ReadASTs(stmts, ASTPos::Statement)) return nullptr;
+      return arena_.New<BlockAST>(stmts);
+    }
+    case ASTTag::Define: case ASTTag::Assign: {
+      SymbolId name;
+      if (!ReadId(name)) return nullptr;
+      auto expr = ReadAST(ASTPos::Expr);
+      if (!expr) return nullptr;
+      if (tag == ASTTag::Define) {
+        return arena_.New<DefineAST>(name, expr);
+      }
+      return arena_.New<AssignAST>(name, expr);
+    }
+    case ASTTag::If: return ReadIf();
+    case ASTTag::Return: {
+      auto expr = ReadAST(ASTPos::Expr);
+      if (!expr) return nullptr;
+      return arena_.New<ReturnAST>(expr);
+    }
+    case ASTTag::Binary: {
+      Operator op;
+      if (!ReadOp(op, true)) return nullptr;
+      auto lhs = ReadAST(ASTPos::Expr);
+      if (!lhs) return nullptr;
+      auto rhs = ReadAST(ASTPos::Expr);
+      if (!rhs) return nullptr;
+      return arena_.New<BinaryAST>(op, lhs, rhs);
+    }
+    case ASTTag::Unary: {
+      Operator op;
+      if (!ReadOp(op, false)) return nullptr;
+      auto opr = ReadAST(ASTPos::Expr);
+      if (!opr) return nullptr;
+      return arena_.New<UnaryAST>(op, opr);
+    }
+    case ASTTag::FunCall: {
+      SymbolId name;
+      ASTPtrList args;
+      if (!ReadId(name) || !ReadASTs(args, ASTPos::Expr)) return nullptr;
+      return arena_.New<FunCallAST>(name, args);
+    }
+    case ASTTag::Int: {
+      std::uint32_t val;
+      if (!ReadVar(val)) return nullptr;
+      return arena_.New<IntAST>(static_cast<int>(val));
+    }
+    case ASTTag::Id: {
+      SymbolId id;
+      if (!ReadId(id)) return nullptr;
+      return arena_.New<IdAST>(id);
+    }
+    default: return nullptr;
+  }
+}
+
+bool ASTReader::ReadId(SymbolId &id) {
+  std::uint32_t index;
+  if (!ReadVar(index) || index >= syms_.size()) return false;
+  id = syms_[index];
+  return true;
+}
+
+bool ASTReader::ReadOp(Operator &op, bool is_binary) {
+  std::uint8_t index;
+  if (!ReadU8(index) || index >= std::size(kOperators)) return false;
+  op = static_cast<Operator>(index);
+  // only operators supported by parser are allowed
+  if (is_binary) return kPrecedence[index] > 0;
+  return op == Operator::Sub || op == Operator::LNot;
+}
+
+bool ASTReader::ReadIds(IdList &ids) {
+  std::uint32_t count;
+  if (!ReadCount(count)) return false;
+  auto data = static_cast<SymbolId *>(
+      arena_.Allocate(sizeof(SymbolId) * count, alignof(SymbolId)));
+  for (std::uint32_t i = 0; i < count; ++i) {
+    if (!ReadId(data[i])) return false;
+  }
+  ids = {data, count};
+  return true;
+}
+
+bool ASTReader::ReadASTs(ASTPtrList &asts, ASTPos pos) {
+  std::uint32_t count;
+  if (!ReadCount(count)) return false;
+  auto data = static_cast<ASTPtr *>(
+      arena_.Allocate(sizeof(ASTPtr) * count, alignof(ASTPtr)));
+  for (std::uint32_t i = 0; i < count; ++i) {
+    if (!(data[i] = ReadAST(pos))) return false;
+  }
+  asts = {data, count};
+  return true;
+}
+
+ASTPtr ASTReader::ReadIf() {
+  // read all branches of the 'else if' chain
+  std::uint32_t count;
+  if (!ReadCount(count) || !count) return nullptr;
+  std::vector<ASTPtr> branches;
+  for (std::uint32_t i = 0; i < count; ++i) {
+    auto cond = ReadAST(ASTPos::Expr);
+    if (!cond) return nullptr;
+    auto then = ReadAST(ASTPos::Body);
+    if (!then) return nullptr;
+    branches.push_back(cond);
+    branches.push_back(then);
+  }
+  // read 'else-then' body
+  std::uint8_t has_else;
+  if (!ReadU8(has_else)) return nullptr;
+  ASTPtr else_then = nullptr;
+  if (has_else && !(else_then = ReadAST(ASTPos::Body))) return nullptr;
+  // build the chain from the last branch
+  IfAST *if_else = nullptr;
+  for (auto i = branches.size(); i; i -= 2) {
+    if_else = arena_.New<IfAST>(branches[i - 2], branches[i - 1],
+                                if_else ? nullptr : else_then, if_else);
+  }
+  return if_else;
+}
+
+}  // namespace
+
+void ASTWriter::WriteOn(const FunDefAST &ast) {
+  WriteU8(static_cast<std::uint8_t>(ASTTag::FunDef));
+  WriteVar(ast.name());
+  WriteVar(ast.args().size());
+  for (const auto &arg : ast.args()) WriteVar(arg);
+  Write(*ast.body());
+}
+
+void ASTWriter::WriteOn(const BlockAST &ast) {
+  WriteU8(static_cast<std::uint8_t>(ASTTag::Block));
+  WriteVar(ast.stmts().size());
+  for (const auto &stmt : ast.stmts()) Write(*stmt);
+}
+
+void ASTWriter::WriteOn(const DefineAST &ast) {
+  WriteU8(static_cast<std::uint8_t>(ASTTag::Define));
+  WriteVar(ast.name());
+  Write(*ast.expr());
+}
+
+void ASTWriter::WriteOn(const AssignAST &ast) {
+  WriteU8(static_cast<std::uint8_t>(ASTTag::Assign));
+  WriteVar(ast.name());
+  Write(*ast.expr());
+}
+
+void ASTWriter::WriteOn(const IfAST &ast) {
+  WriteU8(static_cast<std::uint8_t>(ASTTag::If));
+  // write all branches of the 'else if' chain iteratively
+  std::uint32_t count = 0;
+  for (auto cur = &ast; cur; cur = cur->else_if()) ++count;
+  WriteVar(count);
+  auto last = &ast;
+  for (auto cur = &ast; cur; cur = cur->else_if()) {
+    Write(*cur->cond());
+    Write(*cur->then());
+    last = cur;
+  }
+  // write 'else-then' body
+  WriteU8(last->else_then() != nullptr);
+  if (last->else_then()) Write(*last->else_then());
+}
+
+void ASTWriter::WriteOn(const ReturnAST &ast) {
+  WriteU8(static_cast<std::uint8_t>(ASTTag::Return));
+  Write(*ast.expr());
+}
+
+void ASTWriter::WriteOn(const BinaryAST &ast) {
+  WriteU8(static_cast<std::uint8_t>(ASTTag::Binary));
+  WriteU8(static_cast<std::uint8_t>(ast.op()));
+  Write(*ast.lhs());
+  Write(*ast.rhs());
+}
+
+void ASTWriter::WriteOn(const UnaryAST &ast) {
+  WriteU8(static_cast<std::uint8_t>(ASTTag::Unary));
+  WriteU8(static_cast<std::uint8_t>(ast.op()));
+  Write(*ast.opr());
+}
+
+void ASTWriter::WriteOn(const FunCallAST &ast) {
+  WriteU8(static_cast<std::uint8_t>(ASTTag::FunCall));
+  WriteVar(ast.name());
+  WriteVar(ast.args().size());
+  for (const auto &arg : ast.args()) Write(*arg);
+}
+
+void ASTWriter::WriteOn(const IntAST &ast) {
+  WriteU8(static_cast<std::uint8_t>(ASTTag::Int));
+  WriteVar(static_cast<std::uint32_t>(ast.val()));
+}
+
+void ASTWriter::WriteOn(const IdAST &ast) {
+  WriteU8(static_cast<std::uint8_t>(ASTTag::Id));
+  WriteVar(ast.id());
+}
+
+ProgramCache::ProgramCache(std::string_view src, const char *src_path)
+    : src_size_(src.size()), src_hash_(HashWords(src)),
+      path_(std::string(src_path) + ".cache") {}
+
+void ProgramCache::WriteHeader(ASTWriter &writer) const {
+  writer.WriteU32(kMagic);
+  writer.WriteU32(kFormatVersion);
+  writer.WriteStr(APP_VERSION);
+  writer.WriteU64(src_size_);
+  writer.WriteU64(src_hash_);
+}
+
+bool ProgramCache::Load(SymbolTable &symbols, Arena &arena,
+                        std::vector<ASTPtr> &funcs,
+                        std::size_t max_depth) const {
+  SourceBuffer file(path_.c_str());
+  if (!file.is_open()) return false;
+  // check header
+  ASTWriter header;
+  WriteHeader(header);
+  auto data = file.data();
+  const auto &expected = header.buffer();
+  if (data.substr(0, expected.size()) != expected) return false;
+  // parentheses are not kept in ASTs, so a unary operator applied to
+  // a parenthesized expression may be one level deeper than in parser
+  ASTReader reader(data.substr(expected.size()), arena, max_depth + 1);
+  // read symbols
+  std::uint32_t sym_num;
+  if (!reader.ReadCount(sym_num)) return false;
+  for (std::uint32_t i = 0; i < sym_num; ++i) {
+    std::string_view name;
+    if (!reader.ReadStr(name)) return false;
+    reader.AddSymbol(symbols.Intern(name));
+  }
+  // read function definitions
+  std::uint32_t func_num;
+  if (!reader.ReadCount(func_num)) return false;
+  std::vector<ASTPtr> loaded;
+  loaded.reserve(func_num);
+  for (std::uint32_t i = 0; i < func_num; ++i) {
+    auto func = reader.ReadAST(ASTPos::TopLevel);
+    if (!func) return false;
+    loaded.push_back(func);
+  }
+  if (!reader.IsEnd()) return false;
+  funcs = std::move(loaded);
+  return true;
+}
+
+bool ProgramCache::Save(const SymbolTable &symbols,
+                        const std::vector<ASTPtr> &funcs) const {
+  ASTWriter writer;
+  WriteHeader(writer);
+  // write symbols
+  auto sym_num = symbols.size();
+  writer.WriteVar(sym_num);
+  for (SymbolId i = 0; i < sym_num; ++i) {
+    writer.WriteStr(symbols.GetName(i));
+  }
+  // write function definitions
+  writer.WriteVar(funcs.size());
+  for (const auto &func : funcs) writer.Write(*func);
+  // write to a temporary file and then rename it,
+  // so that other processes never see a partially written cache file
+  auto stamp = std::chrono::steady_clock::now().time_since_epoch().count();
+  auto temp = path_ + ".tmp" + std::to_string(stamp);
+  std::ofstream ofs(temp, std::ios::binary);
+  const auto &buffer = writer.buffer();
+  ofs.write(buffer.data(), buffer.size());
+  ofs.close();
+  if (!ofs || std::rename(temp.c_str(), path_.c_str())) {
+    std::remove(temp.c_str());
+    return false;
+  }
+  return true;
+}
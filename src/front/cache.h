@@ -0,0 +1,88 @@
+#ifndef FIRSTSTEP_FRONT_CACHE_H_
+#define FIRSTSTEP_FRONT_CACHE_H_
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "define/ast.h"
+#include "define/symbol.h"
+#include "define/arena.h"
+
+// serializer of ASTs, writes ASTs in pre-order to a byte buffer
+class ASTWriter {
+ public:
+  // write the specific AST to buffer
+  void Write(const BaseAST &ast) { ast.Write(*this); }
+
+  // visitor methods
+  void WriteOn(const FunDefAST &ast);
+  void WriteOn(const BlockAST &ast);
+  void WriteOn(const DefineAST &ast);
+  void WriteOn(const AssignAST &ast);
+  void WriteOn(const IfAST &ast);
+  void WriteOn(const ReturnAST &ast);
+  void WriteOn(const BinaryAST &ast);
+  void WriteOn(const UnaryAST &ast);
+  void WriteOn(const FunCallAST &ast);
+  void WriteOn(const IntAST &ast);
+  void WriteOn(const IdAST &ast);
+
+  // write integers and strings to buffer
+  // fixed-size integers are written in native byte order
+  void WriteU8(std::uint8_t val) { buffer_.push_back(val); }
+  void WriteU32(std::uint32_t val) { WriteBytes(&val, sizeof(val)); }
+  void WriteU64(std::uint64_t val) { WriteBytes(&val, sizeof(val)); }
+  // write variable-length integer (LEB128), 7 bits per byte
+  void WriteVar(std::uint32_t val) {
+    for (; val >= 0x80; val >>= 7) WriteU8(val | 0x80);
+    WriteU8(val);
+  }
+  void WriteStr(std::string_view str) {
+    WriteVar(str.size());
+    WriteBytes(str.data(), str.size());
+  }
+
+  // written bytes
+  const std::string &buffer() const { return buffer_; }
+
+ private:
+  void WriteBytes(const void *data, std::size_t size) {
+    buffer_.append(static_cast<const char *>(data), size);
+  }
+
+  std::string buffer_;
+};
+
+// cache file of parsed program, stored next to the source file
+// the cache is keyed by the hash of source file and the version of
+// compiler, and is ignored if either of them changes
+class ProgramCache {
+ public:
+  ProgramCache(std::string_view src, const char *src_path);
+
+  // load all function definitions from the cache file
+  // symbols are interned to the specific symbol table, programs
+  // nested deeper than 'max_depth' of parser are rejected,
+  // returns false if the cache file is missing, stale or broken
+  bool Load(SymbolTable &symbols, Arena &arena,
+            std::vector<ASTPtr> &funcs, std::size_t max_depth) const;
+  // save all function definitions to the cache file
+  // returns false if failed
+  bool Save(const SymbolTable &symbols,
+            const std::vector<ASTPtr> &funcs) const;
+
+  // path of the cache file
+  const std::string &path() const { return path_; }
+
+ private:
+  // write header of the cache file
+  void WriteHeader(ASTWriter &writer) const;
+
+  std::uint64_t src_size_, src_hash_;
+  std::string path_;
+};
+
+#endif  // FIRSTSTEP_FRONT_CACHE_H_
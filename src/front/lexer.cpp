@@ -1,51 +1,150 @@
 #include "front/lexer.h"
 
-#include <iostream>
-#include <utility>
-#include <cctype>
-#include <cstdlib>
+#include <array>
+#include <charconv>
+#include <iterator>
+#include <cstdint>
 
 namespace {
 
-const char *kKeywords[] = {FIRSTSTEP_KEYWORDS(FIRSTSTEP_EXPAND_SECOND)};
-const char *kOperators[] = {FIRSTSTEP_OPERATORS(FIRSTSTEP_EXPAND_SECOND)};
+// max length of character runs that are scanned inline
+constexpr int kInlineScanLen = 4;
 
-// get index of a string in string array
-template <typename T, std::size_t N>
-int GetIndex(std::string_view str, T (&str_array)[N]) {
-  for (std::size_t i = 0; i < N; ++i) {
-    if (str == str_array[i]) return i;
+// classes of characters
+enum CharClass : std::uint8_t {
+  kSpace = 1 << 0, kIdHead = 1 << 1, kIdBody = 1 << 2,
+  kDigit = 1 << 3, kOpChar = 1 << 4,
+};
+
+// get bit width of a hash table with at least twice as many slots as keys
+constexpr std::size_t GetTableBits(std::size_t n) {
+  std::size_t bits = 1;
+  while ((std::size_t(1) << bits) < n * 2) ++bits;
+  return bits;
+}
+
+// perfect hash table of a fixed string set, built at compile time
+template <std::size_t N, std::size_t Bits = GetTableBits(N)>
+class PerfectHash {
+ public:
+  constexpr PerfectHash(const std::string_view (&strs)[N])
+      : strs_(), seed_(0), slots_() {
+    for (std::size_t i = 0; i < N; ++i) strs_[i] = strs[i];
+    // search for a seed which has no collision
+    for (std::uint32_t i = 1; i < 4096; ++i) {
+      auto seed = (i * 0x9e3779b9u) | 1;
+      if (TryBuild(seed)) {
+        seed_ = seed;
+        break;
+      }
+    }
+  }
+
+  // check if the hash table has been built successfully
+  constexpr bool is_valid() const { return seed_; }
+
+  // get index of the specific string, returns -1 if not found
+  constexpr int Find(std::string_view str) const {
+    auto index = slots_[Hash(str, seed_)];
+    return index >= 0 && strs_[index] == str ? index : -1;
+  }
+
+ private:
+  // hash of the first character, the last character and the length
+  static constexpr std::size_t Hash(std::string_view str,
+                                    std::uint32_t seed) {
+    std::uint32_t key = static_cast<std::uint8_t>(str.front()) |
+                        static_cast<std::uint8_t>(str.back()) << 8 |
+                        static_cast<std::uint32_t>(str.size()) << 16;
+    return (key * seed) >> (32 - Bits);
+  }
+
+  constexpr bool TryBuild(std::uint32_t seed) {
+    for (auto &i : slots_) i = -1;
+    for (std::size_t i = 0; i < N; ++i) {
+      auto &slot = slots_[Hash(strs_[i], seed)];
+      if (slot >= 0) return false;
+      slot = i;
+    }
+    return true;
   }
-  return -1;
+
+  std::array<std::string_view, N> strs_;
+  std::uint32_t seed_;
+  std::array<int, 1 << Bits> slots_;
+};
+
+constexpr std::string_view kKeywords[] = {
+    FIRSTSTEP_KEYWORDS(FIRSTSTEP_EXPAND_SECOND)};
+constexpr std::string_view kOperators[] = {
+    FIRSTSTEP_OPERATORS(FIRSTSTEP_EXPAND_SECOND)};
+
+constexpr PerfectHash<std::size(kKeywords)> kKeywordTable(kKeywords);
+constexpr PerfectHash<std::size(kOperators)> kOperatorTable(kOperators);
+static_assert(kKeywordTable.is_valid(), "no perfect hash for keywords");
+static_assert(kOperatorTable.is_valid(), "no perfect hash for operators");
+
+// generate character class table
+constexpr std::array<std::uint8_t, 256> MakeCharClasses() {
+  std::array<std::uint8_t, 256> classes = {};
+  for (auto c : {' ', '\t', '\n', '\v', '\f', '\r'}) classes[c] |= kSpace;
+  for (int c = 'a'; c <= 'z'; ++c) classes[c] |= kIdHead | kIdBody;
+  for (int c = 'A'; c <= 'Z'; ++c) classes[c] |= kIdHead | kIdBody;
+  classes['_'] |= kIdHead | kIdBody;
+  for (int c = '0'; c <= '9'; ++c) classes[c] |= kIdBody | kDigit;
+  for (const auto &op : kOperators) {
+    for (auto c : op) classes[static_cast<std::uint8_t>(c)] |= kOpChar;
+  }
+  return classes;
+}
+
+constexpr auto kCharClasses = MakeCharClasses();
+
+// check if the specific character belongs to the specific class
+inline bool IsClass(char c, CharClass cls) {
+  return kCharClasses[static_cast<std::uint8_t>(c)] & cls;
 }
 
-bool IsOperatorChar(char c) {
-  const char op_chars[] = "+-*/%<=!&|:";
-  for (const auto &i : op_chars) {
-    if (i == c) return true;
+// skip the run of characters of the specific class
+// most runs are short, so the first few characters are checked inline,
+// and the rest of the run is left to the (vectorized) scanning function
+template <CharClass kClass>
+inline const char *SkipRun(const char *pos, const char *end,
+                           const char *(*skip)(const char *,
+                                               const char *)) {
+  for (int i = 0; i < kInlineScanLen; ++i) {
+    if (pos == end || !IsClass(*pos, kClass)) return pos;
+    ++pos;
   }
-  return false;
+  return skip(pos, end);
 }
 
 }  // namespace
 
 Token Lexer::LogError(std::string_view message) {
-  std::cerr << "error(lexer): " << message << std::endl;
+  if (err_) *err_ << "error(lexer): " << message << std::endl;
   ++error_num_;
+  error_val_ = message;
   return Token::Error;
 }
 
+SymbolId Lexer::Intern(std::string_view id) {
+  auto it = sym_cache_.find(id);
+  if (it != sym_cache_.end()) return it->second;
+  auto sym = symbols_.Intern(id);
+  sym_cache_.insert({id, sym});
+  return sym;
+}
+
 Token Lexer::HandleId() {
   // read string
-  std::string id;
-  do {
-    id += last_char_;
-    NextChar();
-  } while (!in_.eof() && (std::isalnum(last_char_) || last_char_ == '_'));
+  auto begin = pos_;
+  pos_ = SkipRun<kIdBody>(pos_ + 1, end_, scan_.skip_id);
+  std::string_view id(begin, pos_ - begin);
   // check if string is keyword
-  int index = GetIndex(id, kKeywords);
+  int index = kKeywordTable.Find(id);
   if (index < 0) {
-    id_val_ = std::move(id);
+    id_val_ = Intern(id);
     return Token::Id;
   }
   else {
@@ -56,55 +155,83 @@ Token Lexer::HandleId() {
 
 Token Lexer::HandleInteger() {
   // read string
-  std::string num;
-  do {
-    num += last_char_;
-    NextChar();
-  } while (!in_.eof() && std::isdigit(last_char_));
+  auto begin = pos_;
+  pos_ = SkipRun<kDigit>(pos_ + 1, end_, scan_.skip_digits);
   // try to convert to integer
-  char *end_pos;
-  int_val_ = std::strtol(num.c_str(), &end_pos, 10);
-  return *end_pos || (num[0] == '0' && num.size() > 1)
+  long num = 0;
+  auto [end_pos, ec] = std::from_chars(begin, pos_, num);
+  int_val_ = num;
+  return end_pos != pos_ || ec != std::errc() ||
+                 (*begin == '0' && pos_ - begin > 1)
              ? LogError("invalid number") : Token::Integer;
 }
 
 Token Lexer::HandleOperator() {
   // read string
-  std::string op;
+  auto begin = pos_;
   do {
-    op += last_char_;
-    NextChar();
-  } while (!in_.eof() && IsOperatorChar(last_char_));
+    ++pos_;
+  } while (!IsEnd() && IsClass(*pos_, kOpChar));
   // check if operator is valid
-  int index = GetIndex(op, kOperators);
+  int index = kOperatorTable.Find({begin, std::size_t(pos_ - begin)});
   if (index < 0) return LogError("invalid operator");
   op_val_ = static_cast<Operator>(index);
   return Token::Operator;
 }
 
-Token Lexer::HandleComment() {
+void Lexer::HandleComment() {
   // skip the current line
-  while (!in_.eof() && last_char_ != '\n' && last_char_ != '\r') {
-    NextChar();
-  }
-  return NextToken();
+  pos_ = scan_.skip_line(pos_, end_);
 }
 
 Token Lexer::NextToken() {
-  // skip spaces
-  while (!in_.eof() && std::isspace(last_char_)) NextChar();
-  // end of file
-  if (in_.eof()) return Token::End;
-  // skip comments
-  if (last_char_ == '#') return HandleComment();
+  for (;;) {
+    // skip spaces
+    pos_ = SkipRun<kSpace>(pos_, end_, scan_.skip_spaces);
+    // end of file
+    if (IsEnd()) {
+      token_pos_ = pos_;
+      return Token::End;
+    }
+    // skip comments
+    if (*pos_ != '#') break;
+    HandleComment();
+  }
+  token_pos_ = pos_;
   // id or keyword
-  if (std::isalpha(last_char_) || last_char_ == '_') return HandleId();
+  if (IsClass(*pos_, kIdHead)) return HandleId();
   // number
-  if (std::isdigit(last_char_)) return HandleInteger();
+  if (IsClass(*pos_, kDigit)) return HandleInteger();
   // operator
-  if (IsOperatorChar(last_char_)) return HandleOperator();
+  if (IsClass(*pos_, kOpChar)) return HandleOperator();
   // other characters
-  other_val_ = last_char_;
-  NextChar();
+  other_val_ = *pos_++;
   return Token::Other;
 }
+
+void Lexer::Tokenize(TokenBuffer &tokens) {
+  // usually there is a token in every 3 bytes
+  tokens.Reserve(tokens.size() + (end_ - pos_) / 3 + 1);
+  auto err = err_;
+  err_ = nullptr;
+  for (;;) {
+    auto token = NextToken();
+    switch (token) {
+      case Token::Error: tokens.AddError(error_val_, offset()); continue;
+      case Token::Id: tokens.Add(token, id_val_, offset()); continue;
+      case Token::Integer: tokens.Add(token, int_val_, offset()); continue;
+      case Token::Keyword: {
+        tokens.Add(token, static_cast<std::uint32_t>(key_val_), offset());
+        continue;
+      }
+      case Token::Operator: {
+        tokens.Add(token, static_cast<std::uint32_t>(op_val_), offset());
+        continue;
+      }
+      case Token::Other: tokens.Add(token, other_val_, offset()); continue;
+      case Token::End: tokens.Add(token, 0, offset()); break;
+    }
+    break;
+  }
+  err_ = err;
+}
@@ -1,28 +1,43 @@
 #ifndef FIRSTSTEP_FRONT_LEXER_H_
 #define FIRSTSTEP_FRONT_LEXER_H_
 
-#include <istream>
-#include <string>
+#include <iostream>
 #include <string_view>
+#include <unordered_map>
 #include <cstddef>
 
+#include "front/scan.h"
+#include "front/tokens.h"
 #include "define/token.h"
+#include "define/symbol.h"
 
 class Lexer {
  public:
-  Lexer(std::istream &in) : in_(in) {
-    in_ >> std::noskipws;
-    last_char_ = ' ';
+  // scan tokens from the specific source buffer
+  // identifiers are interned to the specific symbol table
+  Lexer(std::string_view src, SymbolTable &symbols,
+        const ScanFuncs &scan = GetScanFuncs())
+      : begin_(src.data()), pos_(src.data()), token_pos_(src.data()),
+        end_(src.data() + src.size()), symbols_(symbols), scan_(scan) {
     error_num_ = 0;
+    err_ = &std::cerr;
   }
 
-  // get next token from input stream
+  // get next token from input buffer
   Token NextToken();
+  // scan all the rest tokens to the specific token buffer
+  // errors are stored in the buffer as error tokens instead of printing
+  void Tokenize(TokenBuffer &tokens);
+
+  // set the stream for printing error messages
+  void set_err_stream(std::ostream &err) { err_ = &err; }
 
   // count of error
   std::size_t error_num() const { return error_num_; }
+  // offset of the current token in source
+  std::size_t offset() const { return token_pos_ - begin_; }
   // identifiers
-  const std::string &id_val() const { return id_val_; }
+  SymbolId id_val() const { return id_val_; }
   // integer value
   int int_val() const { return int_val_; }
   // keywords
@@ -31,30 +46,41 @@ class Lexer {
   Operator op_val() const { return op_val_; }
   // other characters
   char other_val() const { return other_val_; }
+  // error message
+  std::string_view error_val() const { return error_val_; }
 
  private:
-  // read next character
-  void NextChar() { in_ >> last_char_; }
+  // check if reached the end of input buffer
+  bool IsEnd() const { return pos_ == end_; }
 
-  // print error message to stderr
+  // print error message to error stream
   Token LogError(std::string_view message);
+  // intern the specific identifier
+  SymbolId Intern(std::string_view id);
 
   // handle tokens
   Token HandleId();
   Token HandleInteger();
   Token HandleOperator();
-  Token HandleComment();
-  Token HandleEOL();
+  void HandleComment();
 
-  std::istream &in_;
-  char last_char_;
+  const char *begin_, *pos_, *token_pos_, *end_;
+  SymbolTable &symbols_;
+  // interned symbols, for reducing accesses to the shared symbol table
+  // keys refer to the source buffer
+  std::unordered_map<std::string_view, SymbolId> sym_cache_;
+  // functions for scanning character runs
+  const ScanFuncs &scan_;
   std::size_t error_num_;
+  // stream for printing error messages, null if not printing
+  std::ostream *err_;
   // value of token
-  std::string id_val_;
+  SymbolId id_val_;
   int int_val_;
   Keyword key_val_;
   Operator op_val_;
   char other_val_;
+  std::string_view error_val_;
 };
 
 #endif  // FIRSTSTEP_FRONT_LEXER_H_
@@ -0,0 +1,137 @@
+#include "front/parallel.h"
+
+#include <iostream>
+#include <sstream>
+#include <algorithm>
+
+#include "front/scan.h"
+#include "front/lexer.h"
+#include "front/parser.h"
+
+namespace {
+
+// count of parts per thread, more parts balance load better
+constexpr std::size_t kPartsPerThread = 16;
+// min size of parts in bytes
+constexpr std::size_t kMinPartSize = 4096;
+
+}  // namespace
+
+ParallelParser::ParallelParser(std::string_view src, SymbolTable &symbols,
+                               Arena &arena, std::size_t thread_num)
+    : symbols_(symbols), arena_(arena),
+      thread_num_(thread_num ? thread_num : 1),
+      max_depth_(Parser::kDefaultMaxDepth), error_num_(0),
+      next_part_(0), stop_(false), cur_part_(0), cur_func_(0),
+      diag_pos_(0), base_error_num_(0) {
+  SplitSource(src);
+}
+
+ParallelParser::~ParallelParser() {
+  stop_ = true;
+  for (auto &worker : workers_) worker.join();
+  // move all ASTs to the output arena
+  for (auto &arena : arenas_) arena_.Absorb(arena);
+}
+
+void ParallelParser::SplitSource(std::string_view src) {
+  const auto &scan = GetScanFuncs();
+  auto part_size = src.size() / (thread_num_ * kPartsPerThread);
+  if (part_size < kMinPartSize) part_size = kMinPartSize;
+  // find all closing braces at the top level
+  auto begin = src.data(), pos = begin, end = begin + src.size();
+  auto part_begin = begin;
+  std::size_t depth = 0;
+  while (pos != end) {
+    switch (*pos++) {
+      case '#': pos = scan.skip_line(pos, end); break;
+      case '{': ++depth; break;
+      case '}': {
+        // unmatched braces will be reported by the parser
+        if (!depth || --depth) break;
+        if (static_cast<std::size_t>(pos - part_begin) >= part_size) {
+          parts_.push_back({{part_begin, std::size_t(pos - part_begin)},
+                            {}, {}, false, false});
+          part_begin = pos;
+        }
+        break;
+      }
+    }
+  }
+  if (part_begin != end || parts_.empty()) {
+    parts_.push_back({{part_begin, std::size_t(end - part_begin)},
+                      {}, {}, false, false});
+  }
+}
+
+void ParallelParser::Start() {
+  auto thread_num = std::min(thread_num_, parts_.size());
+  for (std::size_t i = 0; i < thread_num; ++i) {
+    auto &arena = arenas_.emplace_back();
+    workers_.emplace_back([this, &arena] { Work(arena); });
+  }
+}
+
+void ParallelParser::Work(Arena &arena) {
+  while (!stop_) {
+    auto i = next_part_++;
+    if (i >= parts_.size()) break;
+    ParsePart(parts_[i], arena);
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      parts_[i].done = true;
+    }
+    cv_.notify_all();
+  }
+}
+
+void ParallelParser::ParsePart(Part &part, Arena &arena) {
+  // scan all tokens in part
+  TokenBuffer tokens;
+  Lexer lexer(part.src, symbols_);
+  lexer.Tokenize(tokens);
+  // parse, error messages are printed to buffer
+  std::ostringstream diags;
+  Parser parser(tokens, arena);
+  parser.set_err_stream(diags);
+  parser.set_max_depth(max_depth_);
+  // parse all function definitions in part
+  for (;;) {
+    auto func = parser.ParseNext();
+    part.funcs.push_back({func, static_cast<std::size_t>(diags.tellp()),
+                          parser.error_num()});
+    if (!func) break;
+  }
+  part.has_error = parser.error_num();
+  part.diags = diags.str();
+}
+
+ASTPtr ParallelParser::ParseNext() {
+  if (workers_.empty()) Start();
+  while (cur_part_ < parts_.size()) {
+    auto &part = parts_[cur_part_];
+    if (!cur_func_) {
+      // wait for the current part
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait(lock, [&part] { return part.done; });
+    }
+    // print error messages that reported before the current function
+    const auto &info = part.funcs[cur_func_++];
+    std::cerr.write(part.diags.data() + diag_pos_,
+                    info.diag_end - diag_pos_);
+    diag_pos_ = info.diag_end;
+    error_num_ = base_error_num_ + info.error_num;
+    if (info.func) return info.func;
+    // reached the end of part
+    if (part.has_error) {
+      // stop parsing, just like the sequential parser
+      cur_part_ = parts_.size();
+      stop_ = true;
+      break;
+    }
+    ++cur_part_;
+    cur_func_ = diag_pos_ = 0;
+    base_error_num_ = error_num_;
+  }
+  return nullptr;
+}
@@ -0,0 +1,87 @@
+#ifndef FIRSTSTEP_FRONT_PARALLEL_H_
+#define FIRSTSTEP_FRONT_PARALLEL_H_
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstddef>
+
+#include "define/ast.h"
+#include "define/symbol.h"
+#include "define/arena.h"
+
+// parser that parses function definitions on multiple threads
+// the source is split into parts of whole function definitions by
+// matching braces, then parts are lexed and parsed concurrently,
+// function definitions and error messages are handed out in source order
+class ParallelParser {
+ public:
+  // all ASTs are moved to the specific arena after parsing
+  ParallelParser(std::string_view src, SymbolTable &symbols, Arena &arena,
+                 std::size_t thread_num);
+  ~ParallelParser();
+
+  ParallelParser(const ParallelParser &) = delete;
+  ParallelParser &operator=(const ParallelParser &) = delete;
+
+  // parse next function definition, returns null if reached the end
+  // or there are errors, just like 'Parser::ParseNext'
+  ASTPtr ParseNext();
+
+  // set the max nesting depth, must be called before 'ParseNext'
+  void set_max_depth(std::size_t max_depth) { max_depth_ = max_depth; }
+
+  // count of error (of lexers and parsers)
+  std::size_t error_num() const { return error_num_; }
+
+ private:
+  // parsed function definition
+  struct FuncInfo {
+    // null if reached the end of part or there are errors
+    ASTPtr func;
+    // end position of error messages, count of errors in part
+    std::size_t diag_end, error_num;
+  };
+
+  // part of source, contains whole function definitions
+  struct Part {
+    std::string_view src;
+    std::vector<FuncInfo> funcs;
+    // error messages of part
+    std::string diags;
+    // set if parser stopped by an error
+    bool has_error;
+    bool done;
+  };
+
+  // split source into parts
+  void SplitSource(std::string_view src);
+  // start worker threads
+  void Start();
+  // take parts and parse them
+  void Work(Arena &arena);
+  // parse the specific part
+  void ParsePart(Part &part, Arena &arena);
+
+  SymbolTable &symbols_;
+  Arena &arena_;
+  std::size_t thread_num_, max_depth_, error_num_;
+  std::vector<Part> parts_;
+  // per-thread arenas and worker threads
+  std::deque<Arena> arenas_;
+  std::vector<std::thread> workers_;
+  // index of the next part to be parsed
+  std::atomic<std::size_t> next_part_;
+  std::atomic<bool> stop_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  // index of the current part and function, position of error messages
+  std::size_t cur_part_, cur_func_, diag_pos_, base_error_num_;
+};
+
+#endif  // FIRSTSTEP_FRONT_PARALLEL_H_
@@ -1,28 +1,42 @@
 #include "front/parser.h"
 
-#include <iostream>
-#include <algorithm>
+namespace {
+
+// precedence of all operators, zero if is not a binary operator
+constexpr int kPrecedence[] = {FIRSTSTEP_OPERATORS(FIRSTSTEP_EXPAND_THIRD)};
+
+}  // namespace
 
 ASTPtr Parser::LogError(std::string_view message) {
-  std::cerr << "error(parser): " << message << std::endl;
+  reporter_.Report("parser", message, tokens_.offset(pos_));
   ++error_num_;
   return nullptr;
 }
 
+Token Parser::LoadToken() {
+  cur_token_ = tokens_.kind(pos_);
+  if (cur_token_ == Token::Error) {
+    reporter_.Report("lexer", tokens_.error_val(pos_),
+                     tokens_.offset(pos_));
+    ++error_num_;
+  }
+  return cur_token_;
+}
+
 ASTPtr Parser::ParseFunDef() {
   // get function name
   if (!ExpectId()) return nullptr;
-  auto name = lexer_.id_val();
+  auto name = tokens_.id_val(pos_);
   NextToken();
   // check & eat '('
   if (!ExpectChar('(')) return nullptr;
   // get formal arguments
-  IdList args;
+  auto base = ids_.size();
   if (!IsTokenChar(')')) {
     for (;;) {
       // get name of the current argument
       if (!ExpectId()) return nullptr;
-      args.push_back(lexer_.id_val());
+      ids_.push_back(tokens_.id_val(pos_));
       NextToken();
       // eat ','
       if (!IsTokenChar(',')) break;
@@ -31,36 +45,38 @@ ASTPtr Parser::ParseFunDef() {
   }
   // check & eat ')'
   if (!ExpectChar(')')) return nullptr;
+  auto args = PopIds(base);
   // get function body
   auto body = ParseBlock();
   if (!body) return nullptr;
-  return std::make_unique<FunDefAST>(name, std::move(args),
-                                     std::move(body));
+  return arena_.New<FunDefAST>(name, args, body);
 }
 
 ASTPtr Parser::ParseBlock() {
   // check & eat '{'
   if (!ExpectChar('{')) return nullptr;
+  if (!EnterNesting()) return nullptr;
   // get statements
-  ASTPtrList stmts;
+  auto base = asts_.size();
   while (!IsTokenChar('}')) {
     auto stmt = ParseStatement();
     if (!stmt) return nullptr;
-    stmts.push_back(std::move(stmt));
+    asts_.push_back(stmt);
   }
   // eat '}'
   NextToken();
-  return std::make_unique<BlockAST>(std::move(stmts));
+  --depth_;
+  return arena_.New<BlockAST>(PopASTs(base));
 }
 
 ASTPtr Parser::ParseStatement() {
   switch (cur_token_) {
     case Token::Id: return ParseDefineAssign();
     case Token::Keyword: {
-      if (lexer_.key_val() == Keyword::If) {
+      if (tokens_.key_val(pos_) == Keyword::If) {
         return ParseIfElse();
       }
-      else if (lexer_.key_val() == Keyword::Return) {
+      else if (tokens_.key_val(pos_) == Keyword::Return) {
         return ParseReturn();
       }
       // fallthrough
@@ -71,43 +87,60 @@ ASTPtr Parser::ParseStatement() {
 }
 
 ASTPtr Parser::ParseDefineAssign() {
+  // check if is a function call
+  if (IsNextChar('(')) return ParseFunCall();
   // get name of variable
-  auto name = lexer_.id_val();
+  auto name = tokens_.id_val(pos_);
   NextToken();
-  // check if is a function call
-  if (IsTokenChar('(')) return ParseFunCall();
   // check if is define/assign
   if (!IsTokenOp(Operator::Define) && !IsTokenOp(Operator::Assign)) {
     return LogError("expected ':=' or '='");
   }
-  bool is_define = lexer_.op_val() == Operator::Define;
+  bool is_define = tokens_.op_val(pos_) == Operator::Define;
   NextToken();
   // get expression
   auto expr = ParseExpr();
   if (!expr) return nullptr;
-  if (is_define) return std::make_unique<DefineAST>(name, std::move(expr));
-  return std::make_unique<AssignAST>(name, std::move(expr));
+  if (is_define) return arena_.New<DefineAST>(name, expr);
+  return arena_.New<AssignAST>(name, expr);
 }
 
 ASTPtr Parser::ParseIfElse() {
-  // eat 'if'
-  NextToken();
-  // get condition
-  auto cond = ParseExpr();
-  if (!cond) return nullptr;
-  // get 'then' body
-  auto then = ParseBlock();
-  if (!then) return nullptr;
-  // get 'else-then' body
-  ASTPtr else_then;
-  if (IsTokenKey(Keyword::Else)) {
-    // eat 'else'
+  // parse all branches of the 'else if' chain iteratively
+  auto base = asts_.size();
+  ASTPtr else_then = nullptr;
+  for (;;) {
+    // eat 'if'
     NextToken();
-    else_then = IsTokenKey(Keyword::If) ? ParseIfElse() : ParseBlock();
-    if (!else_then) return nullptr;
+    // get condition
+    auto cond = ParseExpr();
+    if (!cond) return nullptr;
+    // get 'then' body
+    auto then = ParseBlock();
+    if (!then) return nullptr;
+    asts_.push_back(cond);
+    asts_.push_back(then);
+    // check & eat 'else'
+    if (!IsTokenKey(Keyword::Else)) break;
+    NextToken();
+    // get 'else-then' body
+    if (!IsTokenKey(Keyword::If)) {
+      else_then = ParseBlock();
+      if (!else_then) return nullptr;
+      break;
+    }
   }
-  return std::make_unique<IfAST>(std::move(cond), std::move(then),
-                                 std::move(else_then));
+  // build the chain from the last branch
+  IfAST *if_else = nullptr;
+  while (asts_.size() > base) {
+    auto then = asts_.back();
+    asts_.pop_back();
+    auto cond = asts_.back();
+    asts_.pop_back();
+    if_else = arena_.New<IfAST>(cond, then, if_else ? nullptr : else_then,
+                                if_else);
+  }
+  return if_else;
 }
 
 ASTPtr Parser::ParseReturn() {
@@ -116,41 +149,17 @@ ASTPtr Parser::ParseReturn() {
   // get return value
   auto expr = ParseExpr();
   if (!expr) return nullptr;
-  return std::make_unique<ReturnAST>(std::move(expr));
+  return arena_.New<ReturnAST>(expr);
 }
 
 ASTPtr Parser::ParseExpr() {
-  return ParseBinary([this] { return ParseLAndExpr(); }, {Operator::LOr});
-}
-
-ASTPtr Parser::ParseLAndExpr() {
-  return ParseBinary([this] { return ParseEqExpr(); }, {Operator::LAnd});
-}
-
-ASTPtr Parser::ParseEqExpr() {
-  return ParseBinary([this] { return ParseRelExpr(); },
-                     {Operator::Eq, Operator::NotEq});
-}
-
-ASTPtr Parser::ParseRelExpr() {
-  return ParseBinary([this] { return ParseAddExpr(); },
-                     {Operator::Less, Operator::LessEq});
-}
-
-ASTPtr Parser::ParseAddExpr() {
-  return ParseBinary([this] { return ParseMulExpr(); },
-                     {Operator::Add, Operator::Sub});
-}
-
-ASTPtr Parser::ParseMulExpr() {
-  return ParseBinary([this] { return ParseUnaryExpr(); },
-                     {Operator::Mul, Operator::Div, Operator::Mod});
+  return ParseBinary(1);
 }
 
 ASTPtr Parser::ParseUnaryExpr() {
   if (cur_token_ == Token::Operator) {
     // get operator
-    auto op = lexer_.op_val();
+    auto op = tokens_.op_val(pos_);
     NextToken();
     // check if is a valid operator
     switch (op) {
@@ -160,7 +169,7 @@ ASTPtr Parser::ParseUnaryExpr() {
     // get operand
     auto opr = ParseValue();
     if (!opr) return nullptr;
-    return std::make_unique<UnaryAST>(op, std::move(opr));
+    return arena_.New<UnaryAST>(op, opr);
   }
   else {
     return ParseValue();
@@ -171,27 +180,29 @@ ASTPtr Parser::ParseValue() {
   switch (cur_token_) {
     case Token::Integer: {
       // get integer literal
-      auto val = lexer_.int_val();
+      auto val = tokens_.int_val(pos_);
       NextToken();
-      return std::make_unique<IntAST>(val);
+      return arena_.New<IntAST>(val);
     }
     case Token::Id: {
+      // check if the next token is '('
+      if (IsNextChar('(')) return ParseFunCall();
       // get identifier
-      auto id = lexer_.id_val();
+      auto id = tokens_.id_val(pos_);
       NextToken();
-      // check if the current token is '('
-      return IsTokenChar('(') ? ParseFunCall()
-                              : std::make_unique<IdAST>(id);
+      return arena_.New<IdAST>(id);
     }
     case Token::Other: {
-      if (lexer_.other_val() == '(') {
+      if (tokens_.other_val(pos_) == '(') {
         // eat '('
         NextToken();
+        if (!EnterNesting()) return nullptr;
         // get expression
         auto expr = ParseExpr();
         if (!expr) return nullptr;
         // check & eat ')'
         ExpectChar(')');
+        --depth_;
         return expr;
       }
       // fallthrough
@@ -203,17 +214,19 @@ ASTPtr Parser::ParseValue() {
 
 ASTPtr Parser::ParseFunCall() {
   // get function name
-  auto name = lexer_.id_val();
+  auto name = tokens_.id_val(pos_);
+  NextToken();
   // eat '('
   NextToken();
+  if (!EnterNesting()) return nullptr;
   // get arguments
-  ASTPtrList args;
+  auto base = asts_.size();
   if (!IsTokenChar(')')) {
     for (;;) {
       // get the current argument
       auto expr = ParseExpr();
       if (!expr) return nullptr;
-      args.push_back(std::move(expr));
+      asts_.push_back(expr);
       // eat ','
       if (!IsTokenChar(',')) break;
       NextToken();
@@ -221,29 +234,57 @@ ASTPtr Parser::ParseFunCall() {
   }
   // check & eat ')'
   if (!ExpectChar(')')) return nullptr;
-  return std::make_unique<FunCallAST>(name, std::move(args));
+  --depth_;
+  return arena_.New<FunCallAST>(name, PopASTs(base));
 }
 
-ASTPtr Parser::ParseBinary(std::function<ASTPtr()> parser,
-                           std::initializer_list<Operator> ops) {
+ASTPtr Parser::ParseBinary(int min_prec) {
   // get left-hand side expression
-  auto lhs = parser();
+  auto lhs = ParseUnaryExpr();
   if (!lhs) return nullptr;
   // get the rest things
-  while (cur_token_ == Token::Operator &&
-         std::find(ops.begin(), ops.end(), lexer_.op_val()) != ops.end()) {
-    // get operator
-    auto op = lexer_.op_val();
+  std::size_t chain_len = 0;
+  while (cur_token_ == Token::Operator) {
+    // get operator, stop if its precedence is too low
+    auto op = tokens_.op_val(pos_);
+    auto prec = kPrecedence[static_cast<int>(op)];
+    if (prec < min_prec) break;
+    // every operator of the chain makes the left-deep tree one level
+    // deeper, which is as deep as a level of nesting for AST walkers
+    if (!EnterNesting()) return nullptr;
+    ++chain_len;
     NextToken();
-    // get right-hand side expression
-    auto rhs = parser();
+    // get right-hand side expression, which binds tighter than 'op'
+    // since all binary operators are left-associative
+    auto rhs = ParseBinary(prec + 1);
     if (!rhs) return nullptr;
     // update lhs
-    lhs = std::make_unique<BinaryAST>(op, std::move(lhs), std::move(rhs));
+    lhs = arena_.New<BinaryAST>(op, lhs, rhs);
   }
+  depth_ -= chain_len;
   return lhs;
 }
 
+bool Parser::EnterNesting() {
+  if (++depth_ > max_depth_) {
+    LogError("nesting is too deep");
+    return false;
+  }
+  return true;
+}
+
+ASTPtrList Parser::PopASTs(std::size_t base) {
+  auto list = arena_.NewList(asts_.data() + base, asts_.size() - base);
+  asts_.resize(base);
+  return list;
+}
+
+IdList Parser::PopIds(std::size_t base) {
+  auto list = arena_.NewList(ids_.data() + base, ids_.size() - base);
+  ids_.resize(base);
+  return list;
+}
+
 bool Parser::ExpectId() {
   if (cur_token_ != Token::Id) {
     LogError("expected identifier");
@@ -1,47 +1,93 @@
 #ifndef FIRSTSTEP_FRONT_PARSER_H_
 #define FIRSTSTEP_FRONT_PARSER_H_
 
+#include <iostream>
 #include <string_view>
-#include <functional>
-#include <initializer_list>
+#include <vector>
+#include <algorithm>
 #include <cstddef>
 
-#include "front/lexer.h"
+#include "front/tokens.h"
 #include "define/ast.h"
+#include "define/error.h"
 #include "define/token.h"
+#include "define/symbol.h"
+#include "define/arena.h"
 
 class Parser {
  public:
-  Parser(Lexer &lexer) : lexer_(lexer) {
+  // default value of the max nesting depth
+  static constexpr std::size_t kDefaultMaxDepth = 1000;
+  // upper bound of the max nesting depth, ASTs within it can be walked
+  // recursively by the parser, the resolver and code generators on
+  // a native stack of 8 MiB
+  static constexpr std::size_t kMaxDepthLimit = 10000;
+
+  // parse tokens in the specific complete token buffer
+  // all ASTs are allocated in the specific arena
+  Parser(const TokenBuffer &tokens, Arena &arena)
+      : tokens_(tokens), arena_(arena), pos_(0) {
     error_num_ = 0;
-    NextToken();
+    max_depth_ = kDefaultMaxDepth;
+    LoadToken();
   }
 
   // parse next symbol
   ASTPtr ParseNext() {
-    return cur_token_ == Token::End ? nullptr : ParseFunDef();
+    if (cur_token_ == Token::End) return nullptr;
+    // clear states that left by the last error
+    depth_ = 0;
+    asts_.clear();
+    ids_.clear();
+    return ParseFunDef();
+  }
+
+  // set the max nesting depth, every block, parenthesis, argument list
+  // and operator of a chain of binary operators counts as a level,
+  // which bounds the depth of ASTs, deeper nesting is reported as
+  // an error, instead of overflowing the native stack of parser and
+  // all AST walkers, values above 'kMaxDepthLimit' are clamped
+  void set_max_depth(std::size_t max_depth) {
+    max_depth_ = std::min(max_depth, kMaxDepthLimit);
+  }
+  // set the stream for printing error messages
+  void set_err_stream(std::ostream &err) { reporter_.set_err_stream(err); }
+  // set the list for collecting errors, with offsets of tokens
+  void set_error_list(ErrorList &errors) {
+    reporter_.set_error_list(errors);
   }
 
-  // count of error
+  // count of error, including errors of lexer
   std::size_t error_num() const { return error_num_; }
 
  private:
-  Token NextToken() { return cur_token_ = lexer_.NextToken(); }
+  Token NextToken() {
+    if (cur_token_ != Token::End) ++pos_;
+    return LoadToken();
+  }
   // check if the current token is the specific character
   bool IsTokenChar(char c) const {
-    return cur_token_ == Token::Other && lexer_.other_val() == c;
+    return cur_token_ == Token::Other && tokens_.other_val(pos_) == c;
   }
   // check if the current token is the specific keyword
   bool IsTokenKey(Keyword key) const {
-    return cur_token_ == Token::Keyword && lexer_.key_val() == key;
+    return cur_token_ == Token::Keyword && tokens_.key_val(pos_) == key;
   }
   // check if the current token is the specific operator
   bool IsTokenOp(Operator op) const {
-    return cur_token_ == Token::Operator && lexer_.op_val() == op;
+    return cur_token_ == Token::Operator && tokens_.op_val(pos_) == op;
+  }
+  // check if the next token is the specific character
+  bool IsNextChar(char c) const {
+    auto next = pos_ + 1;
+    return next < tokens_.size() && tokens_.kind(next) == Token::Other &&
+           tokens_.other_val(next) == c;
   }
 
-  // print error message to stderr
+  // report error at the current token
   ASTPtr LogError(std::string_view message);
+  // load the current token, print error message of error tokens
+  Token LoadToken();
 
   ASTPtr ParseFunDef();
   ASTPtr ParseBlock();
@@ -50,26 +96,36 @@ class Parser {
   ASTPtr ParseIfElse();
   ASTPtr ParseReturn();
   ASTPtr ParseExpr();
-  ASTPtr ParseLAndExpr();
-  ASTPtr ParseEqExpr();
-  ASTPtr ParseRelExpr();
-  ASTPtr ParseAddExpr();
-  ASTPtr ParseMulExpr();
   ASTPtr ParseUnaryExpr();
   ASTPtr ParseValue();
   ASTPtr ParseFunCall();
 
-  // parse binary expression
-  ASTPtr ParseBinary(std::function<ASTPtr()> parser,
-                     std::initializer_list<Operator> ops);
+  // parse binary expression whose operators have precedence
+  // greater than or equal to the specific precedence
+  ASTPtr ParseBinary(int min_prec);
+  // increase the nesting depth, returns false if the depth is too deep
+  bool EnterNesting();
+  // move ASTs on stack since the specific position to arena
+  ASTPtrList PopASTs(std::size_t base);
+  // move identifiers on stack since the specific position to arena
+  IdList PopIds(std::size_t base);
   // make sure current token is identifier
   bool ExpectId();
   // make sure current token is specific character and goto next token
   bool ExpectChar(char c);
 
-  Lexer &lexer_;
+  const TokenBuffer &tokens_;
+  Arena &arena_;
+  // position of the current token
+  std::size_t pos_;
   std::size_t error_num_;
+  ErrorReporter reporter_;
   Token cur_token_;
+  // current & max nesting depth
+  std::size_t depth_, max_depth_;
+  // stacks for building lists of ASTs and identifiers
+  std::vector<ASTPtr> asts_;
+  std::vector<SymbolId> ids_;
 };
 
 #endif  // FIRSTSTEP_FRONT_PARSER_H_
@@ -0,0 +1,182 @@
+#include "front/scan.h"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define FIRSTSTEP_SCAN_X86
+#include <immintrin.h>
+#endif
+
+namespace {
+
+/*
+  scalar implementation
+*/
+
+inline bool IsSpace(char c) {
+  return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+inline bool IsNotLineEnd(char c) { return c != '\n' && c != '\r'; }
+
+inline bool IsIdChar(char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+         (c >= '0' && c <= '9') || c == '_';
+}
+
+inline bool IsDigit(char c) { return c >= '0' && c <= '9'; }
+
+template <bool (*Pred)(char)>
+const char *SkipScalar(const char *pos, const char *end) {
+  while (pos != end && Pred(*pos)) ++pos;
+  return pos;
+}
+
+const ScanFuncs kScalarFuncs = {
+    SkipScalar<IsSpace>, SkipScalar<IsNotLineEnd>,
+    SkipScalar<IsIdChar>, SkipScalar<IsDigit>,
+};
+
+#ifdef FIRSTSTEP_SCAN_X86
+
+/*
+  SSE2 implementation, 16 bytes at a time
+  every 'Match' function returns a byte mask of the matched characters
+*/
+
+// check if every byte of 'v' is in range [lo, lo + len] (unsigned)
+inline __m128i InRange16(__m128i v, char lo, char len) {
+  auto t = _mm_sub_epi8(v, _mm_set1_epi8(lo));
+  return _mm_cmpeq_epi8(_mm_min_epu8(t, _mm_set1_epi8(len)), t);
+}
+
+inline __m128i MatchSpace16(__m128i v) {
+  return _mm_or_si128(InRange16(v, '\t', '\r' - '\t'),
+                      _mm_cmpeq_epi8(v, _mm_set1_epi8(' ')));
+}
+
+inline __m128i MatchLineEnd16(__m128i v) {
+  return _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')),
+                      _mm_cmpeq_epi8(v, _mm_set1_epi8('\r')));
+}
+
+inline __m128i MatchIdChar16(__m128i v) {
+  // convert upper case letters to lower case ones
+  auto lower = _mm_or_si128(v, _mm_set1_epi8(0x20));
+  auto alpha = InRange16(lower, 'a', 'z' - 'a');
+  auto digit = InRange16(v, '0', '9' - '0');
+  auto under = _mm_cmpeq_epi8(v, _mm_set1_epi8('_'));
+  return _mm_or_si128(_mm_or_si128(alpha, digit), under);
+}
+
+inline __m128i MatchDigit16(__m128i v) {
+  return InRange16(v, '0', '9' - '0');
+}
+
+// skip while the predicate 'Match' equals to 'kSkipMatch'
+template <__m128i (*Match)(__m128i), bool kSkipMatch, bool (*Pred)(char)>
+const char *SkipSSE2(const char *pos, const char *end) {
+  while (end - pos >= 16) {
+    auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pos));
+    unsigned mask = _mm_movemask_epi8(Match(v));
+    // get mask of the bytes that stop the run
+    if (kSkipMatch) mask ^= 0xffff;
+    if (mask) return pos + __builtin_ctz(mask);
+    pos += 16;
+  }
+  return SkipScalar<Pred>(pos, end);
+}
+
+const ScanFuncs kSSE2Funcs = {
+    SkipSSE2<MatchSpace16, true, IsSpace>,
+    SkipSSE2<MatchLineEnd16, false, IsNotLineEnd>,
+    SkipSSE2<MatchIdChar16, true, IsIdChar>,
+    SkipSSE2<MatchDigit16, true, IsDigit>,
+};
+
+/*
+  AVX2 implementation, 32 bytes at a time
+*/
+
+#define FIRSTSTEP_AVX2 __attribute__((target("avx2")))
+
+FIRSTSTEP_AVX2 inline __m256i InRange32(__m256i v, char lo, char len) {
+  auto t = _mm256_sub_epi8(v, _mm256_set1_epi8(lo));
+  return _mm256_cmpeq_epi8(_mm256_min_epu8(t, _mm256_set1_epi8(len)), t);
+}
+
+FIRSTSTEP_AVX2 inline __m256i MatchSpace32(__m256i v) {
+  return _mm256_or_si256(InRange32(v, '\t', '\r' - '\t'),
+                         _mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')));
+}
+
+FIRSTSTEP_AVX2 inline __m256i MatchLineEnd32(__m256i v) {
+  return _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')),
+                         _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r')));
+}
+
+FIRSTSTEP_AVX2 inline __m256i MatchIdChar32(__m256i v) {
+  auto lower = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+  auto alpha = InRange32(lower, 'a', 'z' - 'a');
+  auto digit = InRange32(v, '0', '9' - '0');
+  auto under = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('_'));
+  return _mm256_or_si256(_mm256_or_si256(alpha, digit), under);
+}
+
+FIRSTSTEP_AVX2 inline __m256i MatchDigit32(__m256i v) {
+  return InRange32(v, '0', '9' - '0');
+}
+
+template <__m256i (*Match)(__m256i), __m128i (*Match16)(__m128i),
+          bool kSkipMatch, bool (*Pred)(char)>
+FIRSTSTEP_AVX2 const char *SkipAVX2(const char *pos, const char *end) {
+  while (end - pos >= 32) {
+    auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(pos));
+    unsigned mask = _mm256_movemask_epi8(Match(v));
+    if (kSkipMatch) mask = ~mask;
+    if (mask) return pos + __builtin_ctz(mask);
+    pos += 32;
+  }
+  return SkipSSE2<Match16, kSkipMatch, Pred>(pos, end);
+}
+
+const ScanFuncs kAVX2Funcs = {
+    SkipAVX2<MatchSpace32, MatchSpace16, true, IsSpace>,
+    SkipAVX2<MatchLineEnd32, MatchLineEnd16, false, IsNotLineEnd>,
+    SkipAVX2<MatchIdChar32, MatchIdChar16, true, IsIdChar>,
+    SkipAVX2<MatchDigit32, MatchDigit16, true, IsDigit>,
+};
+
+#endif  // FIRSTSTEP_SCAN_X86
+
+}  // namespace
+
+ScanISA GetBestScanISA() {
+#ifdef FIRSTSTEP_SCAN_X86
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2") ? ScanISA::AVX2 : ScanISA::SSE2;
+#else
+  return ScanISA::Scalar;
+#endif
+}
+
+const char *GetScanISAName(ScanISA isa) {
+  switch (isa) {
+    case ScanISA::SSE2: return "sse2";
+    case ScanISA::AVX2: return "avx2";
+    default: return "scalar";
+  }
+}
+
+const ScanFuncs &GetScanFuncs(ScanISA isa) {
+  switch (isa) {
+#ifdef FIRSTSTEP_SCAN_X86
+    case ScanISA::SSE2: return kSSE2Funcs;
+    case ScanISA::AVX2: return kAVX2Funcs;
+#endif
+    default: return kScalarFuncs;
+  }
+}
+
+const ScanFuncs &GetScanFuncs() {
+  static const ScanFuncs &funcs = GetScanFuncs(GetBestScanISA());
+  return funcs;
+}
@@ -0,0 +1,33 @@
+#ifndef FIRSTSTEP_FRONT_SCAN_H_
+#define FIRSTSTEP_FRONT_SCAN_H_
+
+// scanning of character runs for the lexer, vectorized if possible
+// every function returns the first position in range [pos, end)
+// that does not belong to the run, or 'end' if there is no such position
+
+// instruction set extensions of the scanning functions
+enum class ScanISA { Scalar, SSE2, AVX2 };
+
+// function table of scanning functions
+struct ScanFuncs {
+  // skip spaces (' ', '\t', '\n', '\v', '\f' and '\r')
+  const char *(*skip_spaces)(const char *pos, const char *end);
+  // skip the rest of the current line (until '\n' or '\r')
+  const char *(*skip_line)(const char *pos, const char *end);
+  // skip identifier characters ([A-Za-z0-9_])
+  const char *(*skip_id)(const char *pos, const char *end);
+  // skip digits ([0-9])
+  const char *(*skip_digits)(const char *pos, const char *end);
+};
+
+// get the best instruction set extension supported by the current CPU
+ScanISA GetBestScanISA();
+// get name of the specific instruction set extension
+const char *GetScanISAName(ScanISA isa);
+// get scanning functions of the specific instruction set extension
+// the extension must be supported by the current CPU
+const ScanFuncs &GetScanFuncs(ScanISA isa);
+// get scanning functions of the best instruction set extension
+const ScanFuncs &GetScanFuncs();
+
+#endif  // FIRSTSTEP_FRONT_SCAN_H_
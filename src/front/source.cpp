@@ -0,0 +1,92 @@
+#include "front/source.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define FIRSTSTEP_USE_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <fstream>
+#include <iostream>
+#endif
+
+#include <cstring>
+
+namespace {
+
+// size of block when reading files which can not be mapped
+constexpr std::size_t kBlockSize = 1 << 20;
+
+}  // namespace
+
+SourceBuffer::SourceBuffer(const char *path)
+    : is_open_(false), is_mapped_(false), data_(nullptr), size_(0) {
+  // stdin can not be mapped
+  if (!std::strcmp(path, "-")) {
+    is_open_ = ReadBlocks(nullptr);
+    data_ = buffer_.data();
+    size_ = buffer_.size();
+    return;
+  }
+#ifdef FIRSTSTEP_USE_MMAP
+  // try to map regular files
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) return;
+  struct stat st;
+  if (!fstat(fd, &st) && S_ISREG(st.st_mode) && st.st_size > 0) {
+    auto addr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr != MAP_FAILED) {
+      madvise(addr, st.st_size, MADV_SEQUENTIAL);
+      close(fd);
+      is_open_ = is_mapped_ = true;
+      data_ = static_cast<const char *>(addr);
+      size_ = st.st_size;
+      return;
+    }
+  }
+  close(fd);
+#endif
+  // fallback to block-buffered reading
+  is_open_ = ReadBlocks(path);
+  data_ = buffer_.data();
+  size_ = buffer_.size();
+}
+
+SourceBuffer::~SourceBuffer() {
+#ifdef FIRSTSTEP_USE_MMAP
+  if (is_mapped_) munmap(const_cast<char *>(data_), size_);
+#endif
+}
+
+bool SourceBuffer::ReadBlocks(const char *path) {
+#ifdef FIRSTSTEP_USE_MMAP
+  int fd = path ? open(path, O_RDONLY) : STDIN_FILENO;
+  if (fd < 0) return false;
+  for (;;) {
+    auto len = buffer_.size();
+    buffer_.resize(len + kBlockSize);
+    auto ret = read(fd, buffer_.data() + len, kBlockSize);
+    if (ret <= 0) {
+      buffer_.resize(len);
+      if (path) close(fd);
+      return !ret;
+    }
+    buffer_.resize(len + ret);
+  }
+#else
+  std::ifstream file;
+  if (path) {
+    file.open(path, std::ios::binary);
+    if (!file) return false;
+  }
+  auto &ifs = path ? static_cast<std::istream &>(file) : std::cin;
+  while (ifs) {
+    auto len = buffer_.size();
+    buffer_.resize(len + kBlockSize);
+    ifs.read(buffer_.data() + len, kBlockSize);
+    buffer_.resize(len + ifs.gcount());
+  }
+  return ifs.eof();
+#endif
+}
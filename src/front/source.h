@@ -0,0 +1,38 @@
+#ifndef FIRSTSTEP_FRONT_SOURCE_H_
+#define FIRSTSTEP_FRONT_SOURCE_H_
+
+#include <string>
+#include <string_view>
+#include <cstddef>
+
+// contiguous in-memory buffer of a source file
+// regular files are memory-mapped, other files (pipes, terminals, ...)
+// are read in large blocks
+class SourceBuffer {
+ public:
+  // path '-' reads all of stdin
+  SourceBuffer(const char *path);
+  ~SourceBuffer();
+
+  SourceBuffer(const SourceBuffer &) = delete;
+  SourceBuffer &operator=(const SourceBuffer &) = delete;
+
+  // check if the file has been opened successfully
+  bool is_open() const { return is_open_; }
+  // contents of the file
+  std::string_view data() const { return {data_, size_}; }
+  std::size_t size() const { return size_; }
+
+ private:
+  // read the whole file in blocks, or stdin if 'path' is null
+  // returns false if failed
+  bool ReadBlocks(const char *path);
+
+  bool is_open_, is_mapped_;
+  const char *data_;
+  std::size_t size_;
+  // storage of file contents when the file is not mapped
+  std::string buffer_;
+};
+
+#endif  // FIRSTSTEP_FRONT_SOURCE_H_
@@ -0,0 +1,69 @@
+#ifndef FIRSTSTEP_FRONT_TOKENS_H_
+#define FIRSTSTEP_FRONT_TOKENS_H_
+
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "define/token.h"
+#include "define/symbol.h"
+
+// compact buffer of all tokens of a source file, in struct-of-arrays
+// layout: kind, 32-bit payload and source offset of every token
+// the last token in a complete buffer is always 'Token::End'
+class TokenBuffer {
+ public:
+  // add a token, the payload is the value of the token
+  void Add(Token kind, std::uint32_t payload, std::size_t offset) {
+    kinds_.push_back(kind);
+    payloads_.push_back(payload);
+    offsets_.push_back(static_cast<std::uint32_t>(offset));
+  }
+  // add an error token with the specific message
+  // the message must outlive the buffer (e.g. a string literal)
+  void AddError(std::string_view message, std::size_t offset) {
+    Add(Token::Error, errors_.size(), offset);
+    errors_.push_back(message);
+  }
+
+  // reserve space for the specific count of tokens
+  void Reserve(std::size_t size) {
+    kinds_.reserve(size);
+    payloads_.reserve(size);
+    offsets_.reserve(size);
+  }
+
+  // count of tokens
+  std::size_t size() const { return kinds_.size(); }
+  // size of the buffer in bytes
+  std::size_t bytes() const {
+    return size() * (sizeof(Token) + sizeof(std::uint32_t) * 2);
+  }
+
+  // kind of the specific token
+  Token kind(std::size_t i) const { return kinds_[i]; }
+  // offset of the specific token in source
+  std::uint32_t offset(std::size_t i) const { return offsets_[i]; }
+  // values of the specific token
+  SymbolId id_val(std::size_t i) const { return payloads_[i]; }
+  int int_val(std::size_t i) const { return payloads_[i]; }
+  Keyword key_val(std::size_t i) const {
+    return static_cast<Keyword>(payloads_[i]);
+  }
+  Operator op_val(std::size_t i) const {
+    return static_cast<Operator>(payloads_[i]);
+  }
+  char other_val(std::size_t i) const { return payloads_[i]; }
+  std::string_view error_val(std::size_t i) const {
+    return errors_[payloads_[i]];
+  }
+
+ private:
+  std::vector<Token> kinds_;
+  std::vector<std::uint32_t> payloads_, offsets_;
+  // messages of error tokens
+  std::vector<std::string_view> errors_;
+};
+
+#endif  // FIRSTSTEP_FRONT_TOKENS_H_
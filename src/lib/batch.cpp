@@ -0,0 +1,132 @@
+#include "lib/batch.h"
+
+#include <thread>
+#include <chrono>
+#include <string_view>
+#include <algorithm>
+
+#include "lib/program.h"
+
+BatchEvaluator::BatchEvaluator(const Program &prog,
+                               const EvalOptions &opts,
+                               std::size_t worker_num) {
+  if (!worker_num) worker_num = 1;
+  for (std::size_t i = 0; i < worker_num; ++i) {
+    workers_.push_back(std::make_unique<Worker>(prog, opts));
+    // lanes require variables to be stored in frames
+    if (opts.engine == EvalEngine::Lanes && prog.impl_->use_frames) {
+      auto &lanes = workers_.back()->lanes;
+      lanes.emplace(prog.impl_->funcs);
+      lanes->set_max_depth(opts.max_depth);
+    }
+  }
+}
+
+void BatchEvaluator::Eval(const std::vector<std::string> &records,
+                          std::vector<BatchResult> &results) {
+  results.clear();
+  results.resize(records.size());
+  // split records evenly
+  auto num = workers_.size();
+  for (std::size_t i = 0; i < num; ++i) {
+    workers_[i]->begin = records.size() * i / num;
+    workers_[i]->end = records.size() * (i + 1) / num;
+  }
+  // the current thread runs the first worker
+  std::vector<std::thread> threads;
+  for (std::size_t i = 1; i < num; ++i) {
+    threads.emplace_back([this, i, &records, &results] {
+      Run(i, records, results);
+    });
+  }
+  Run(0, records, results);
+  for (auto &thread : threads) thread.join();
+}
+
+void BatchEvaluator::Run(std::size_t id,
+                         const std::vector<std::string> &records,
+                         std::vector<BatchResult> &results) {
+  auto &worker = *workers_[id];
+  do {
+    std::size_t index, num;
+    while (Pop(worker, index, num)) {
+      auto begin = std::chrono::steady_clock::now();
+      if (num > 1) {
+        EvalLanes(worker, records, results, index, num);
+      }
+      else {
+        results[index].result = worker.eval.Eval(records[index]);
+      }
+      std::chrono::nanoseconds nanos =
+          std::chrono::steady_clock::now() - begin;
+      for (std::size_t i = 0; i < num; ++i) {
+        results[index + i].nanos = nanos.count();
+      }
+    }
+  } while (Steal(id));
+}
+
+bool BatchEvaluator::Pop(Worker &worker, std::size_t &index,
+                         std::size_t &num) {
+  std::lock_guard<std::mutex> lock(worker.mutex);
+  if (worker.begin == worker.end) return false;
+  index = worker.begin;
+  num = std::min(worker.end - worker.begin, worker.lanes ? kLaneNum : 1);
+  worker.begin += num;
+  return true;
+}
+
+void BatchEvaluator::EvalLanes(Worker &worker,
+                               const std::vector<std::string> &records,
+                               std::vector<BatchResult> &results,
+                               std::size_t index, std::size_t num) {
+  std::string_view inputs[kLaneNum];
+  int rets[kLaneNum];
+  std::string outputs[kLaneNum];
+  for (std::size_t i = 0; i < num; ++i) inputs[i] = records[index + i];
+  auto failed = worker.lanes->Eval(inputs, num, rets, outputs);
+  for (std::size_t i = 0; i < num; ++i) {
+    auto &res = results[index + i].result;
+    if (failed & (1u << i)) {
+      // evaluate again to get diagnostics
+      res = worker.eval.Eval(records[index + i]);
+    }
+    else {
+      res.ret = rets[i];
+      res.output = std::move(outputs[i]);
+    }
+  }
+}
+
+bool BatchEvaluator::Steal(std::size_t id) {
+  auto &thief = *workers_[id];
+  // ranges never grow, retry until all ranges are empty
+  for (;;) {
+    // find the victim with the largest range
+    Worker *victim = nullptr;
+    std::size_t max_size = 0;
+    for (std::size_t i = 1; i < workers_.size(); ++i) {
+      auto &worker = *workers_[(id + i) % workers_.size()];
+      std::lock_guard<std::mutex> lock(worker.mutex);
+      if (worker.end - worker.begin > max_size) {
+        victim = &worker;
+        max_size = worker.end - worker.begin;
+      }
+    }
+    if (!victim) return false;
+    // take the back half, rounded up
+    std::size_t begin, end;
+    {
+      std::lock_guard<std::mutex> lock(victim->mutex);
+      auto size = victim->end - victim->begin;
+      if (!size) continue;
+      end = victim->end;
+      begin = end - (size + 1) / 2;
+      victim->end = begin;
+    }
+    std::lock_guard<std::mutex> lock(thief.mutex);
+    thief.begin = begin;
+    thief.end = end;
+    return true;
+  }
+}
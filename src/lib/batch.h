@@ -0,0 +1,72 @@
+#ifndef FIRSTSTEP_LIB_BATCH_H_
+#define FIRSTSTEP_LIB_BATCH_H_
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <cstdint>
+#include <cstddef>
+
+#include "fstep/fstep.h"
+#include "back/lanes/lanes.h"
+
+// result of evaluating a record in batch
+struct BatchResult {
+  EvalResult result;
+  // time of evaluation in nanoseconds
+  std::uint64_t nanos;
+};
+
+// evaluates a program against many input records on a pool of threads
+// every worker owns an evaluator, which is kept between batches
+// records of a batch are split into contiguous ranges, one per worker,
+// idle workers steal the back half of the largest range left
+// with lanes, workers take up to 'kLaneNum' records at a time and
+// evaluate them in lockstep, failed records are evaluated again by
+// the evaluator, the time of every record is the time of its group
+class BatchEvaluator {
+ public:
+  // the program must outlive the evaluator
+  BatchEvaluator(const Program &prog, const EvalOptions &opts,
+                 std::size_t worker_num);
+
+  // evaluate all records, results are stored in the order of records
+  void Eval(const std::vector<std::string> &records,
+            std::vector<BatchResult> &results);
+
+  // count of workers
+  std::size_t worker_num() const { return workers_.size(); }
+
+ private:
+  // worker, aligned to cache line to avoid false sharing
+  struct alignas(64) Worker {
+    Worker(const Program &prog, const EvalOptions &opts)
+        : eval(prog, opts), begin(0), end(0) {}
+
+    Evaluator eval;
+    // lane interpreter, 'nullopt' if lanes are not used
+    std::optional<LaneInterpreter> lanes;
+    // range of records that have not been evaluated
+    std::mutex mutex;
+    std::size_t begin, end;
+  };
+
+  // run the specific worker until all records have been evaluated
+  void Run(std::size_t id, const std::vector<std::string> &records,
+           std::vector<BatchResult> &results);
+  // take the next records of the specific worker, at most one record
+  // without lanes, returns false if there is no record left
+  bool Pop(Worker &worker, std::size_t &index, std::size_t &num);
+  // evaluate the specific records on lanes
+  void EvalLanes(Worker &worker, const std::vector<std::string> &records,
+                 std::vector<BatchResult> &results, std::size_t index,
+                 std::size_t num);
+  // steal records from other workers, returns false if all is done
+  bool Steal(std::size_t id);
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+};
+
+#endif  // FIRSTSTEP_LIB_BATCH_H_
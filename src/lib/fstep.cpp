@@ -0,0 +1,212 @@
+#include "fstep/fstep.h"
+
+#include <sstream>
+#include <algorithm>
+#include <cassert>
+
+#include "lib/program.h"
+#include "define/error.h"
+#include "front/lexer.h"
+#include "front/parser.h"
+#include "front/tokens.h"
+#include "back/resolver/resolver.h"
+#include "back/compiler/irgen.h"
+#include "back/interpreter/interpreter.h"
+#include "back/interpreter/stack.h"
+#include "back/vm/codegen.h"
+#include "back/vm/vm.h"
+#include "back/runtime/io.h"
+
+// ASTs allowed by parser are evaluated within the reserved stack space
+static_assert(SegmentedStack::kMaxLevels >= Parser::kMaxDepthLimit,
+              "reserved stack space is too small");
+// defaults of the public interface are the same as internal ones
+static_assert(EvalOptions::kDefaultMaxDepth ==
+                  Interpreter::kDefaultMaxDepth &&
+              EvalOptions::kDefaultMaxDepth == VM::kDefaultMaxDepth,
+              "default max depth mismatch");
+static_assert(Program::kDefaultMaxNesting == Parser::kDefaultMaxDepth,
+              "default max nesting mismatch");
+
+namespace {
+
+// convert errors reported by stages to diagnostics, offsets of errors
+// are converted to positions in the specific source
+void AppendDiags(const ErrorList &errors, DiagList &diags,
+                 std::string_view src = {}) {
+  for (const auto &error : errors) {
+    Diagnostic diag = {std::string(error.stage), error.message, 0, 0};
+    if (error.offset != ErrorInfo::kNoOffset &&
+        error.offset <= src.size()) {
+      auto head = src.substr(0, error.offset);
+      auto line_begin = head.rfind('\n');
+      diag.line = std::count(head.begin(), head.end(), '\n') + 1;
+      diag.column = line_begin == std::string_view::npos
+                        ? error.offset + 1
+                        : error.offset - line_begin;
+    }
+    diags.push_back(std::move(diag));
+  }
+}
+
+}  // namespace
+
+Program::Program() : impl_(std::make_unique<Impl>()) {}
+
+Program::~Program() = default;
+
+std::shared_ptr<const Program> Program::Parse(std::string_view src,
+                                              DiagList &diags,
+                                              std::size_t max_depth) {
+  std::shared_ptr<Program> prog(new Program);
+  auto &impl = *prog->impl_;
+  ErrorList errors;
+  // parse all function definitions, redefinitions are checked
+  // by a temporary interpreter
+  TokenBuffer tokens;
+  Lexer lexer(src, impl.symbols);
+  lexer.Tokenize(tokens);
+  Parser parser(tokens, impl.arena);
+  parser.set_max_depth(max_depth);
+  parser.set_error_list(errors);
+  Interpreter intp;
+  intp.set_error_list(errors);
+  while (auto ast = parser.ParseNext()) {
+    if (!intp.AddFunctionDef(ast)) break;
+    impl.funcs.push_back(ast);
+  }
+  AppendDiags(errors, diags, src);
+  if (parser.error_num() || intp.error_num()) return nullptr;
+  // link and resolve all functions once, so that evaluations
+  // never modify the program
+  Resolver resolver;
+  impl.use_frames = resolver.Resolve(impl.funcs);
+  BytecodeGen gen;
+  if (gen.Generate(impl.funcs)) impl.bytecode = gen.bytecode();
+  return prog;
+}
+
+EvalResult Program::Eval(std::string_view input,
+                         const EvalOptions &opts) const {
+  return Evaluator(*this, opts).Eval(input);
+}
+
+bool Program::Compile(std::string &output, DiagList &diags) const {
+  ErrorList errors;
+  IRGenerator gen(impl_->symbols);
+  gen.set_error_list(errors);
+  for (const auto &func : impl_->funcs) {
+    func->GenerateIR(gen);
+    if (gen.error_num()) break;
+  }
+  AppendDiags(errors, diags);
+  if (gen.error_num()) return false;
+  std::ostringstream oss;
+  gen.Dump(oss);
+  output = oss.str();
+  return true;
+}
+
+bool Program::resumable() const { return impl_->bytecode.has_value(); }
+
+// engines, only one of them is initialized
+struct Evaluator::Impl {
+  // errors of one evaluation
+  ErrorList errors;
+  std::optional<VM> vm;
+  std::optional<Interpreter> intp;
+};
+
+Evaluator::Evaluator(const Program &prog, const EvalOptions &opts)
+    : impl_(std::make_unique<Impl>()) {
+  const auto &prog_impl = *prog.impl_;
+  // programs that are not supported by the VM are run by interpreter
+  if (opts.engine == EvalEngine::VM && prog_impl.bytecode) {
+    auto &vm = impl_->vm.emplace(*prog_impl.bytecode);
+    vm.set_max_depth(opts.max_depth);
+    vm.set_error_list(impl_->errors);
+  }
+  else {
+    auto &intp = impl_->intp.emplace();
+    for (const auto &func : prog_impl.funcs) intp.AddFunctionDef(func);
+    intp.set_resolved(prog_impl.use_frames);
+    intp.set_max_depth(opts.max_depth);
+    intp.set_memo_bytes(opts.memo_bytes);
+    intp.set_jit(opts.engine == EvalEngine::JIT);
+    intp.set_fork_workers(opts.fork_workers);
+    intp.set_error_list(impl_->errors);
+  }
+}
+
+Evaluator::~Evaluator() = default;
+
+EvalResult Evaluator::Eval(std::string_view input) {
+  EvalResult result;
+  impl_->errors.clear();
+  {
+    // outputs are flushed to the result when 'io' is destructed
+    RuntimeIO io(input, result.output);
+    if (impl_->vm) {
+      impl_->vm->set_io(io);
+      result.ret = impl_->vm->Run();
+    }
+    else {
+      impl_->intp->set_io(io);
+      result.ret = impl_->intp->Eval();
+    }
+  }
+  AppendDiags(impl_->errors, result.diags);
+  return result;
+}
+
+// the VM and its I/O
+struct Session::Impl {
+  Impl(const Bytecode &bytecode, std::string &output)
+      : io(output), vm(bytecode) {}
+
+  RuntimeIO io;
+  ErrorList errors;
+  VM vm;
+};
+
+Session::Session(const Program &prog, const EvalOptions &opts)
+    : status_(SessionStatus::WaitInput) {
+  assert(prog.resumable() && "program is not supported by VM");
+  impl_ = std::make_unique<Impl>(*prog.impl_->bytecode, output_);
+  auto &vm = impl_->vm;
+  vm.set_max_depth(opts.max_depth);
+  vm.set_io(impl_->io);
+  vm.set_error_list(impl_->errors);
+  vm.Start();
+}
+
+Session::~Session() = default;
+
+void Session::PushInput(std::string_view data) {
+  impl_->io.PushInput(data);
+}
+
+void Session::CloseInput() { impl_->io.CloseInput(); }
+
+SessionStatus Session::Resume() {
+  if (status_ == SessionStatus::Finished ||
+      status_ == SessionStatus::Failed) {
+    return status_;
+  }
+  switch (impl_->vm.Resume()) {
+    case VMStatus::Finished: status_ = SessionStatus::Finished; break;
+    case VMStatus::Failed: status_ = SessionStatus::Failed; break;
+    case VMStatus::WaitInput: status_ = SessionStatus::WaitInput; break;
+    case VMStatus::WaitOutput: status_ = SessionStatus::WaitOutput; break;
+  }
+  impl_->io.Flush();
+  if (status_ == SessionStatus::Failed) {
+    AppendDiags(impl_->errors, diags_);
+  }
+  return status_;
+}
+
+std::optional<int> Session::ret() const {
+  if (status_ != SessionStatus::Finished) return {};
+  return impl_->vm.ret();
+}
@@ -0,0 +1,387 @@
+#include "fstep/loop.h"
+
+#include <chrono>
+#include <thread>
+#include <algorithm>
+
+#if defined(__linux__)
+#define FIRSTSTEP_USE_EPOLL
+#include <sys/epoll.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <csignal>
+#include <ctime>
+#include <cerrno>
+#endif
+
+namespace {
+
+// max count of events handled at a time
+constexpr int kMaxEvents = 256;
+// size of buffer for reading inputs and outputs
+constexpr std::size_t kReadSize = 4096;
+
+#ifdef FIRSTSTEP_USE_EPOLL
+// event data of file descriptors, the lowest bit is set for outputs
+std::uint64_t MakeData(std::size_t id, bool is_out) {
+  return (static_cast<std::uint64_t>(id) << 1) | is_out;
+}
+
+bool SetNonBlocking(int fd) {
+  auto flags = fcntl(fd, F_GETFL);
+  return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) >= 0;
+}
+
+// blocks 'SIGPIPE' on the current thread, so that writing to a broken
+// pipe fails with 'EPIPE' instead of killing the process, signals that
+// are raised while blocked are discarded before unblocking
+// the disposition of 'SIGPIPE' and other threads are not affected
+class SigPipeBlocker {
+ public:
+  SigPipeBlocker() {
+    sigemptyset(&set_);
+    sigaddset(&set_, SIGPIPE);
+    sigset_t pending;
+    sigpending(&pending);
+    was_pending_ = sigismember(&pending, SIGPIPE) == 1;
+    pthread_sigmask(SIG_BLOCK, &set_, &last_);
+  }
+  ~SigPipeBlocker() {
+    if (!was_pending_) {
+      timespec zero = {0, 0};
+      while (sigtimedwait(&set_, nullptr, &zero) == SIGPIPE) {}
+    }
+    pthread_sigmask(SIG_SETMASK, &last_, nullptr);
+  }
+
+  SigPipeBlocker(const SigPipeBlocker &) = delete;
+  SigPipeBlocker &operator=(const SigPipeBlocker &) = delete;
+
+ private:
+  sigset_t set_, last_;
+  bool was_pending_;
+};
+#endif
+
+}  // namespace
+
+bool SessionLoop::IsSupported() {
+#ifdef FIRSTSTEP_USE_EPOLL
+  return true;
+#else
+  return false;
+#endif
+}
+
+SessionLoop::SessionLoop(const Program &prog, const EvalOptions &opts)
+    : prog_(prog), opts_(opts), alive_num_(0), resume_num_(0),
+      failed_num_(0) {
+#ifdef FIRSTSTEP_USE_EPOLL
+  epoll_fd_ = epoll_create1(0);
+#else
+  epoll_fd_ = -1;
+#endif
+}
+
+SessionLoop::~SessionLoop() {
+  for (std::size_t i = 0; i < conns_.size(); ++i) {
+    if (conns_[i].session) End(i);
+  }
+#ifdef FIRSTSTEP_USE_EPOLL
+  if (epoll_fd_ >= 0) close(epoll_fd_);
+#endif
+}
+
+bool SessionLoop::AddSession(int in_fd, int out_fd) {
+#ifdef FIRSTSTEP_USE_EPOLL
+  if (epoll_fd_ < 0 || !SetNonBlocking(in_fd) || !SetNonBlocking(out_fd)) {
+    return false;
+  }
+  auto id = conns_.size();
+  epoll_event ev = {};
+  ev.events = EPOLLIN;
+  ev.data.u64 = MakeData(id, false);
+  if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, in_fd, &ev) < 0) return false;
+  conns_.push_back({std::make_unique<Session>(prog_, opts_), in_fd,
+                    out_fd, false});
+  ++alive_num_;
+  return true;
+#else
+  return false;
+#endif
+}
+
+void SessionLoop::Run() {
+#ifdef FIRSTSTEP_USE_EPOLL
+  SigPipeBlocker blocker;
+  // run all sessions until they need inputs
+  for (std::size_t i = 0; i < conns_.size(); ++i) {
+    if (conns_[i].session) Pump(i);
+  }
+  epoll_event events[kMaxEvents];
+  while (alive_num_) {
+    auto num = epoll_wait(epoll_fd_, events, kMaxEvents, -1);
+    if (num < 0) {
+      if (errno == EINTR) continue;
+      break;
+    }
+    for (int i = 0; i < num; ++i) {
+      auto id = events[i].data.u64 >> 1;
+      // the session may have been ended by previous events
+      auto &conn = conns_[id];
+      if (!conn.session) continue;
+      if (events[i].data.u64 & 1) {
+        // outputs can be written, or the reader has gone
+        if (!WriteOutput(conn)) {
+          End(id);
+        }
+        else if (conn.session->status() == SessionStatus::WaitOutput &&
+                 conn.session->output().empty()) {
+          Pump(id);
+        }
+        else {
+          UpdateOutput(id);
+        }
+      }
+      else {
+        HandleInput(id);
+      }
+    }
+  }
+#endif
+}
+
+void SessionLoop::Pump(std::size_t id) {
+  auto &conn = conns_[id];
+  for (;;) {
+    auto status = conn.session->Resume();
+    ++resume_num_;
+    if (!WriteOutput(conn)) {
+      End(id);
+      return;
+    }
+    // continue if all outputs have been consumed
+    if (status != SessionStatus::WaitOutput ||
+        !conn.session->output().empty()) {
+      break;
+    }
+  }
+  if (conn.session->status() == SessionStatus::Failed) ++failed_num_;
+  UpdateOutput(id);
+}
+
+void SessionLoop::HandleInput(std::size_t id) {
+#ifdef FIRSTSTEP_USE_EPOLL
+  auto &conn = conns_[id];
+  char buf[kReadSize];
+  for (;;) {
+    auto len = read(conn.in_fd, buf, sizeof(buf));
+    if (len > 0) {
+      conn.session->PushInput({buf, static_cast<std::size_t>(len)});
+    }
+    else if (len < 0 && errno == EINTR) {
+      continue;
+    }
+    else {
+      // end of inputs, or errors other than having no inputs
+      if (!len || errno != EAGAIN) {
+        conn.session->CloseInput();
+        CloseInput(conn);
+      }
+      break;
+    }
+  }
+  if (conn.session->status() == SessionStatus::WaitInput) Pump(id);
+#endif
+}
+
+bool SessionLoop::WriteOutput(Conn &conn) {
+#ifdef FIRSTSTEP_USE_EPOLL
+  auto &output = conn.session->output();
+  std::size_t pos = 0;
+  while (pos < output.size()) {
+    auto len = write(conn.out_fd, output.data() + pos, output.size() - pos);
+    if (len < 0) {
+      if (errno == EINTR) continue;
+      if (errno == EAGAIN) break;
+      return false;
+    }
+    pos += len;
+  }
+  output.erase(0, pos);
+  return true;
+#else
+  return false;
+#endif
+}
+
+void SessionLoop::UpdateOutput(std::size_t id) {
+#ifdef FIRSTSTEP_USE_EPOLL
+  auto &conn = conns_[id];
+  if (!conn.session) return;
+  bool pending = !conn.session->output().empty();
+  auto status = conn.session->status();
+  if (!pending && (status == SessionStatus::Finished ||
+                   status == SessionStatus::Failed)) {
+    End(id);
+    return;
+  }
+  // wait for 'out_fd' only if there are pending outputs
+  if (pending != conn.wait_writable) {
+    epoll_event ev = {};
+    ev.events = EPOLLOUT;
+    ev.data.u64 = MakeData(id, true);
+    epoll_ctl(epoll_fd_, pending ? EPOLL_CTL_ADD : EPOLL_CTL_DEL,
+              conn.out_fd, &ev);
+    conn.wait_writable = pending;
+  }
+#endif
+}
+
+void SessionLoop::CloseInput(Conn &conn) {
+#ifdef FIRSTSTEP_USE_EPOLL
+  if (conn.in_fd < 0) return;
+  epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, conn.in_fd, nullptr);
+  close(conn.in_fd);
+  conn.in_fd = -1;
+#endif
+}
+
+void SessionLoop::End(std::size_t id) {
+#ifdef FIRSTSTEP_USE_EPOLL
+  auto &conn = conns_[id];
+  CloseInput(conn);
+  if (conn.wait_writable) {
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, conn.out_fd, nullptr);
+  }
+  close(conn.out_fd);
+  conn.session.reset();
+  --alive_num_;
+#endif
+}
+
+bool RunLoadTest(const Program &prog, const EvalOptions &opts,
+                 std::string_view input, std::size_t session_num,
+                 std::size_t chunk_size, LoadStats &stats) {
+#ifdef FIRSTSTEP_USE_EPOLL
+  using Clock = std::chrono::steady_clock;
+  if (!prog.resumable()) return false;
+  if (!chunk_size) chunk_size = input.size();
+  // expected outputs
+  EvalOptions vm_opts = opts;
+  vm_opts.engine = EvalEngine::VM;
+  auto expected = prog.Eval(input, vm_opts).output;
+  // create pipes of sessions, the driver writes inputs to 'in_fd',
+  // and reads outputs from 'out_fd'
+  struct Driver {
+    int in_fd, out_fd;
+    std::size_t pos;
+    std::string output;
+    Clock::time_point begin;
+  };
+  std::vector<Driver> drivers;
+  SessionLoop loop(prog, opts);
+  auto epoll_fd = epoll_create1(0);
+  bool ok = epoll_fd >= 0;
+  for (std::size_t i = 0; ok && i < session_num; ++i) {
+    int in[2], out[2];
+    if (pipe(in) < 0) {
+      ok = false;
+      break;
+    }
+    if (pipe(out) < 0) {
+      close(in[0]);
+      close(in[1]);
+      ok = false;
+      break;
+    }
+    drivers.push_back({in[1], out[0], 0, {}, {}});
+    epoll_event in_ev = {}, out_ev = {};
+    in_ev.events = EPOLLOUT;
+    in_ev.data.u64 = MakeData(i, true);
+    out_ev.events = EPOLLIN;
+    out_ev.data.u64 = MakeData(i, false);
+    ok = loop.AddSession(in[0], out[1]) && SetNonBlocking(in[1]) &&
+         SetNonBlocking(out[0]) &&
+         epoll_ctl(epoll_fd, EPOLL_CTL_ADD, in[1], &in_ev) >= 0 &&
+         epoll_ctl(epoll_fd, EPOLL_CTL_ADD, out[0], &out_ev) >= 0;
+  }
+  if (!ok) {
+    for (const auto &driver : drivers) {
+      close(driver.in_fd);
+      close(driver.out_fd);
+    }
+    if (epoll_fd >= 0) close(epoll_fd);
+    return false;
+  }
+  // serve sessions on another thread
+  auto begin = Clock::now();
+  std::thread server([&loop] { loop.Run(); });
+  stats = {session_num, 0, 0, 0, 0, {}};
+  SigPipeBlocker blocker;
+  std::size_t alive = session_num;
+  epoll_event events[kMaxEvents];
+  char buf[kReadSize];
+  while (alive) {
+    // wait until inputs can be fed or outputs can be collected
+    // pipes are level-triggered, so writable pipes of inputs are
+    // reported in turn, and every session gets a chunk at a time
+    auto num = epoll_wait(epoll_fd, events, kMaxEvents, -1);
+    if (num < 0 && errno != EINTR) break;
+    for (int i = 0; i < num; ++i) {
+      auto &driver = drivers[events[i].data.u64 >> 1];
+      if (events[i].data.u64 & 1) {
+        // feed a chunk of inputs, or the session has gone
+        if (!driver.pos) driver.begin = Clock::now();
+        auto size = std::min(chunk_size, input.size() - driver.pos);
+        auto len =
+            size ? write(driver.in_fd, input.data() + driver.pos, size) : 0;
+        if (len > 0) driver.pos += len;
+        if (driver.pos == input.size() ||
+            (len < 0 && errno != EAGAIN && errno != EINTR)) {
+          // closing also removes the pipe from epoll
+          close(driver.in_fd);
+          driver.in_fd = -1;
+        }
+        continue;
+      }
+      ssize_t len;
+      while ((len = read(driver.out_fd, buf, sizeof(buf))) > 0) {
+        driver.output.append(buf, len);
+      }
+      if (len < 0 && (errno == EAGAIN || errno == EINTR)) continue;
+      // the session has ended
+      std::chrono::nanoseconds nanos = Clock::now() - driver.begin;
+      stats.nanos.push_back(nanos.count());
+      if (driver.output != expected) ++stats.mismatch_num;
+      epoll_ctl(epoll_fd, EPOLL_CTL_DEL, driver.out_fd, nullptr);
+      close(driver.out_fd);
+      driver.out_fd = -1;
+      driver.output = {};
+      --alive;
+    }
+  }
+  // close pipes of sessions that have ended before reading all inputs,
+  // or all pipes if failed to wait, so that the server can finish
+  for (const auto &driver : drivers) {
+    if (driver.in_fd >= 0) close(driver.in_fd);
+    if (driver.out_fd >= 0) close(driver.out_fd);
+  }
+  server.join();
+  std::chrono::duration<double> secs = Clock::now() - begin;
+  close(epoll_fd);
+  stats.failed_num = loop.failed_num();
+  stats.resume_num = loop.resume_num();
+  stats.secs = secs.count();
+  return true;
+#else
+  static_cast<void>(prog);
+  static_cast<void>(opts);
+  static_cast<void>(input);
+  static_cast<void>(session_num);
+  static_cast<void>(chunk_size);
+  static_cast<void>(stats);
+  return false;
+#endif
+}
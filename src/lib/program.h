@@ -0,0 +1,27 @@
+#ifndef FIRSTSTEP_LIB_PROGRAM_H_
+#define FIRSTSTEP_LIB_PROGRAM_H_
+
+#include <optional>
+#include <vector>
+
+#include "fstep/fstep.h"
+#include "define/arena.h"
+#include "define/ast.h"
+#include "define/symbol.h"
+#include "back/vm/bytecode.h"
+
+// internal representation of a parsed program
+struct Program::Impl {
+  Impl() : use_frames(false) {}
+
+  SymbolTable symbols;
+  Arena arena;
+  // all function definitions, in order of definition
+  std::vector<ASTPtr> funcs;
+  // set if variables are resolved to slots of frames
+  bool use_frames;
+  // bytecode of the program, 'nullopt' if not supported by the VM
+  std::optional<Bytecode> bytecode;
+};
+
+#endif  // FIRSTSTEP_LIB_PROGRAM_H_
@@ -1,71 +1,675 @@
 #include <iostream>
 #include <fstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <iterator>
+#include <chrono>
 #include <cstdlib>
 #include <cstring>
+#include <cstdint>
+#include <cerrno>
+#include <thread>
 
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <x86intrin.h>
+#endif
+
+#if defined(__linux__)
+#include <sys/resource.h>
+#endif
+
+#include "front/source.h"
+#include "front/scan.h"
 #include "front/lexer.h"
 #include "front/parser.h"
+#include "front/parallel.h"
+#include "front/cache.h"
+#include "define/arena.h"
 #include "back/interpreter/interpreter.h"
 #include "back/compiler/irgen.h"
+#include "back/vm/codegen.h"
+#include "back/vm/vm.h"
+#include "back/runtime/io.h"
+#include "back/lanes/kernels.h"
+#include "fstep/fstep.h"
+#include "lib/batch.h"
+#include "fstep/loop.h"
 
 using namespace std;
 
-void Interpret(istream &in) {
-  // create lexer, parser and interpreter
-  Lexer lexer(in);
-  Parser parser(lexer);
-  Interpreter intp;
-  // parse the input file
+// working mode
+enum class Mode { Interpret, Compile, Lex, Parse, Bench, Batch, Sessions };
+
+// execution engine of interpreter mode
+// lanes are only used in batch mode, and run by interpreter otherwise
+enum class Engine { AST, VM, JIT, Lanes };
+
+// command line options
+struct Options {
+  Mode mode = Mode::Interpret;
+  Engine engine = Engine::AST;
+  // compare engines instead of running the program once
+  bool bench = false;
+  const char *input = nullptr, *output = nullptr;
+  // max nesting depth of blocks, parentheses, argument lists
+  // and chains of binary operators
+  size_t max_depth = Parser::kDefaultMaxDepth;
+  // count of parsing threads, parse sequentially if less than 2
+  size_t jobs = 0;
+  // load/save parsed program from/to cache file
+  bool cache = false;
+  // max size of memoization table in MiB, disabled if zero
+  size_t memo_mb = 0;
+  // max depth of calls at runtime
+  size_t max_calls = Interpreter::kDefaultMaxDepth;
+  // report peak stack usage at exit
+  bool stack_stats = false;
+  // count of workers evaluating operands of pure calls in parallel,
+  // disabled if less than 2
+  size_t fork = 0;
+  // write collapsed stacks of profiling to this file, disabled if null
+  const char *profile = nullptr;
+  // file of input records in batch mode, '-' for stdin
+  const char *records = nullptr;
+  // count of workers in batch mode, zero for all hardware threads
+  size_t workers = 0;
+  // count of concurrent sessions in load test mode
+  size_t sessions = 0;
+  // size of input chunks fed to sessions in load test mode
+  size_t chunk = 16;
+};
+
+// count of records that are read and evaluated at a time in batch mode
+constexpr size_t kBatchSize = 1 << 16;
+// max count of threads of parsing, forking and batch mode
+constexpr size_t kMaxThreads = 1024;
+
+// read the cycle counter, returns 0 if not available
+uint64_t ReadCycles() {
+#if defined(__x86_64__) && defined(__GNUC__)
+  return __rdtsc();
+#else
+  return 0;
+#endif
+}
+
+int Lex(const SourceBuffer &src) {
+  std::size_t err_num = 0;
+  // scan all tokens in the input file to token buffer
+  // using every supported scanner
+  auto best = static_cast<int>(GetBestScanISA());
+  for (int i = 0; i <= best; ++i) {
+    auto isa = static_cast<ScanISA>(i);
+    SymbolTable symbols;
+    Lexer lexer(src.data(), symbols, GetScanFuncs(isa));
+    TokenBuffer tokens;
+    auto begin = chrono::steady_clock::now();
+    auto begin_cycles = ReadCycles();
+    lexer.Tokenize(tokens);
+    auto cycles = ReadCycles() - begin_cycles;
+    chrono::duration<double> secs = chrono::steady_clock::now() - begin;
+    err_num = lexer.error_num();
+    // report throughput
+    auto mib = src.size() / 1048576.0;
+    cerr << GetScanISAName(isa) << ": " << tokens.size() << " tokens ("
+         << tokens.bytes() << " bytes), " << mib << " MiB in "
+         << secs.count() << " s, " << mib / secs.count() << " MiB/s";
+    if (cycles) cerr << ", " << double(src.size()) / cycles << " B/cycle";
+    cerr << endl;
+  }
+  return err_num;
+}
+
+// parse the input file and call the handler on every function definition
+// until the handler returns false, returns count of errors
+template <typename Handler>
+size_t ParseSource(const SourceBuffer &src, const Options &opts,
+                  SymbolTable &symbols, Arena &arena, Handler handler) {
+  if (opts.jobs > 1) {
+    ParallelParser parser(src.data(), symbols, arena, opts.jobs);
+    parser.set_max_depth(opts.max_depth);
+    while (auto ast = parser.ParseNext()) {
+      if (!handler(ast)) break;
+    }
+    return parser.error_num();
+  }
+  TokenBuffer tokens;
+  Lexer lexer(src.data(), symbols);
+  lexer.Tokenize(tokens);
+  Parser parser(tokens, arena);
+  parser.set_max_depth(opts.max_depth);
   while (auto ast = parser.ParseNext()) {
-    if (!intp.AddFunctionDef(move(ast))) break;
+    if (!handler(ast)) break;
   }
+  return parser.error_num();
+}
+
+// same as 'ParseSource', but loads the parsed program from cache file
+// if possible, and updates the cache file after parsing
+template <typename Handler>
+size_t ParseInput(const SourceBuffer &src, const Options &opts,
+                  SymbolTable &symbols, Arena &arena, Handler handler) {
+  if (!opts.cache) return ParseSource(src, opts, symbols, arena, handler);
+  // try to load from cache file
+  ProgramCache cache(src.data(), opts.input);
+  vector<ASTPtr> funcs;
+  if (cache.Load(symbols, arena, funcs, opts.max_depth)) {
+    for (const auto &func : funcs) {
+      if (!handler(func)) break;
+    }
+    return 0;
+  }
+  // parse, save only valid programs to cache file
+  bool is_valid = true;
+  auto err_num = ParseSource(src, opts, symbols, arena, [&](ASTPtr ast) {
+    funcs.push_back(ast);
+    return is_valid = handler(ast);
+  });
+  if (!err_num && is_valid) cache.Save(symbols, funcs);
+  return err_num;
+}
+
+int Parse(const SourceBuffer &src, const Options &opts) {
+  SymbolTable symbols;
+  Arena arena;
+  // parse the input file
+  std::size_t func_num = 0;
+  auto begin = chrono::steady_clock::now();
+  auto err_num = ParseSource(src, opts, symbols, arena, [&](ASTPtr) {
+    ++func_num;
+    return true;
+  });
+  chrono::duration<double> secs = chrono::steady_clock::now() - begin;
+  // report throughput and statistics of arena
+  auto mib = src.size() / 1048576.0;
+  cerr << func_num << " functions, " << symbols.size() << " symbols, "
+       << mib << " MiB in " << secs.count() << " s, "
+       << mib / secs.count() << " MiB/s" << endl;
+  cerr << "arena: " << arena.alloc_num() << " allocations, "
+       << arena.alloc_bytes() << " bytes, " << arena.block_num()
+       << " blocks" << endl;
+  return err_num;
+}
+
+// result of running a program
+struct RunResult {
+  optional<int> ret;
+  string output;
+  double secs;
+};
+
+// print peak stack usage of the specific engine
+template <typename Engine>
+void ReportStack(const char *name, const Engine &engine) {
+  cerr << "stack(" << name << "): peak depth " << engine.peak_depth()
+       << ", " << engine.peak_stack_bytes() << " bytes" << endl;
+}
+
+// run a program with the specific input, and capture its output
+template <typename Runner>
+RunResult RunWithInput(const string &input, Runner runner) {
+  string output;
+  auto begin = chrono::steady_clock::now();
+  optional<int> ret;
+  {
+    RuntimeIO io(input, output);
+    ret = runner(io);
+  }
+  chrono::duration<double> secs = chrono::steady_clock::now() - begin;
+  return {ret, output, secs.count()};
+}
+
+int Interpret(const SourceBuffer &src, const Options &opts) {
+  SymbolTable symbols;
+  Arena arena;
+  Interpreter intp;
+  // parse the input file
+  vector<ASTPtr> funcs;
+  auto err_num = ParseInput(src, opts, symbols, arena, [&](ASTPtr ast) {
+    funcs.push_back(ast);
+    return intp.AddFunctionDef(ast);
+  });
   // quit if there is any error
-  auto err_num = lexer.error_num() + parser.error_num() + intp.error_num();
-  if (err_num) exit(err_num);
+  err_num += intp.error_num();
+  if (err_num) return err_num;
+  intp.set_max_depth(opts.max_calls);
+  if (opts.mode == Mode::Bench) {
+    // read all inputs, so that both engines can read the same inputs
+    string input(istreambuf_iterator<char>(cin), {});
+    BytecodeGen gen;
+    if (!gen.Generate(funcs)) {
+      cerr << "vm: program is not supported, " << gen.reason() << endl;
+      return 1;
+    }
+    // run the program on both engines
+    auto intp_res = RunWithInput(input, [&](RuntimeIO &io) {
+      intp.set_io(io);
+      return intp.Eval();
+    });
+    auto vm_res = RunWithInput(input, [&](RuntimeIO &io) {
+      VM vm(gen.bytecode());
+      vm.set_max_depth(opts.max_calls);
+      vm.set_io(io);
+      return vm.Run();
+    });
+    // report results
+    bool same = intp_res.ret == vm_res.ret &&
+                intp_res.output == vm_res.output;
+    cerr << "interpreter: " << intp_res.secs << " s" << endl;
+    cerr << "vm: " << vm_res.secs << " s, "
+         << intp_res.secs / vm_res.secs << "x faster" << endl;
+    cerr << "results are " << (same ? "identical" : "different") << endl;
+    return !same;
+  }
+  // profiling is supported by interpreter only
+  if (opts.engine == Engine::VM && !opts.profile) {
+    // run on VM, fall back to interpreter if the program is not supported
+    BytecodeGen gen;
+    if (gen.Generate(funcs)) {
+      VM vm(gen.bytecode());
+      vm.set_max_depth(opts.max_calls);
+      auto ret = vm.Run();
+      GetStdIO().Flush();
+      if (opts.stack_stats) ReportStack("vm", vm);
+      if (!ret) return vm.error_num();
+      return *ret;
+    }
+  }
   // evaluate the program
+  intp.set_memo_bytes(opts.memo_mb << 20);
+  intp.set_profile(opts.profile);
+  intp.set_jit(opts.engine == Engine::JIT);
+  intp.set_fork_workers(opts.fork);
   auto ret = intp.Eval();
-  if (!ret) exit(intp.error_num());
-  exit(*ret);
+  GetStdIO().Flush();
+  if (const auto &prof = intp.profiler()) {
+    prof->WriteReport(cerr, symbols);
+    ofstream ofs(opts.profile);
+    prof->WriteCollapsed(ofs, symbols);
+    if (!ofs) {
+      cerr << "error: failed to write file '" << opts.profile << "'"
+           << endl;
+    }
+  }
+  if (opts.memo_mb) {
+    if (const auto &memo = intp.memo()) {
+      cerr << "memo: " << memo->hits() << " hits, " << memo->misses()
+           << " misses, " << memo->evictions() << " evictions, "
+           << memo->size() << " entries, " << memo->bytes() << " bytes"
+           << endl;
+    }
+    else {
+      cerr << "memo: disabled, variables can not be resolved" << endl;
+    }
+  }
+  if (opts.stack_stats) ReportStack("interpreter", intp);
+  if (!ret) return intp.error_num();
+  return *ret;
 }
 
-void Compile(istream &in, ostream &os) {
-  // create lexer, parser and IR generator
-  Lexer lexer(in);
-  Parser parser(lexer);
-  IRGenerator gen;
+// print the specific diagnostic to stderr
+void PrintDiag(const Diagnostic &diag) {
+  if (!diag.stage.empty()) cerr << "error(" << diag.stage << "): ";
+  cerr << diag.message << endl;
+}
+
+// print percentiles of latency
+void PrintLatency(vector<uint64_t> &nanos) {
+  if (nanos.empty()) return;
+  cerr << "latency:";
+  for (auto pct : {50, 90, 99, 100}) {
+    auto nth = nanos.begin() + (nanos.size() - 1) * pct / 100;
+    nth_element(nanos.begin(), nth, nanos.end());
+    cerr << (pct == 50 ? " " : ", ");
+    if (pct == 100) {
+      cerr << "max ";
+    }
+    else {
+      cerr << "p" << pct << " ";
+    }
+    cerr << *nth / 1000.0 << " us";
+  }
+  cerr << endl;
+}
+
+// read at most 'kBatchSize' lines as input records
+void ReadRecords(istream &is, vector<string> &records) {
+  records.clear();
+  string line;
+  while (records.size() < kBatchSize && getline(is, line)) {
+    records.push_back(std::move(line));
+  }
+}
+
+// evaluate all records on the interpreter and on lanes,
+// and compare the throughput
+int BenchBatch(const Program &prog, EvalOptions eval_opts,
+               size_t worker_num, istream &is) {
+  vector<string> records;
+  for (string line; getline(is, line);) records.push_back(std::move(line));
+  EvalEngine engines[] = {EvalEngine::AST, EvalEngine::Lanes};
+  vector<BatchResult> results[2];
+  double secs[2];
+  for (int i = 0; i < 2; ++i) {
+    eval_opts.engine = engines[i];
+    BatchEvaluator batch(prog, eval_opts, worker_num);
+    auto begin = chrono::steady_clock::now();
+    batch.Eval(records, results[i]);
+    chrono::duration<double> dur = chrono::steady_clock::now() - begin;
+    secs[i] = dur.count();
+  }
+  // report results
+  bool same = equal(results[0].begin(), results[0].end(),
+                    results[1].begin(), [](const auto &l, const auto &r) {
+                      return l.result.ret == r.result.ret &&
+                             l.result.output == r.result.output;
+                    });
+  cerr << records.size() << " records, " << worker_num << " workers"
+       << endl;
+  cerr << "interpreter: " << secs[0] << " s, "
+       << records.size() / secs[0] << " records/s" << endl;
+  cerr << "lanes(" << GetLaneISAName(GetBestLaneISA()) << " x "
+       << kLaneNum << "): " << secs[1] << " s, "
+       << records.size() / secs[1] << " records/s, "
+       << secs[0] / secs[1] << "x faster" << endl;
+  cerr << "results are " << (same ? "identical" : "different") << endl;
+  return !same;
+}
+
+int Batch(const SourceBuffer &src, const Options &opts) {
+  // parse once, and evaluate for every record
+  DiagList diags;
+  auto prog = Program::Parse(src.data(), diags, opts.max_depth);
+  for (const auto &diag : diags) PrintDiag(diag);
+  if (!prog) return diags.size();
+  // open the file of records
+  ifstream ifs;
+  if (strcmp(opts.records, "-")) {
+    ifs.open(opts.records);
+    if (!ifs) {
+      cerr << "error: failed to open file '" << opts.records << "'"
+           << endl;
+      return 1;
+    }
+  }
+  auto &is = ifs.is_open() ? static_cast<istream &>(ifs) : cin;
+  EvalOptions eval_opts;
+  eval_opts.engine = opts.engine == Engine::VM      ? EvalEngine::VM
+                     : opts.engine == Engine::JIT   ? EvalEngine::JIT
+                     : opts.engine == Engine::Lanes ? EvalEngine::Lanes
+                                                    : EvalEngine::AST;
+  eval_opts.max_depth = opts.max_calls;
+  eval_opts.memo_bytes = opts.memo_mb << 20;
+  auto worker_num =
+      opts.workers ? opts.workers : thread::hardware_concurrency();
+  if (opts.bench) return BenchBatch(*prog, eval_opts, worker_num, is);
+  BatchEvaluator batch(*prog, eval_opts, worker_num);
+  // evaluate records batch by batch, outputs are written in order
+  vector<string> records;
+  vector<BatchResult> results;
+  vector<uint64_t> nanos;
+  size_t failed = 0;
+  auto begin = chrono::steady_clock::now();
+  for (ReadRecords(is, records); !records.empty();
+       ReadRecords(is, records)) {
+    batch.Eval(records, results);
+    for (const auto &res : results) {
+      cout << res.result.output;
+      for (const auto &diag : res.result.diags) {
+        cerr << "record " << nanos.size() + 1 << ": ";
+        PrintDiag(diag);
+      }
+      if (!res.result.ret) ++failed;
+      nanos.push_back(res.nanos);
+    }
+  }
+  cout.flush();
+  chrono::duration<double> secs = chrono::steady_clock::now() - begin;
+  // report throughput and percentiles of latency
+  cerr << nanos.size() << " records, " << failed << " failed, "
+       << batch.worker_num() << " workers, " << secs.count() << " s, "
+       << nanos.size() / secs.count() << " records/s" << endl;
+  PrintLatency(nanos);
+  return failed != 0;
+}
+
+int Sessions(const SourceBuffer &src, const Options &opts) {
+  DiagList diags;
+  auto prog = Program::Parse(src.data(), diags, opts.max_depth);
+  for (const auto &diag : diags) PrintDiag(diag);
+  if (!prog) return diags.size();
+  if (!SessionLoop::IsSupported()) {
+    cerr << "error: sessions are not supported on this platform" << endl;
+    return 1;
+  }
+  if (!prog->resumable()) {
+    cerr << "error: program is not supported by VM" << endl;
+    return 1;
+  }
+  // every session uses 4 file descriptors, raise the soft limit
+#if defined(__linux__)
+  rlimit limit;
+  if (!getrlimit(RLIMIT_NOFILE, &limit)) {
+    limit.rlim_cur = limit.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &limit);
+  }
+#endif
+  // every session is fed with all inputs from stdin
+  string input(istreambuf_iterator<char>(cin), {});
+  EvalOptions eval_opts;
+  eval_opts.engine = EvalEngine::VM;
+  eval_opts.max_depth = opts.max_calls;
+  LoadStats stats;
+  if (!RunLoadTest(*prog, eval_opts, input, opts.sessions, opts.chunk,
+                   stats)) {
+    cerr << "error: failed to set up sessions, every session needs "
+         << "4 file descriptors, check the limit of open files" << endl;
+    return 1;
+  }
+  cerr << stats.session_num << " sessions, " << stats.failed_num
+       << " failed, " << stats.mismatch_num << " mismatched, "
+       << stats.resume_num << " resumptions, " << stats.secs << " s, "
+       << stats.session_num / stats.secs << " sessions/s" << endl;
+  PrintLatency(stats.nanos);
+  return stats.failed_num || stats.mismatch_num;
+}
+
+int Compile(const SourceBuffer &src, const Options &opts, ostream &os) {
+  SymbolTable symbols;
+  Arena arena;
+  IRGenerator gen(symbols);
   // parse the input file
-  while (auto ast = parser.ParseNext()) {
+  auto err_num = ParseInput(src, opts, symbols, arena, [&](ASTPtr ast) {
     ast->GenerateIR(gen);
-    if (gen.error_num()) break;
-  }
+    return !gen.error_num();
+  });
   // quit if there is any error
-  auto err_num = lexer.error_num() + parser.error_num() + gen.error_num();
-  if (err_num) exit(err_num);
+  err_num += gen.error_num();
+  if (err_num) return err_num;
   // dump generated IRs
   gen.Dump(os);
+  return 0;
 }
 
-int main(int argc, const char *argv[]) {
-  // read file from command line argument
-  if (argc < 2) {
-    cerr << "usage: " << argv[0] << " <INPUT> [-c [-o <OUTPUT>]]"
-         << std::endl;
-    return 1;
+// parse 'argv[i]', the value of option 'argv[i - 1]', as a decimal
+// count in range ['min', 'max'], prints an error message if invalid
+bool ParseCount(const char *argv[], int i, size_t min, size_t max,
+                size_t &val) {
+  const char *opt = argv[i - 1], *str = argv[i];
+  // 'strtoull' accepts leading spaces and signs, reject them
+  char *end;
+  errno = 0;
+  auto num = strtoull(str, &end, 10);
+  if (*str >= '0' && *str <= '9' && !*end && errno != ERANGE &&
+      num >= min && num <= max) {
+    val = num;
+    return true;
   }
-  ifstream ifs(argv[1]);
-  // check if need to compile the input file
-  if (argc >= 3 && !strcmp(argv[2], "-c")) {
-    // initialize output stream
-    if (argc >= 5 && !strcmp(argv[3], "-o")) {
-      ofstream ofs(argv[4]);
-      Compile(ifs, ofs);
+  cerr << "error: invalid value '" << str << "' of option '" << opt
+       << "', expected an integer not less than " << min;
+  if (max != SIZE_MAX) cerr << " and not greater than " << max;
+  cerr << endl;
+  return false;
+}
+
+// print the usage, returns the exit code
+int PrintUsage(const char *prog) {
+  cerr << "usage: " << prog
+       << " <INPUT> [-c [-o <OUTPUT>] | -l | -p | -b] [-e <ENGINE>]"
+       << " [-d <DEPTH>] [-j <JOBS>] [-k] [-m <MB>]"
+       << " [--max-depth <CALLS>] [--stack-stats] [--fork <JOBS>]"
+       << " [--profile <FILE>] [--batch <RECORDS> [--workers <N>]]"
+       << " [--sessions <N> [--chunk <BYTES>]]" << endl;
+  return 1;
+}
+
+int main(int argc, const char *argv[]) {
+  // library functions use their own buffered I/O, 'std::cin' is only
+  // used for reading all inputs in benchmark mode
+  ios::sync_with_stdio(false);
+  // parse command line arguments
+  Options opts;
+  for (int i = 1; i < argc; ++i) {
+    if (!strcmp(argv[i], "-c")) {
+      opts.mode = Mode::Compile;
+    }
+    else if (!strcmp(argv[i], "-o") && i + 1 < argc) {
+      opts.output = argv[++i];
+    }
+    else if (!strcmp(argv[i], "-l")) {
+      opts.mode = Mode::Lex;
+    }
+    else if (!strcmp(argv[i], "-p")) {
+      opts.mode = Mode::Parse;
+    }
+    else if (!strcmp(argv[i], "-d") && i + 1 < argc) {
+      if (!ParseCount(argv, ++i, 1, Parser::kMaxDepthLimit,
+                      opts.max_depth)) {
+        return PrintUsage(argv[0]);
+      }
+    }
+    else if (!strcmp(argv[i], "-e") && i + 1 < argc) {
+      ++i;
+      if (!strcmp(argv[i], "vm")) {
+        opts.engine = Engine::VM;
+      }
+      else if (!strcmp(argv[i], "ast")) {
+        opts.engine = Engine::AST;
+      }
+      else if (!strcmp(argv[i], "jit")) {
+        opts.engine = Engine::JIT;
+      }
+      else if (!strcmp(argv[i], "lanes")) {
+        opts.engine = Engine::Lanes;
+      }
+      else {
+        opts.input = nullptr;
+        break;
+      }
+    }
+    else if (!strcmp(argv[i], "-b")) {
+      // compares engines of batch mode if batch mode is enabled
+      opts.bench = true;
+      if (opts.mode != Mode::Batch) opts.mode = Mode::Bench;
+    }
+    else if (!strcmp(argv[i], "-k")) {
+      opts.cache = true;
+    }
+    else if (!strcmp(argv[i], "-m") && i + 1 < argc) {
+      if (!ParseCount(argv, ++i, 0, SIZE_MAX >> 20, opts.memo_mb)) {
+        return PrintUsage(argv[0]);
+      }
+    }
+    else if (!strcmp(argv[i], "--max-depth") && i + 1 < argc) {
+      if (!ParseCount(argv, ++i, 1, SIZE_MAX, opts.max_calls)) {
+        return PrintUsage(argv[0]);
+      }
+    }
+    else if (!strcmp(argv[i], "--stack-stats")) {
+      opts.stack_stats = true;
+    }
+    else if (!strcmp(argv[i], "--fork") && i + 1 < argc) {
+      // use all hardware threads if zero
+      if (!ParseCount(argv, ++i, 0, kMaxThreads, opts.fork)) {
+        return PrintUsage(argv[0]);
+      }
+      if (!opts.fork) opts.fork = thread::hardware_concurrency();
+    }
+    else if (!strcmp(argv[i], "--profile") && i + 1 < argc) {
+      opts.profile = argv[++i];
+    }
+    else if (!strcmp(argv[i], "--batch") && i + 1 < argc) {
+      opts.mode = Mode::Batch;
+      opts.records = argv[++i];
+    }
+    else if (!strcmp(argv[i], "--workers") && i + 1 < argc) {
+      if (!ParseCount(argv, ++i, 0, kMaxThreads, opts.workers)) {
+        return PrintUsage(argv[0]);
+      }
+    }
+    else if (!strcmp(argv[i], "--sessions") && i + 1 < argc) {
+      opts.mode = Mode::Sessions;
+      if (!ParseCount(argv, ++i, 1, SIZE_MAX, opts.sessions)) {
+        return PrintUsage(argv[0]);
+      }
+    }
+    else if (!strcmp(argv[i], "--chunk") && i + 1 < argc) {
+      // feed all inputs at once if zero
+      if (!ParseCount(argv, ++i, 0, SIZE_MAX, opts.chunk)) {
+        return PrintUsage(argv[0]);
+      }
+    }
+    else if (!strcmp(argv[i], "-j") && i + 1 < argc) {
+      // use all hardware threads if zero
+      if (!ParseCount(argv, ++i, 0, kMaxThreads, opts.jobs)) {
+        return PrintUsage(argv[0]);
+      }
+      if (!opts.jobs) opts.jobs = thread::hardware_concurrency();
+    }
+    else if (!opts.input) {
+      opts.input = argv[i];
     }
     else {
-      Compile(ifs, cout);
+      opts.input = nullptr;
+      break;
+    }
+  }
+  if (!opts.input) return PrintUsage(argv[0]);
+  // the program can be read from stdin, which is then unavailable
+  // for records and inputs, and is never cached
+  if (!strcmp(opts.input, "-")) {
+    if (opts.records && !strcmp(opts.records, "-")) {
+      cerr << "error: stdin can not hold both the program and records"
+           << endl;
+      return 1;
     }
+    opts.cache = false;
   }
-  else {
-    Interpret(ifs);
+  // read the input file
+  SourceBuffer src(opts.input);
+  if (!src.is_open()) {
+    cerr << "error: failed to open file '" << opts.input << "'" << endl;
+    return 1;
+  }
+  switch (opts.mode) {
+    case Mode::Interpret: case Mode::Bench: return Interpret(src, opts);
+    case Mode::Compile: {
+      // initialize output stream
+      if (opts.output) {
+        ofstream ofs(opts.output);
+        return Compile(src, opts, ofs);
+      }
+      return Compile(src, opts, cout);
+    }
+    // lex only, measure throughput of lexer
+    case Mode::Lex: return Lex(src);
+    // parse only, measure throughput of parser
+    case Mode::Parse: return Parse(src, opts);
+    // evaluate every input record in parallel
+    case Mode::Batch: return Batch(src, opts);
+    // load test of sessions served by an event loop
+    case Mode::Sessions: return Sessions(src, opts);
   }
   return 0;
 }
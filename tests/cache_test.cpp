@@ -0,0 +1,99 @@
+// cache files are untrusted, broken or crafted files must be rejected
+// instead of crashing the loader
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include <cstddef>
+
+#include "front/cache.h"
+#include "front/lexer.h"
+#include "front/parser.h"
+#include "front/tokens.h"
+#include "define/arena.h"
+#include "define/symbol.h"
+#include "test.h"
+
+namespace {
+
+constexpr char kSource[] = "main() { return 1 }";
+constexpr char kPath[] = "cache_test.fstep";
+
+// write the cache file of 'kSource'
+bool SaveCache(const ProgramCache &cache) {
+  SymbolTable symbols;
+  Arena arena;
+  TokenBuffer tokens;
+  Lexer lexer(kSource, symbols);
+  lexer.Tokenize(tokens);
+  Parser parser(tokens, arena);
+  std::vector<ASTPtr> funcs;
+  while (auto ast = parser.ParseNext()) funcs.push_back(ast);
+  return !parser.error_num() && cache.Save(symbols, funcs);
+}
+
+// replace the cache file by the specific contents
+void WriteFile(const std::string &path, const std::string &data) {
+  std::ofstream ofs(path, std::ios::binary);
+  ofs.write(data.data(), data.size());
+}
+
+// try to load the cache file with the default max depth
+bool Load(const ProgramCache &cache) {
+  SymbolTable symbols;
+  Arena arena;
+  std::vector<ASTPtr> funcs;
+  return cache.Load(symbols, arena, funcs, Parser::kDefaultMaxDepth);
+}
+
+}  // namespace
+
+int main() {
+  ProgramCache cache(kSource, kPath);
+  EXPECT(SaveCache(cache));
+  EXPECT(Load(cache));
+  std::string data;
+  {
+    std::ifstream ifs(cache.path(), std::ios::binary);
+    data.assign(std::istreambuf_iterator<char>(ifs), {});
+  }
+  // the file ends with the tag and the value of integer literal '1',
+  // wrap the literal in unary operators
+  EXPECT(data.size() > 2 && data[data.size() - 1] == 1);
+  auto literal = data.substr(data.size() - 2);
+  data.resize(data.size() - 2);
+  // tag of 'UnaryAST', and index of operator '-'
+  std::string unary = {7, static_cast<char>(Operator::Sub)};
+  // a few levels are fine
+  WriteFile(cache.path(), data + unary + unary + literal);
+  EXPECT(Load(cache));
+  // nesting deeper than the parser allows is rejected
+  std::string deep;
+  for (std::size_t i = 0; i < 100000; ++i) deep += unary;
+  WriteFile(cache.path(), data + deep + literal);
+  EXPECT(!Load(cache));
+  // truncated files are rejected
+  WriteFile(cache.path(), data + deep);
+  EXPECT(!Load(cache));
+  // statements are rejected in expressions, tag of empty 'BlockAST'
+  WriteFile(cache.path(), data + std::string{1, 0});
+  EXPECT(!Load(cache));
+  // operators are checked by their classes, tag of 'BinaryAST'
+  auto binary = [](Operator op) {
+    return std::string{6, static_cast<char>(op)};
+  };
+  WriteFile(cache.path(), data + binary(Operator::Add) + literal + literal);
+  EXPECT(Load(cache));
+  WriteFile(cache.path(),
+            data + binary(Operator::Define) + literal + literal);
+  EXPECT(!Load(cache));
+  WriteFile(cache.path(), data + binary(Operator::LNot) + literal + literal);
+  EXPECT(!Load(cache));
+  std::string unary_add = {7, static_cast<char>(Operator::Add)};
+  WriteFile(cache.path(), data + unary_add + literal);
+  EXPECT(!Load(cache));
+  std::remove(cache.path().c_str());
+  return TestResult();
+}
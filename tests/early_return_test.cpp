@@ -0,0 +1,89 @@
+// 'return' exits the function immediately, so statements after it are
+// never executed, and never generated in IR
+
+#include <string>
+#include <string_view>
+#include <cstdint>
+
+#include "front/lexer.h"
+#include "front/parser.h"
+#include "front/tokens.h"
+#include "define/arena.h"
+#include "define/symbol.h"
+#include "back/interpreter/interpreter.h"
+#include "back/runtime/io.h"
+#include "fstep/fstep.h"
+#include "test.h"
+
+namespace {
+
+// function with an early-out guard, and 4 statements after the guard
+constexpr char kGuard[] = R"(
+f(n) {
+  if n < 0 {
+    if n < -5 {
+      return -2
+    }
+    print(n)
+    return -1
+  }
+  a := n + 1
+  b := a * 2
+  print(b)
+  return b
+}
+)";
+
+// evaluate the specific program on the interpreter with profiling,
+// returns the count of executed statements
+std::uint64_t CountStatements(const std::string &src, int ret) {
+  SymbolTable symbols;
+  Arena arena;
+  TokenBuffer tokens;
+  Lexer lexer(src, symbols);
+  lexer.Tokenize(tokens);
+  Parser parser(tokens, arena);
+  Interpreter intp;
+  while (auto ast = parser.ParseNext()) intp.AddFunctionDef(ast);
+  std::string output;
+  RuntimeIO io(std::string_view(), output);
+  intp.set_io(io);
+  intp.set_profile(true);
+  EXPECT(intp.Eval() == ret);
+  const auto &prof = intp.profiler();
+  return prof ? prof->stmt_num() : 0;
+}
+
+// generate IR of the specific program
+std::string GenerateIR(const std::string &src) {
+  DiagList diags;
+  auto prog = Program::Parse(src, diags);
+  std::string output;
+  if (!prog || !prog->Compile(output, diags)) return {};
+  return output;
+}
+
+}  // namespace
+
+int main() {
+  // 'main' executes 1 statement, 'f' executes the guard and then:
+  //   2 statements of the outer 'then' block if 'n < -5',
+  //   3 statements of the outer 'then' block if '-5 <= n < 0',
+  //   4 statements after the guard otherwise
+  auto guard = std::string(kGuard);
+  EXPECT(CountStatements(guard + "main() { return f(1) }", 4) == 1 + 5);
+  EXPECT(CountStatements(guard + "main() { return f(-1) }", -1) == 1 + 4);
+  EXPECT(CountStatements(guard + "main() { return f(-9) }", -2) == 1 + 3);
+  // statements after 'return' in the same block are never executed
+  EXPECT(CountStatements("main() { return 1 print(2) print(3) }", 1) ==
+         1);
+  // a return in a callee does not stop the caller
+  EXPECT(CountStatements(guard + "main() { f(-9) return f(-1) }", -1) ==
+         2 + 3 + 4);
+  // statements after 'return' are not generated
+  EXPECT(GenerateIR("main() { return 1 print(2) x := 3 }") ==
+         GenerateIR("main() { return 1 }"));
+  EXPECT(GenerateIR("main() { if 1 { return 1 print(2) } return 0 }") ==
+         GenerateIR("main() { if 1 { return 1 } return 0 }"));
+  return TestResult();
+}
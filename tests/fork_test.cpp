@@ -0,0 +1,78 @@
+// forked operands: a failed left operand cancels its right operand,
+// even if the right operand never terminates, and the pool of workers
+// is kept between evaluations of an evaluator
+
+#include <string>
+#include <cstddef>
+
+#include "fstep/fstep.h"
+#include "test.h"
+
+namespace {
+
+// 'spin' never returns, 'bad' fails at the bottom of a deep recursion
+constexpr char kSource[] = R"(
+spin(n) {
+  return spin(n + 1)
+}
+
+bad(n) {
+  if n == 0 {
+    return 1 / n
+  }
+  return 1 + bad(n - 1)
+}
+
+fib(n) {
+  if n <= 2 {
+    return 1
+  }
+  return fib(n - 1) + fib(n - 2)
+}
+
+nested(n) {
+  return fib(n) + (spin(0) + fib(3))
+}
+
+main() {
+  n := input()
+  if n == 0 {
+    return bad(200000) + spin(0)
+  }
+  if n == 1 {
+    return bad(300000) + nested(20)
+  }
+  return fib(n)
+}
+)";
+
+constexpr std::size_t kEvalNum = 20;
+
+}  // namespace
+
+int main() {
+  DiagList diags;
+  auto prog = Program::Parse(kSource, diags);
+  EXPECT(prog);
+  if (!prog) return TestResult();
+  for (auto workers : {2, 4}) {
+    EvalOptions opts;
+    opts.fork_workers = workers;
+    Evaluator eval(*prog, opts);
+    for (std::size_t i = 0; i < kEvalNum; ++i) {
+      // cancelled operands report no errors
+      auto result = eval.Eval(std::to_string(i % 3));
+      if (i % 3 < 2) {
+        EXPECT(!result.ret && result.diags.size() == 1);
+        if (result.diags.size() == 1) {
+          EXPECT(result.diags[0].message == "division by zero");
+        }
+      }
+      else {
+        EXPECT(result.ret == 1 && result.diags.empty());
+      }
+    }
+    EXPECT(eval.Eval("25").ret == 75025);
+  }
+  return TestResult();
+}
@@ -0,0 +1,274 @@
+// differential test of engines on generated programs, every program
+// has a driver loop which calls all functions more times than the
+// threshold of JIT, so the same code is run by the interpreter, the VM
+// and compiled code, results and outputs must be identical
+// programs are also run on lanes, with different inputs per record
+// usage: jit_test [COUNT [FIRST_SEED]]
+
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+#include <cstdint>
+
+#include "back/jit/jit.h"
+#include "fstep/fstep.h"
+#include "lib/batch.h"
+#include "test.h"
+
+namespace {
+
+// count of calls of every function made by the driver loop
+constexpr int kDriverCalls = JIT::kHotCalls + 20;
+
+// generator of random recursive programs, with calls, tail calls,
+// library calls, missing return values and wrapping arithmetic
+class ProgramGen {
+ public:
+  explicit ProgramGen(std::uint32_t seed) : rng_(seed) {}
+
+  // generate a new program
+  std::string Generate() {
+    names_.clear();
+    params_.clear();
+    auto func_num = Rand(1, 4);
+    // parameters have distinct names, since arguments of callees
+    // are visible while evaluating the rest of arguments, which makes
+    // variables unresolvable, and such programs are never compiled
+    for (int i = 0; i < func_num; ++i) {
+      auto id = std::to_string(i);
+      names_.push_back("f" + id);
+      params_.push_back({"n" + id});
+      auto arg_num = Rand(0, 4);
+      for (int j = 0; j < arg_num; ++j) {
+        params_.back().push_back("x" + id + "_" + std::to_string(j));
+      }
+    }
+    // every function returns at the bottom of the recursion
+    std::string src;
+    for (std::size_t i = 0; i < names_.size(); ++i) {
+      const auto &params = params_[i];
+      n_ = params[0];
+      src += names_[i] + "(" + Join(params) + ") {\n";
+      src += "  if " + n_ + " <= 0 {\n";
+      std::vector<std::string> args(params.begin() + 1, params.end());
+      src += "    return " + Expr(args, 3) + "\n  }\n";
+      src += Block(params, 0, "  ");
+      if (Real() < 0.85) src += "  return " + Expr(params, 0) + "\n";
+      src += "}\n";
+    }
+    // driver loop, a tail recursive function
+    src += "drive(i) {\n  if i <= 0 {\n    return 0\n  }\n";
+    auto call_num = Rand(1, 3);
+    for (int i = 0; i < call_num; ++i) {
+      auto callee = Rand(0, names_.size() - 1);
+      std::vector<std::string> args = {"i % 6"};
+      for (std::size_t j = 1; j < params_[callee].size(); ++j) {
+        args.push_back(std::to_string(Rand(-5, 5)));
+      }
+      src += "  print(" + names_[callee] + "(" + Join(args) + "))\n";
+    }
+    src += "  return drive(i - 1)\n}\n";
+    src += "main() {\n  return drive(" + std::to_string(kDriverCalls) +
+           ")\n}\n";
+    return src;
+  }
+
+ private:
+  // get a random integer in ['lo', 'hi']
+  int Rand(int lo, int hi) {
+    return std::uniform_int_distribution<int>(lo, hi)(rng_);
+  }
+  // get a random real number in [0, 1)
+  double Real() { return std::uniform_real_distribution<>()(rng_); }
+  // pick a random element
+  std::string Pick(const std::vector<std::string> &vals) {
+    return vals[Rand(0, vals.size() - 1)];
+  }
+  // join the specific strings by commas
+  static std::string Join(const std::vector<std::string> &strs) {
+    std::string ret;
+    for (const auto &str : strs) ret += (ret.empty() ? "" : ", ") + str;
+    return ret;
+  }
+
+  // generate a call, the recursion always goes down
+  std::string Call(std::vector<std::string> vars, int depth) {
+    auto callee = Rand(0, names_.size() - 1);
+    // 'n' may be hidden by an outer call
+    std::vector<std::string> args = {"0"};
+    if (std::find(vars.begin(), vars.end(), n_) != vars.end()) {
+      args[0] = n_ + " - " + std::to_string(Rand(1, 3));
+    }
+    // the rest of arguments can not read parameters of callee
+    const auto &params = params_[callee];
+    vars.erase(std::remove_if(vars.begin(), vars.end(),
+                              [&params](const std::string &var) {
+                                return std::find(params.begin(),
+                                                 params.end(),
+                                                 var) != params.end();
+                              }),
+               vars.end());
+    for (std::size_t i = 1; i < params.size(); ++i) {
+      args.push_back(Expr(vars, depth + 1));
+    }
+    return names_[callee] + "(" + Join(args) + ")";
+  }
+
+  // generate an expression
+  std::string Expr(const std::vector<std::string> &vars, int depth) {
+    static const std::vector<std::string> kConsts = {
+        "0", "1", "2", "7", "-3", "100000", "2147483647", "-2147483648"};
+    static const std::vector<std::string> kOps = {
+        "+", "-", "*", "+", "-", "*", "/", "%",
+        "<", "<=", "==", "!=", "&&", "||"};
+    auto r = Real();
+    if (depth > 2 || r < 0.15) {
+      if (!vars.empty() && Real() < 0.6) return Pick(vars);
+      return Pick(kConsts);
+    }
+    if (r < 0.35) return Call(vars, depth);
+    if (r < 0.4) return "input()";
+    if (r < 0.48) {
+      return (Real() < 0.5 ? "-(" : "!(") + Expr(vars, depth + 1) + ")";
+    }
+    auto op = Pick(kOps);
+    auto lhs = Expr(vars, depth + 1), rhs = Expr(vars, depth + 1);
+    // divisors are odd, but may still be -1
+    if (op == "/" || op == "%") {
+      rhs = Real() < 0.5 ? "((" + rhs + ") % 7 * 2 + 1)"
+                         : Pick({"1", "3", "-5", "7"});
+    }
+    return "(" + lhs + " " + op + " " + rhs + ")";
+  }
+
+  // generate statements of a block
+  std::string Block(std::vector<std::string> vars, int depth,
+                    const std::string &indent) {
+    std::string ret;
+    std::vector<std::string> defined;
+    auto stmt_num = Rand(1, 3);
+    for (int i = 0; i < stmt_num; ++i) {
+      auto r = Real();
+      if (r < 0.25) {
+        auto var = Pick({"a", "b", "c"});
+        if (std::find(defined.begin(), defined.end(), var) !=
+            defined.end()) {
+          continue;
+        }
+        ret += indent + var + " := " + Expr(vars, 0) + "\n";
+        defined.push_back(var);
+        vars.push_back(var);
+      }
+      else if (r < 0.4 && vars.size() > 1) {
+        // 'n' is never assigned, so the recursion always terminates
+        auto var = Pick(vars);
+        if (var == n_) continue;
+        ret += indent + var + " = " + Expr(vars, 0) + "\n";
+      }
+      else if (r < 0.55 && depth < 2) {
+        ret += indent + "if " + Expr(vars, 0) + " {\n" +
+               Block(vars, depth + 1, indent + "  ") + indent + "}";
+        if (Real() < 0.5) {
+          ret += " else {\n" +
+                 Block(vars, depth + 1, indent + "  ") + indent + "}";
+        }
+        ret += "\n";
+      }
+      else if (r < 0.7) {
+        ret += indent + "print(" + Expr(vars, 0) + ")\n";
+      }
+      else if (r < 0.85) {
+        ret += indent + "return " + Call(vars, 0) + "\n";
+      }
+      else {
+        ret += indent + "return " + Expr(vars, 0) + "\n";
+      }
+    }
+    return ret;
+  }
+
+  std::mt19937 rng_;
+  // names and parameters of all functions
+  std::vector<std::string> names_;
+  std::vector<std::vector<std::string>> params_;
+  // the first parameter of the current function, which goes down
+  std::string n_;
+};
+
+// check if the specific results are identical, including stages
+// of diagnostics, which are the same for all engines
+bool IsSame(const EvalResult &lhs, const EvalResult &rhs) {
+  if (lhs.ret != rhs.ret || lhs.output != rhs.output ||
+      lhs.diags.size() != rhs.diags.size()) {
+    return false;
+  }
+  for (std::size_t i = 0; i < lhs.diags.size(); ++i) {
+    if (lhs.diags[i].stage != rhs.diags[i].stage ||
+        lhs.diags[i].message != rhs.diags[i].message) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// run the program generated by the specific seed on all engines, the
+// first input is run by all engines, all inputs are run by lanes
+bool RunOnAll(std::uint32_t seed, const std::vector<std::string> &inputs) {
+  auto src = ProgramGen(seed).Generate();
+  DiagList diags;
+  auto prog = Program::Parse(src, diags);
+  if (!prog) {
+    std::cerr << "seed " << seed << ": failed to parse\n" << src;
+    return false;
+  }
+  EvalOptions opts;
+  opts.engine = EvalEngine::AST;
+  std::vector<EvalResult> expected;
+  for (const auto &input : inputs) {
+    expected.push_back(prog->Eval(input, opts));
+  }
+  for (auto engine : {EvalEngine::VM, EvalEngine::JIT}) {
+    opts.engine = engine;
+    if (!IsSame(prog->Eval(inputs[0], opts), expected[0])) {
+      std::cerr << "seed " << seed << ": results of "
+                << (engine == EvalEngine::VM ? "VM" : "JIT")
+                << " differ\n" << src;
+      return false;
+    }
+  }
+  // records take different paths, so lanes diverge
+  opts.engine = EvalEngine::Lanes;
+  BatchEvaluator batch(*prog, opts, 1);
+  std::vector<BatchResult> results;
+  batch.Eval(inputs, results);
+  for (std::size_t i = 0; i < inputs.size(); ++i) {
+    if (!IsSame(results[i].result, expected[i])) {
+      std::cerr << "seed " << seed << ": results of lane " << i
+                << " differ\n" << src;
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, const char *argv[]) {
+  auto count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 500;
+  auto first = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1;
+  // inputs read by 'input', followed by zeros at the end of input
+  // every record starts at a different offset of the same sequence
+  std::vector<std::string> inputs(kLaneNum);
+  for (std::size_t i = 0; i < inputs.size(); ++i) {
+    for (std::size_t j = i; j < i + 1000; ++j) {
+      inputs[i] += std::to_string(static_cast<int>(j % 11) - 5) + " ";
+    }
+  }
+  for (std::uint32_t seed = first; seed < first + count; ++seed) {
+    EXPECT(RunOnAll(seed, inputs));
+  }
+  return TestResult();
+}
@@ -0,0 +1,115 @@
+// interface of the library: diagnostics have positions in source,
+// and one program can be evaluated from several threads at the same
+// time, with the same results as sequential evaluations
+
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstddef>
+
+#include "fstep/fstep.h"
+#include "test.h"
+
+namespace {
+
+// program with outputs, inputs and a division by zero if input is 0
+constexpr char kSource[] = R"(
+fib(n) {
+  if n <= 2 {
+    return 1
+  }
+  return fib(n - 1) + fib(n - 2)
+}
+
+main() {
+  n := input()
+  print(fib(n))
+  return 100 / (n - 7 * (n / 7))
+}
+)";
+
+constexpr std::size_t kThreadNum = 8;
+constexpr std::size_t kEvalNum = 40;
+
+// check if the specific results are identical
+bool IsSame(const EvalResult &lhs, const EvalResult &rhs) {
+  if (lhs.ret != rhs.ret || lhs.output != rhs.output ||
+      lhs.diags.size() != rhs.diags.size()) {
+    return false;
+  }
+  for (std::size_t i = 0; i < lhs.diags.size(); ++i) {
+    if (lhs.diags[i].stage != rhs.diags[i].stage ||
+        lhs.diags[i].message != rhs.diags[i].message) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void CheckPositions() {
+  DiagList diags;
+  EXPECT(!Program::Parse("main() {\n  return 1 +\n}\n", diags));
+  EXPECT(diags.size() == 1);
+  if (diags.size() == 1) {
+    EXPECT(diags[0].stage == "parser");
+    EXPECT(diags[0].line == 3 && diags[0].column == 1);
+  }
+  diags.clear();
+  EXPECT(!Program::Parse("main() {\n  a := 007\n}\n", diags));
+  EXPECT(!diags.empty());
+  if (!diags.empty()) {
+    EXPECT(diags[0].stage == "lexer");
+    EXPECT(diags[0].line == 2 && diags[0].column == 8);
+  }
+  // errors of evaluations are not related to tokens
+  auto prog = Program::Parse(kSource, diags);
+  EXPECT(prog);
+  if (!prog) return;
+  auto result = prog->Eval("0");
+  EXPECT(!result.ret && result.diags.size() == 1);
+  if (result.diags.size() == 1) {
+    EXPECT(result.diags[0].message == "division by zero");
+    EXPECT(!result.diags[0].line && !result.diags[0].column);
+  }
+}
+
+void CheckThreads(EvalEngine engine) {
+  DiagList diags;
+  auto prog = Program::Parse(kSource, diags);
+  EXPECT(prog);
+  if (!prog) return;
+  EvalOptions opts;
+  opts.engine = engine;
+  // results of sequential evaluations
+  std::vector<EvalResult> expected;
+  for (std::size_t i = 0; i < kEvalNum; ++i) {
+    expected.push_back(prog->Eval(std::to_string(i % 20), opts));
+  }
+  // every thread evaluates all inputs, half of them by evaluators
+  // which are kept between evaluations
+  std::vector<std::size_t> mismatches(kThreadNum);
+  std::vector<std::thread> threads;
+  for (std::size_t t = 0; t < kThreadNum; ++t) {
+    threads.emplace_back([&, t] {
+      Evaluator eval(*prog, opts);
+      for (std::size_t i = 0; i < kEvalNum; ++i) {
+        auto input = std::to_string(i % 20);
+        auto result = (t + i) % 2 ? eval.Eval(input)
+                                  : prog->Eval(input, opts);
+        if (!IsSame(result, expected[i])) ++mismatches[t];
+      }
+    });
+  }
+  for (auto &thread : threads) thread.join();
+  for (auto num : mismatches) EXPECT(!num);
+}
+
+}  // namespace
+
+int main() {
+  CheckPositions();
+  for (auto engine : {EvalEngine::AST, EvalEngine::VM, EvalEngine::JIT}) {
+    CheckThreads(engine);
+  }
+  return TestResult();
+}
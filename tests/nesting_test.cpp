@@ -0,0 +1,94 @@
+// generated programs with pathologically deep nesting, which must be
+// rejected by the parser, or handled without native recursion
+
+#include <string>
+#include <cstddef>
+
+#include "front/parser.h"
+#include "fstep/fstep.h"
+#include "test.h"
+
+namespace {
+
+// depth of generated programs
+constexpr std::size_t kDepth = 100000;
+
+// repeat the specific string
+std::string Repeat(const std::string &str, std::size_t num) {
+  std::string ret;
+  ret.reserve(str.size() * num);
+  for (std::size_t i = 0; i < num; ++i) ret += str;
+  return ret;
+}
+
+// check if parsing the specific source fails with a nesting error
+bool IsTooDeep(const std::string &src,
+               std::size_t max_depth = Parser::kDefaultMaxDepth) {
+  DiagList diags;
+  auto prog = Program::Parse(src, diags, max_depth);
+  return !prog && !diags.empty() &&
+         diags[0].message == "nesting is too deep";
+}
+
+// check if the specific source returns the specific value on
+// every engine, and can be compiled
+bool ReturnsOnAll(const std::string &src, int ret,
+                  std::size_t max_depth = Parser::kDefaultMaxDepth) {
+  DiagList diags;
+  auto prog = Program::Parse(src, diags, max_depth);
+  if (!prog) return false;
+  for (auto engine : {EvalEngine::AST, EvalEngine::VM, EvalEngine::JIT}) {
+    EvalOptions opts;
+    opts.engine = engine;
+    auto result = prog->Eval("", opts);
+    if (result.ret != ret) return false;
+  }
+  std::string output;
+  return prog->Compile(output, diags);
+}
+
+}  // namespace
+
+int main() {
+  // parentheses
+  EXPECT(IsTooDeep("main() { return " + Repeat("(", kDepth) + "1" +
+                   Repeat(")", kDepth) + " }"));
+  // blocks
+  EXPECT(IsTooDeep("main() { " + Repeat("if 1 { ", kDepth) +
+                   "return 1 " + Repeat("} ", kDepth) + "return 0 }"));
+  // argument lists
+  EXPECT(IsTooDeep("f(x) { return x } main() { return " +
+                   Repeat("f(", kDepth) + "1" + Repeat(")", kDepth) +
+                   " }"));
+  // chains of binary operators, which are not nested syntactically,
+  // but build left-deep trees
+  EXPECT(IsTooDeep("main() { return 1" + Repeat(" + 1", kDepth) + " }"));
+  EXPECT(IsTooDeep("main() { return 1" + Repeat(" - 1 * 2", kDepth) +
+                   " }"));
+  // chains within the limit are fine
+  EXPECT(ReturnsOnAll("main() { return 1" + Repeat(" + 1", 900) + " }",
+                      901));
+  // 'else if' chains are walked iteratively, so they are not limited
+  std::string chain = "main() { x := input() + " + std::to_string(kDepth);
+  for (std::size_t i = 0; i < kDepth; ++i) {
+    chain += i ? " else if x == " : " if x == ";
+    chain += std::to_string(i) + " { return " + std::to_string(i) + " }";
+  }
+  chain += " else { return -1 } }";
+  EXPECT(ReturnsOnAll(chain, -1));
+  // the limit can be raised, but not beyond 'kMaxDepthLimit'
+  auto limit = Parser::kMaxDepthLimit;
+  EXPECT(IsTooDeep("main() { return 1" + Repeat(" + 1", kDepth) + " }",
+                   kDepth * 2));
+  // expressions that deep are evaluated at the bottom of deep
+  // recursion, where the native stack is about to be exhausted
+  auto half = limit / 2 - 10;
+  EXPECT(ReturnsOnAll("f(x) { return x" + Repeat(" + 1", limit - 10) +
+                      " } g(x) { return " + Repeat("-(", half) + "x" +
+                      Repeat(")", half) + " } "
+                      "deep(n) { if n == 0 { return f(0) + g(1) } "
+                      "return deep(n - 1) + 0 } "
+                      "main() { return deep(30000) }",
+                      static_cast<int>(limit - 10 + 1), limit));
+  return TestResult();
+}
@@ -0,0 +1,35 @@
+#ifndef FIRSTSTEP_TESTS_TEST_H_
+#define FIRSTSTEP_TESTS_TEST_H_
+
+#include <iostream>
+#include <cstddef>
+
+// minimal checking macros of test programs, every test program is
+// an executable which returns non-zero if any of its checks has failed
+
+// count of failed checks
+inline std::size_t &FailedChecks() {
+  static std::size_t failed = 0;
+  return failed;
+}
+
+// check if the condition holds, report the failure and continue if not
+#define EXPECT(cond)                                                  \
+  do {                                                                \
+    if (!(cond)) {                                                    \
+      std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " \
+                << #cond << std::endl;                                \
+      ++FailedChecks();                                               \
+    }                                                                 \
+  } while (0)
+
+// exit code of test programs
+inline int TestResult() {
+  if (FailedChecks()) {
+    std::cerr << FailedChecks() << " checks failed" << std::endl;
+    return 1;
+  }
+  return 0;
+}
+
+#endif  // FIRSTSTEP_TESTS_TEST_H_